@@ -336,6 +336,17 @@ def addCommonOptions(parser):
     parser.add_option("-s", "--standard-switch", action="store", type="int",
         default=None,
         help="switch from timing to Detailed CPU after warmup period of <N>")
+    parser.add_option("--smarts", action="store", type="string",
+        default=None,
+        help="<period,warmup,measure>: every <period> instructions, "
+             "simulate <warmup> then <measure> instructions on --cpu-type, "
+             "and the rest on the atomic CPU to keep caches warm. The CPI "
+             "of the first CPU is estimated from the measured windows.")
+    parser.add_option("--bp-warming", action="store_true", default=False,
+        help="Update the branch predictor of --cpu-type with the atomic "
+             "CPU used to fast forward, restore a checkpoint or warm "
+             "(--smarts), so that it is warm when switching. See "
+             "util/bp_warming_compare.py to measure its effect")
     parser.add_option("-p", "--prog-interval", type="str",
         help="CPU Progress Interval")
 
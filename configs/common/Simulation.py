@@ -83,7 +83,7 @@ def setCPUClass(options):
         if options.restore_with_cpu != options.cpu_type:
             CPUClass = TmpClass
             TmpClass, test_mem_mode = getCPUClass(options.restore_with_cpu)
-    elif options.fast_forward:
+    elif options.fast_forward or options.smarts:
         CPUClass = TmpClass
         TmpClass = AtomicSimpleCPU
         test_mem_mode = 'atomic'
@@ -431,6 +431,92 @@ def repeatSwitch(testsys, repeat_switch_cpu_list, maxtick, switch_freq):
             exit_event = m5.simulate(maxtick - m5.curTick())
             return exit_event
 
+def smartsSample(options, testsys, switch_cpu_list, maxtick):
+    """Systematic sampling (SMARTS). Every period, the last warmup and
+    measure instructions are simulated on the detailed CPUs, and the
+    others on the atomic CPUs, which keep the caches warm (functional
+    warming). The CPI of the first CPU is measured in every window,
+    which gives an estimate of its CPI with a confidence interval.
+
+    CPUs are switched without resetting or dumping stats, and the
+    switch to the detailed CPUs only needs a trivial drain, as the
+    atomic CPUs have no outstanding requests."""
+
+    import math
+
+    period, warmup, measure = [int(x) for x in options.smarts.split(",")]
+    if measure <= 0 or warmup < 0 or warmup + measure > period:
+        fatal("Bad --smarts=%s, the warmup and measured windows must fit "
+              "in the period" % options.smarts)
+    warming = period - warmup - measure
+
+    # The CPI is measured in cycles of the first CPU
+    clock = testsys.cpu[0].clk_domain.clock[0].getValue()
+    detailed_list = switch_cpu_list
+    warming_list = [(new_cpu, old_cpu) for old_cpu, new_cpu in
+                    switch_cpu_list]
+
+    def simulateInsts(cpu, insts, cause):
+        if insts > 0:
+            cpu.scheduleInstStop(0, insts, cause)
+            exit_event = m5.simulate(maxtick - m5.curTick())
+            while exit_event.getCause() == "checkpoint":
+                exit_event = m5.simulate(maxtick - m5.curTick())
+            if exit_event.getCause() != cause:
+                return exit_event
+        return None
+
+    print("SMARTS sampling: period %d, warmup %d, measure %d" %
+          (period, warmup, measure))
+    if options.fast_forward:
+        # max_insts_any_thread of the atomic CPUs is the fast forward
+        exit_event = m5.simulate(maxtick - m5.curTick())
+        if exit_event.getCause() != \
+                "a thread reached the max instruction count":
+            return exit_event
+
+    cpis = []
+    while True:
+        exit_event = simulateInsts(warming_list[0][1], warming,
+                                   "smarts warming")
+        if exit_event is not None:
+            break
+
+        m5.switchCpus(testsys, detailed_list, verbose=False)
+        detailed_cpu = detailed_list[0][1]
+        exit_event = simulateInsts(detailed_cpu, warmup, "smarts warmup")
+        if exit_event is not None:
+            break
+
+        start = m5.curTick()
+        exit_event = simulateInsts(detailed_cpu, measure, "smarts measure")
+        if exit_event is not None:
+            break
+        cycles = float(m5.curTick() - start) / clock
+        cpis.append(cycles / measure)
+
+        m5.switchCpus(testsys, warming_list, verbose=False)
+
+    n = len(cpis)
+    if n == 0:
+        warn("SMARTS sampling ended before measuring a window")
+        return exit_event
+
+    mean = sum(cpis) / n
+    variance = sum((x - mean) ** 2 for x in cpis) / (n - 1) if n > 1 else 0
+    # 95% confidence interval, assuming the mean is normally distributed
+    error = 1.96 * math.sqrt(variance / n)
+    with open(joinpath(m5.options.outdir, "smarts.txt"), "w") as f:
+        for i, cpi in enumerate(cpis):
+            print("%d %f" % (i, cpi), file=f)
+    print("SMARTS: CPI %f +/- %f (95%% confidence, %d windows, %.2f%%)" %
+          (mean, error, n, 100 * error / mean))
+    if n < 30:
+        warn("Only %d SMARTS windows were measured, the confidence "
+             "interval may be inaccurate", n)
+
+    return exit_event
+
 def run(options, root, testsys, cpu_class):
     if options.checkpoint_dir:
         cptdir = options.checkpoint_dir
@@ -451,6 +537,15 @@ def run(options, root, testsys, cpu_class):
     if options.repeat_switch and options.take_checkpoints:
         fatal("Can't specify both --repeat-switch and --take-checkpoints")
 
+    if options.smarts and (options.standard_switch or options.repeat_switch
+                           or options.take_checkpoints
+                           or options.checkpoint_restore != None):
+        fatal("Can't specify --smarts with --standard-switch, "
+              "--repeat-switch or checkpoints")
+
+    if options.smarts and not cpu_class:
+        fatal("--smarts requires a --cpu-type other than the atomic CPU")
+
     np = options.num_cpus
     switch_cpus = None
 
@@ -489,6 +584,15 @@ def run(options, root, testsys, cpu_class):
                     options.indirect_bp_type)
                 switch_cpus[i].branchPred.indirectBranchPred = \
                     IndirectBPClass()
+            if options.bp_warming:
+                if not isinstance(testsys.cpu[i], BaseSimpleCPU):
+                    fatal("--bp-warming requires a simple CPU to fast "
+                          "forward or restore checkpoints")
+                # The switch CPU owns the predictor, which keeps the
+                # names of its stats, and the simple CPU updates it.
+                branch_pred = switch_cpus[i].branchPred
+                switch_cpus[i].branchPred = branch_pred
+                testsys.cpu[i].branchPred = branch_pred
 
         # If elastic tracing is enabled attach the elastic trace probe
         # to the switch CPUs
@@ -657,7 +761,7 @@ def run(options, root, testsys, cpu_class):
         fatal("Bad maxtick (%d) specified: " \
               "Checkpoint starts starts from tick: %d", maxtick, cpt_starttick)
 
-    if options.standard_switch or cpu_class:
+    if options.standard_switch or (cpu_class and not options.smarts):
         if options.standard_switch:
             print("Switch at instruction count:%s" %
                     str(testsys.cpu[0].max_insts_any_thread))
@@ -714,6 +818,9 @@ def run(options, root, testsys, cpu_class):
     elif options.restore_simpoint_checkpoint != None:
         restoreSimpointCheckpoint()
 
+    elif options.smarts:
+        exit_event = smartsSample(options, testsys, switch_cpu_list, maxtick)
+
     else:
         if options.fast_forward:
             m5.stats.reset()
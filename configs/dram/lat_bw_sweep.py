@@ -0,0 +1,198 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from __future__ import print_function
+from __future__ import absolute_import
+
+import optparse
+import os
+import sys
+
+import m5
+from m5.objects import *
+from m5.util import addToPath, fatal
+
+addToPath('../')
+
+from common import ObjectList
+from common import MemConfig
+
+# This script produces the latency-bandwidth curve of a memory system
+# in a single simulation. A closed-loop traffic generator, i.e. one
+# with a bounded number of outstanding requests, injects requests at
+# a rate that increases phase by phase, from the maximum to the
+# minimum time between two requests, in geometric steps. Every phase
+# starts with a warmup, after which the stats are reset, and ends with
+# a stats dump, so that stats.txt holds one dump per phase. The phases
+# of the generator only drift from the measurement windows by the time
+# the generator waits for a retry at the end of a phase. The
+# achieved bandwidth and average latency of every phase are written
+# to lat_bw_sweep.csv in the output directory.
+
+parser = optparse.OptionParser()
+
+parser.add_option("--mem-type", type="choice", default="DDR3_1600_8x8",
+                  choices=ObjectList.mem_list.get_names(),
+                  help = "type of memory to use")
+parser.add_option("--mem-channels", type="int", default=1,
+                  help = "number of memory channels")
+parser.add_option("--mem-size", type="string", default="256MB",
+                  help = "size of the memory")
+
+parser.add_option("--mode", type="choice", default="random",
+                  choices=["linear", "random"],
+                  help = "address pattern of the requests")
+parser.add_option("--rd_perc", type="int", default=100,
+                  help = "percentage of read commands")
+parser.add_option("--max-outstanding", type="int", default=32,
+                  help = "maximum number of outstanding requests, 0 for "
+                  "an open loop")
+
+parser.add_option("--max-itt", type="string", default="100ns",
+                  help = "time between two requests of the first phase")
+parser.add_option("--min-itt", type="string", default="1ns",
+                  help = "time between two requests of the last phase")
+parser.add_option("--steps", type="int", default=20,
+                  help = "number of phases")
+parser.add_option("--warmup", type="string", default="10us",
+                  help = "time spent warming up at the start of a phase")
+parser.add_option("--phase", type="string", default="50us",
+                  help = "time measured in every phase, after the warmup")
+
+(options, args) = parser.parse_args()
+
+if args:
+    print("Error: script doesn't take any positional arguments")
+    sys.exit(1)
+
+def to_ticks(latency):
+    return m5.ticks.fromSeconds(m5.util.convert.anyToLatency(latency))
+
+def to_ns(ticks):
+    return ticks * 1e9 / m5.ticks.fromSeconds(1.0)
+
+if options.steps < 1:
+    fatal("At least one phase is needed")
+
+# a wide crossbar, so that the memory is the bottleneck
+system = System(membus = IOXBar(width = 64))
+system.clk_domain = SrcClockDomain(clock = '2.0GHz',
+                                   voltage_domain =
+                                   VoltageDomain(voltage = '1V'))
+
+mem_range = AddrRange(options.mem_size)
+system.mem_ranges = [mem_range]
+
+# do not worry about reserving space for the backing store
+system.mmap_using_noreserve = True
+
+options.external_memory_system = 0
+options.tlm_memory = 0
+options.elastic_trace_en = 0
+MemConfig.config_mem(options, system)
+
+# there is no point slowing things down by saving any data
+for ctrl in system.mem_ctrls:
+    ctrl.null = True
+
+system.tgen = PyTrafficGen(max_outstanding_reqs = options.max_outstanding)
+
+# connect the traffic generator to the bus via a communication monitor
+# that also reports the latency percentiles of every phase
+system.monitor = CommMonitor(hdr_bits = 7)
+system.tgen.port = system.monitor.slave
+system.monitor.master = system.membus.slave
+
+# connect the system port even if it is not used in this example
+system.system_port = system.membus.slave
+
+root = Root(full_system = False, system = system)
+root.system.mem_mode = 'timing'
+
+m5.instantiate()
+
+block_size = system.cache_line_size.value
+warmup = to_ticks(options.warmup)
+phase = to_ticks(options.phase)
+max_itt = to_ticks(options.max_itt)
+min_itt = to_ticks(options.min_itt)
+if min_itt > max_itt:
+    fatal("The minimum ITT is larger than the maximum ITT")
+
+# the ITTs of the phases, from the lowest to the highest load
+if options.steps > 1:
+    ratio = (float(min_itt) / max_itt) ** (1.0 / (options.steps - 1))
+else:
+    ratio = 1.0
+itts = [ max(1, int(round(max_itt * ratio ** i)))
+         for i in range(options.steps) ]
+
+def phases():
+    create = system.tgen.createLinear if options.mode == "linear" else \
+        system.tgen.createRandom
+    for itt in itts:
+        yield create(warmup + phase, 0, mem_range.end, block_size, itt, itt,
+                     options.rd_perc, 0)
+    yield system.tgen.createExit(0)
+
+system.tgen.start(phases())
+
+tgen = system.tgen.getCCObject()
+def stat(name):
+    return tgen.resolveStat(name).value
+
+csv_name = os.path.join(m5.options.outdir, "lat_bw_sweep.csv")
+with open(csv_name, "w") as csv:
+    print("itt_ns,offered_bw_gbps,read_bw_gbps,write_bw_gbps,"
+          "avg_read_lat_ns,avg_write_lat_ns", file=csv)
+    print("%10s %14s %14s %14s" % ("ITT (ns)", "offered GB/s",
+                                   "achieved GB/s", "avg lat (ns)"))
+
+    for itt in itts:
+        m5.simulate(warmup)
+        m5.stats.reset()
+        m5.simulate(phase)
+
+        # bytes per ns are GB/s
+        reads = stat("totalReads")
+        writes = stat("totalWrites")
+        read_bw = stat("bytesRead") / to_ns(phase)
+        write_bw = stat("bytesWritten") / to_ns(phase)
+        read_lat = to_ns(stat("totalReadLatency") / reads) if reads else 0
+        write_lat = to_ns(stat("totalWriteLatency") / writes) if writes else 0
+        offered_bw = block_size / to_ns(itt)
+
+        print("%g,%g,%g,%g,%g,%g" % (to_ns(itt), offered_bw, read_bw,
+                                     write_bw, read_lat, write_lat),
+              file=csv)
+        lat = (read_lat * reads + write_lat * writes) / (reads + writes) \
+            if reads + writes else 0
+        print("%10.3f %14.3f %14.3f %14.1f" % (to_ns(itt), offered_bw,
+                                               read_bw + write_bw, lat))
+
+        m5.stats.dump()
+
+print("Latency-bandwidth curve written to %s" % csv_name)
@@ -0,0 +1,144 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from __future__ import print_function
+from __future__ import absolute_import
+
+import optparse
+import sys
+
+import m5
+from m5.objects import *
+from m5.util import addToPath, fatal, inform
+
+addToPath('../')
+
+from common import ObjectList
+from common import MemConfig
+
+# This script measures the bandwidth and latency a multi-channel
+# memory system sustains under the load of many independent streams of
+# requests, all driven by a single MultiStreamTrafficGen. The memory
+# is split in as many contiguous ranges as there are streams, and
+# every stream accesses its own range with the given pattern and rate.
+
+parser = optparse.OptionParser()
+
+parser.add_option("--mem-type", type="choice", default="DDR4_2400_8x8",
+                  choices=ObjectList.mem_list.get_names(),
+                  help = "type of memory to use")
+parser.add_option("--mem-channels", type="int", default=4,
+                  help = "number of memory channels")
+parser.add_option("--mem-size", type="string", default="1GB",
+                  help = "size of the memory")
+
+parser.add_option("--streams", type="int", default=16,
+                  help = "number of streams of requests")
+parser.add_option("--pattern", type="choice", default="random",
+                  choices=TrafficStreamPattern.vals,
+                  help = "address pattern of the streams")
+parser.add_option("--rd_perc", type="int", default=100,
+                  help = "percentage of read commands")
+parser.add_option("--period", type="string", default="10ns",
+                  help = "time between two requests of a stream")
+parser.add_option("--max-outstanding", type="int", default=16,
+                  help = "maximum number of outstanding requests of a "
+                  "stream, 0 for no limit")
+parser.add_option("--sim-time", type="string", default="100us",
+                  help = "simulated time")
+
+(options, args) = parser.parse_args()
+
+if args:
+    print("Error: script doesn't take any positional arguments")
+    sys.exit(1)
+
+if options.streams < 1:
+    fatal("At least one stream is needed")
+
+# a wide crossbar, so that the memory channels are the bottleneck
+system = System(membus = IOXBar(width = 64))
+system.clk_domain = SrcClockDomain(clock = '2.0GHz',
+                                   voltage_domain =
+                                   VoltageDomain(voltage = '1V'))
+
+mem_range = AddrRange(options.mem_size)
+system.mem_ranges = [mem_range]
+
+# do not worry about reserving space for the backing store
+system.mmap_using_noreserve = True
+
+options.external_memory_system = 0
+options.tlm_memory = 0
+options.elastic_trace_en = 0
+MemConfig.config_mem(options, system)
+
+# there is no point slowing things down by saving any data
+for ctrl in system.mem_ctrls:
+    ctrl.null = True
+
+# give every stream a contiguous part of the memory
+block_size = system.cache_line_size.value
+stream_size = (mem_range.size() // options.streams) // block_size * \
+    block_size
+if stream_size == 0:
+    fatal("The memory is too small for %d streams" % options.streams)
+
+streams = [ TrafficStream(pattern = options.pattern,
+                          start_addr = i * stream_size,
+                          end_addr = (i + 1) * stream_size - 1,
+                          block_size = block_size,
+                          min_period = options.period,
+                          max_period = options.period,
+                          read_percent = options.rd_perc,
+                          stream_id = i,
+                          max_outstanding_reqs = options.max_outstanding)
+            for i in range(options.streams) ]
+system.tgen = MultiStreamTrafficGen(streams = streams)
+
+# connect the traffic generator to the bus via a communication monitor
+# reporting the latency percentiles of all the streams
+system.monitor = CommMonitor(hdr_bits = 7)
+system.monitor.master = system.membus.slave
+
+system.tgen.port = system.monitor.slave
+
+# connect the system port even if it is not used in this example
+system.system_port = system.membus.slave
+
+root = Root(full_system = False, system = system)
+root.system.mem_mode = 'timing'
+
+m5.instantiate()
+
+inform("Running %d %s streams on %d %s channels for %s" %
+       (options.streams, options.pattern, options.mem_channels,
+        options.mem_type, options.sim_time))
+
+exit_event = m5.simulate(m5.ticks.fromSeconds(
+    m5.util.convert.anyToLatency(options.sim_time)))
+print("Exiting @ tick %i because %s" %
+      (m5.curTick(), exit_event.getCause()))
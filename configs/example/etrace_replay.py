@@ -40,7 +40,8 @@ from __future__ import absolute_import
 
 import optparse
 
-from m5.util import addToPath, fatal
+import m5
+from m5.util import addToPath, fatal, inform
 
 addToPath('../')
 
@@ -53,6 +54,18 @@ from common.Caches import *
 parser = optparse.OptionParser()
 Options.addCommonOptions(parser)
 
+# The Trace CPUs can be distributed over a number of event queues to
+# replay the traces in parallel, in which case the memory system,
+# including the private caches, is simulated by event queue 0 and the
+# event queues synchronise at the end of every simulation quantum
+parser.add_option("--replay-eventqs", type="int", default=0,
+                  help="Number of event queues, and thus of threads, "
+                  "replaying the Trace CPUs (0 to simulate everything "
+                  "on a single event queue)")
+parser.add_option("--sim-quantum", type="string", default="1us",
+                  help="Simulation quantum for parallel replay, bounding "
+                  "how late the packets crossing event queues can be")
+
 if '--ruby' in sys.argv:
     print("This script does not support Ruby configuration, mainly"
     " because Trace CPU has been tested only with classic memory system")
@@ -70,15 +83,17 @@ if options.cpu_type != "TraceCPU":
     fatal("This is a script for elastic trace replay simulation, use "\
             "--cpu-type=TraceCPU\n");
 
-if options.num_cpus > 1:
-    fatal("This script does not support multi-processor trace replay.\n")
+if options.replay_eventqs < 0:
+    fatal("The number of replay event queues cannot be negative.\n")
 
 # In this case FutureClass will be None as there is not fast forwarding or
 # switching
 (CPUClass, test_mem_mode, FutureClass) = Simulation.setCPUClass(options)
 CPUClass.numThreads = numThreads
 
-system = System(cpu = CPUClass(cpu_id=0),
+np = options.num_cpus
+
+system = System(cpu = [CPUClass(cpu_id=i) for i in range(np)],
                 mem_mode = test_mem_mode,
                 mem_ranges = [AddrRange(options.mem_size)],
                 cache_line_size = options.cacheline_size)
@@ -110,9 +125,15 @@ for cpu in system.cpu:
 for cpu in system.cpu:
     cpu.createThreads()
 
-# Assign input trace files to the Trace CPU
-system.cpu.instTraceFile=options.inst_trace_file
-system.cpu.dataTraceFile=options.data_trace_file
+# Assign input trace files to the Trace CPUs. With multiple Trace CPUs,
+# a '%d' in the file names is replaced by the index of the CPU, and
+# otherwise all CPUs replay the same traces
+def trace_file(name, i):
+    return name % i if '%d' in name else name
+
+for i, cpu in enumerate(system.cpu):
+    cpu.instTraceFile = trace_file(options.inst_trace_file, i)
+    cpu.dataTraceFile = trace_file(options.data_trace_file, i)
 
 # Configure the classic memory system options
 MemClass = Simulation.setMemClass(options)
@@ -121,5 +142,32 @@ system.system_port = system.membus.slave
 CacheConfig.config_cache(options, system)
 MemConfig.config_mem(options, system)
 
+# Distribute the Trace CPUs over the replay event queues, round robin.
+# The memory system stays on event queue 0, as the caches snoop each
+# other, and a bridge is spliced between every CPU and its L1 caches,
+# or the memory bus without caches, to synchronise the event queues.
+# The packets crossing the bridges are delivered at the tick they are
+# sent, unless the other side has already gone past it, and the bridge
+# stats report how many packets were late. A shorter quantum makes
+# them less frequent, at the cost of more frequent synchronisation.
+if options.replay_eventqs > 0:
+    for i, cpu in enumerate(system.cpu):
+        cpu.eventq_index = 1 + i % options.replay_eventqs
+        for obj in cpu.descendants():
+            if isinstance(obj, (BaseCache, BaseXBar)):
+                obj.eventq_index = 0
+        for port in ['icache_port', 'dcache_port']:
+            bridge = EventQueueBridge(mem_side_eventq_index = 0)
+            setattr(cpu, port + '_bridge', bridge)
+            getattr(cpu, port).splice(bridge.slave, bridge.master)
+
 root = Root(full_system = False, system = system)
+
+if options.replay_eventqs > 0:
+    inform("Replaying %d Trace CPUs on %d event queues with a %s "
+           "simulation quantum." % (np, options.replay_eventqs,
+                                    options.sim_quantum))
+    m5.ticks.fixGlobalFrequency()
+    root.sim_quantum = m5.ticks.fromSeconds(
+        m5.util.convert.anyToLatency(options.sim_quantum))
 Simulation.run(options, root, system, FutureClass)
@@ -0,0 +1,464 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/binary_inifile.hh"
+
+#include <cstring>
+#include <sstream>
+
+#include "base/str.hh"
+
+using namespace std;
+
+namespace BinaryIni {
+
+const char magic[8] = {'g', 'e', 'm', '5', 'c', 'p', 't', 'b'};
+
+/**
+ * Header of a binary ini file. The index offset and number of
+ * sections are filled in when the file is closed.
+ */
+struct FileHeader
+{
+    char magic[8];
+    uint64_t version;
+    uint64_t indexOffset;
+    uint64_t numSections;
+};
+
+/** Append a plain value to a buffer. */
+template <class T>
+static void
+appendValue(string &buf, const T &value)
+{
+    buf.append((const char *)&value, sizeof(value));
+}
+
+/** Append a string to a buffer, preceded by its size. */
+static void
+appendString(string &buf, const string &str)
+{
+    appendValue(buf, (uint32_t)str.size());
+    buf.append(str);
+}
+
+/** Read a plain value from a buffer, advancing the position. */
+template <class T>
+static bool
+readValue(const string &buf, size_t &pos, T &value)
+{
+    if (buf.size() - pos < sizeof(value))
+        return false;
+    memcpy(&value, buf.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+/** Read a string preceded by its size from a buffer. */
+static bool
+readString(const string &buf, size_t &pos, string &str, uint64_t size)
+{
+    if (buf.size() - pos < size)
+        return false;
+    str.assign(buf, pos, size);
+    pos += size;
+    return true;
+}
+
+} // namespace BinaryIni
+
+using namespace BinaryIni;
+
+BinaryIniWriter::LineBuf::int_type
+BinaryIniWriter::LineBuf::overflow(int_type c)
+{
+    if (c != traits_type::eof()) {
+        char ch = traits_type::to_char_type(c);
+        xsputn(&ch, 1);
+    }
+    return traits_type::not_eof(c);
+}
+
+streamsize
+BinaryIniWriter::LineBuf::xsputn(const char *s, streamsize n)
+{
+    const char *end = s + n;
+    while (s != end) {
+        const char *eol = (const char *)memchr(s, '\n', end - s);
+        if (!eol) {
+            writer.pendingLine.append(s, end);
+            break;
+        }
+        writer.pendingLine.append(s, eol);
+        writer.parseLine(writer.pendingLine);
+        writer.pendingLine.clear();
+        s = eol + 1;
+    }
+    return n;
+}
+
+BinaryIniWriter::BinaryIniWriter(const string &filename)
+    : ostream(nullptr), lineBuf(*this),
+      file(filename.c_str(), ios::out | ios::binary | ios::trunc),
+      inSection(false)
+{
+    rdbuf(&lineBuf);
+
+    // the header is written again with the location of the index
+    // when the file is closed
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    file.write((const char *)&header, sizeof(header));
+}
+
+BinaryIniWriter::~BinaryIniWriter()
+{
+    close();
+}
+
+void
+BinaryIniWriter::parseLine(const string &line)
+{
+    string text(line);
+    eat_white(text);
+    if (text.empty())
+        return;
+
+    if (text.front() == '[' && text.back() == ']') {
+        string name = text.substr(1, text.size() - 2);
+        eat_white(name);
+        startSection(name);
+        return;
+    }
+
+    // as for ".ini" files, lines outside of sections and lines that
+    // are not assignments are ignored
+    string::size_type offset = text.find('=');
+    if (!inSection || offset == string::npos || offset == 0)
+        return;
+
+    bool append = text[offset - 1] == '+';
+    string name = text.substr(0, append ? offset - 1 : offset);
+    string value = text.substr(offset + 1);
+    eat_white(name);
+    eat_white(value);
+
+    addEntry(name, append ? TextAppend : Text, value.data(), value.size());
+}
+
+void
+BinaryIniWriter::startSection(const string &name)
+{
+    if (inSection) {
+        index.push_back(IndexEntry{curSection, (uint64_t)file.tellp(),
+                                   curEntries.size()});
+        file.write(curEntries.data(), curEntries.size());
+    }
+
+    curSection = name;
+    curEntries.clear();
+    inSection = true;
+}
+
+void
+BinaryIniWriter::addEntry(const string &name, EntryType type,
+                          const char *value, uint64_t size)
+{
+    appendString(curEntries, name);
+    appendValue(curEntries, type);
+    appendValue(curEntries, size);
+    curEntries.append(value, size);
+}
+
+void
+BinaryIniWriter::addRaw(const string &name, RawKind kind, const void *data,
+                        uint8_t elem_size, uint64_t count)
+{
+    // process any incomplete line first to keep the entries in order
+    if (!pendingLine.empty()) {
+        parseLine(pendingLine);
+        pendingLine.clear();
+    }
+
+    if (!inSection)
+        return;
+
+    RawHeader header{kind, elem_size};
+    const uint64_t data_size = elem_size * count;
+    appendString(curEntries, name);
+    appendValue(curEntries, Raw);
+    appendValue(curEntries, (uint64_t)(sizeof(header) + data_size));
+    appendValue(curEntries, header);
+    curEntries.append((const char *)data, data_size);
+}
+
+bool
+BinaryIniWriter::close()
+{
+    if (!file.is_open())
+        return false;
+
+    if (!pendingLine.empty()) {
+        parseLine(pendingLine);
+        pendingLine.clear();
+    }
+    startSection("");
+    inSection = false;
+
+    FileHeader header;
+    memcpy(header.magic, BinaryIni::magic, sizeof(header.magic));
+    header.version = BinaryIni::version;
+    header.indexOffset = file.tellp();
+    header.numSections = index.size();
+
+    string index_buf;
+    for (const auto &entry : index) {
+        appendString(index_buf, entry.name);
+        appendValue(index_buf, entry.offset);
+        appendValue(index_buf, entry.size);
+    }
+    file.write(index_buf.data(), index_buf.size());
+
+    file.seekp(0);
+    file.write((const char *)&header, sizeof(header));
+
+    bool good = file.good();
+    file.close();
+    return good;
+}
+
+bool
+BinaryIniFile::load(const string &filename)
+{
+    file.open(filename.c_str(), ios::in | ios::binary);
+    if (!file.is_open())
+        return false;
+
+    FileHeader header;
+    if (!file.read((char *)&header, sizeof(header)) ||
+        memcmp(header.magic, BinaryIni::magic, sizeof(header.magic)) ||
+        header.version != BinaryIni::version) {
+        return false;
+    }
+
+    file.seekg(0, ios::end);
+    uint64_t file_size = file.tellg();
+    if (header.indexOffset > file_size)
+        return false;
+
+    string index_buf(file_size - header.indexOffset, '\0');
+    file.seekg(header.indexOffset);
+    if (!file.read(&index_buf[0], index_buf.size()))
+        return false;
+
+    // sections can appear more than once, in which case their
+    // entries are merged when they are read
+    size_t pos = 0;
+    for (uint64_t i = 0; i < header.numSections; ++i) {
+        uint32_t name_size;
+        string name;
+        uint64_t offset, size;
+        if (!readValue(index_buf, pos, name_size) ||
+            !readString(index_buf, pos, name, name_size) ||
+            !readValue(index_buf, pos, offset) ||
+            !readValue(index_buf, pos, size) ||
+            offset + size > header.indexOffset) {
+            return false;
+        }
+        index[name].emplace_back(offset, size);
+    }
+
+    return true;
+}
+
+const BinaryIniFile::Section *
+BinaryIniFile::findSection(const string &section) const
+{
+    auto cached = sections.find(section);
+    if (cached != sections.end())
+        return &cached->second;
+
+    auto location = index.find(section);
+    if (location == index.end())
+        return nullptr;
+
+    Section &sec = sections[section];
+    for (const auto &part : location->second) {
+        string buf(part.second, '\0');
+        file.clear();
+        file.seekg(part.first);
+        file.read(&buf[0], buf.size());
+
+        size_t pos = 0;
+        while (pos < buf.size()) {
+            uint32_t name_size;
+            string name;
+            EntryType type;
+            uint64_t value_size;
+            string value;
+            if (!readValue(buf, pos, name_size) ||
+                !readString(buf, pos, name, name_size) ||
+                !readValue(buf, pos, type) ||
+                !readValue(buf, pos, value_size) ||
+                !readString(buf, pos, value, value_size)) {
+                break;
+            }
+
+            auto existing = sec.find(name);
+            if (type == TextAppend && existing != sec.end() &&
+                existing->second.type != Raw) {
+                existing->second.value += " " + value;
+            } else {
+                sec[name] = Entry{type == Raw ? Raw : Text, value};
+            }
+        }
+    }
+
+    return &sec;
+}
+
+const BinaryIniFile::Entry *
+BinaryIniFile::findEntry(const string &section, const string &entry) const
+{
+    const Section *sec = findSection(section);
+    if (!sec)
+        return nullptr;
+
+    auto it = sec->find(entry);
+    return it == sec->end() ? nullptr : &it->second;
+}
+
+bool
+BinaryIniFile::find(const string &section, const string &entry,
+                    string &value) const
+{
+    const Entry *e = findEntry(section, entry);
+    if (!e)
+        return false;
+
+    if (e->type == Raw)
+        return rawToText(e->value, value);
+
+    value = e->value;
+    return true;
+}
+
+bool
+BinaryIniFile::findRaw(const string &section, const string &entry,
+                       string &value) const
+{
+    const Entry *e = findEntry(section, entry);
+    if (!e || e->type != Raw)
+        return false;
+
+    value = e->value;
+    return true;
+}
+
+bool
+BinaryIniFile::entryExists(const string &section, const string &entry) const
+{
+    return findEntry(section, entry) != nullptr;
+}
+
+bool
+BinaryIniFile::sectionExists(const string &section) const
+{
+    return index.find(section) != index.end();
+}
+
+void
+BinaryIniFile::getSectionNames(vector<string> &list) const
+{
+    for (const auto &sec : index)
+        list.push_back(sec.first);
+}
+
+/** Format the elements of a raw array of a given type. */
+template <class T, class Show = T>
+static void
+formatRaw(ostringstream &os, const char *data, uint64_t count)
+{
+    for (uint64_t i = 0; i < count; ++i) {
+        T value;
+        memcpy(&value, data + i * sizeof(T), sizeof(T));
+        if (i)
+            os << " ";
+        os << (Show)value;
+    }
+}
+
+bool
+BinaryIniFile::rawToText(const string &raw, string &text)
+{
+    RawHeader header;
+    if (raw.size() < sizeof(header))
+        return false;
+    memcpy(&header, raw.data(), sizeof(header));
+
+    const char *data = raw.data() + sizeof(header);
+    const uint64_t data_size = raw.size() - sizeof(header);
+    if (header.elemSize == 0 || data_size % header.elemSize)
+        return false;
+    const uint64_t count = data_size / header.elemSize;
+
+    ostringstream os;
+    os.precision(17);
+    switch (header.kind) {
+      case Signed:
+        switch (header.elemSize) {
+          case 1: formatRaw<int8_t, int>(os, data, count); break;
+          case 2: formatRaw<int16_t>(os, data, count); break;
+          case 4: formatRaw<int32_t>(os, data, count); break;
+          case 8: formatRaw<int64_t>(os, data, count); break;
+          default: return false;
+        }
+        break;
+      case Unsigned:
+        switch (header.elemSize) {
+          case 1: formatRaw<uint8_t, unsigned>(os, data, count); break;
+          case 2: formatRaw<uint16_t>(os, data, count); break;
+          case 4: formatRaw<uint32_t>(os, data, count); break;
+          case 8: formatRaw<uint64_t>(os, data, count); break;
+          default: return false;
+        }
+        break;
+      case Float:
+        switch (header.elemSize) {
+          case 4: formatRaw<float>(os, data, count); break;
+          case 8: formatRaw<double>(os, data, count); break;
+          default: return false;
+        }
+        break;
+      default:
+        return false;
+    }
+
+    text = os.str();
+    return true;
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BASE_BINARY_INIFILE_HH__
+#define __BASE_BINARY_INIFILE_HH__
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ * A binary, sectioned and indexed equivalent of the ".ini" files
+ * used for checkpoints.
+ *
+ * A file starts with a header, followed by the sections, and ends
+ * with an index giving the name, offset and size of every
+ * section. The index lets a reader load the sections it needs on
+ * demand instead of parsing the whole file. Each section is a list
+ * of entries, each with a name, a type and a value. Text entries
+ * hold the same strings as an ".ini" file would, while raw entries
+ * hold arrays of numbers in their host representation. All fields
+ * are in host byte order.
+ */
+
+namespace BinaryIni {
+
+/** Magic string at the start of a binary ini file. */
+extern const char magic[8];
+
+/** Current version of the format. */
+const uint64_t version = 1;
+
+/** The type of an entry. */
+enum EntryType : uint8_t
+{
+    /** A text value, as in an ".ini" file. */
+    Text = 0,
+    /** An array of numbers, see RawHeader. */
+    Raw = 1,
+    /** A text value appended to any previous value ("+="). */
+    TextAppend = 2,
+};
+
+/**
+ * The kinds of numbers in a raw entry.
+ */
+enum RawKind : uint8_t
+{
+    Signed = 'i',
+    Unsigned = 'u',
+    Float = 'f',
+};
+
+/**
+ * Header at the start of the value of a raw entry, followed by the
+ * elements of the array.
+ */
+struct RawHeader
+{
+    RawKind kind;
+    uint8_t elemSize;
+};
+
+} // namespace BinaryIni
+
+/**
+ * Writer of binary ini files.
+ *
+ * The writer is an output stream, so that everything written in the
+ * ".ini" syntax (section headers, key=value lines and comments) is
+ * stored in the binary file with the same meaning. Arrays of numbers
+ * can in addition be stored directly as raw entries, which avoids
+ * formatting them as text.
+ */
+class BinaryIniWriter : public std::ostream
+{
+  private:
+    /**
+     * Stream buffer collecting the text written to the writer, which
+     * is split in lines and parsed as it is written.
+     */
+    class LineBuf : public std::streambuf
+    {
+      public:
+        LineBuf(BinaryIniWriter &writer) : writer(writer) {}
+
+      protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char *s, std::streamsize n) override;
+
+      private:
+        BinaryIniWriter &writer;
+    };
+
+    LineBuf lineBuf;
+
+    /** The file being written. */
+    std::ofstream file;
+
+    /** Text written since the last complete line. */
+    std::string pendingLine;
+
+    /** Name of the section currently being written. */
+    std::string curSection;
+
+    /** Entries of the section currently being written. */
+    std::string curEntries;
+
+    /** Whether a section is currently being written. */
+    bool inSection;
+
+    /** Name, offset and size of every section written so far. */
+    struct IndexEntry
+    {
+        std::string name;
+        uint64_t offset;
+        uint64_t size;
+    };
+    std::vector<IndexEntry> index;
+
+    /** Parse a line of text written to the stream. */
+    void parseLine(const std::string &line);
+
+    /** Write the current section to the file and start a new one. */
+    void startSection(const std::string &name);
+
+    /** Add an entry to the current section. */
+    void addEntry(const std::string &name, BinaryIni::EntryType type,
+                  const char *value, uint64_t size);
+
+  public:
+    /**
+     * Create a binary ini file.
+     *
+     * @param filename The path of the file to create
+     */
+    BinaryIniWriter(const std::string &filename);
+
+    ~BinaryIniWriter();
+
+    /** Whether the file was successfully opened. */
+    bool is_open() const { return file.is_open(); }
+
+    /**
+     * Add an array of numbers to the current section as a raw
+     * entry. Any text written before is processed first, so raw and
+     * text entries can be interleaved freely.
+     *
+     * @param name Name of the entry
+     * @param kind Kind of the numbers in the array
+     * @param data Pointer to the first element
+     * @param elem_size Size of each element in bytes
+     * @param count Number of elements
+     */
+    void addRaw(const std::string &name, BinaryIni::RawKind kind,
+                const void *data, uint8_t elem_size, uint64_t count);
+
+    /**
+     * Write the remaining sections and the index, and close the
+     * file. This is also done by the destructor.
+     *
+     * @retval True if the file was written successfully.
+     */
+    bool close();
+};
+
+/**
+ * Reader of binary ini files.
+ *
+ * Only the index is read when the file is loaded, and the sections
+ * are read and parsed the first time they are accessed.
+ */
+class BinaryIniFile
+{
+  private:
+    struct Entry
+    {
+        BinaryIni::EntryType type;
+        std::string value;
+    };
+
+    typedef std::unordered_map<std::string, Entry> Section;
+
+    /** Location in the file of the parts of a section. */
+    typedef std::vector<std::pair<uint64_t, uint64_t>> SectionLocation;
+
+    mutable std::ifstream file;
+
+    /** Location of every section in the file. */
+    std::unordered_map<std::string, SectionLocation> index;
+
+    /** Sections read so far. */
+    mutable std::unordered_map<std::string, Section> sections;
+
+    /**
+     * Find a section, reading it from the file if needed.
+     *
+     * @retval Pointer to the section, or nullptr if not found.
+     */
+    const Section *findSection(const std::string &section) const;
+
+    /** Find an entry in a section. */
+    const Entry *findEntry(const std::string &section,
+                           const std::string &entry) const;
+
+  public:
+    /**
+     * Load the index of a binary ini file.
+     *
+     * @param file The path of the file to load.
+     * @retval True if successful, false if errors were encountered.
+     */
+    bool load(const std::string &file);
+
+    /**
+     * Find the value of an entry. Raw entries are formatted as a
+     * space separated list of numbers, as they would appear in an
+     * ".ini" file.
+     *
+     * @retval True if found, false if not.
+     */
+    bool find(const std::string &section, const std::string &entry,
+              std::string &value) const;
+
+    /**
+     * Find the value of a raw entry, including its RawHeader.
+     *
+     * @retval True if found and raw, false if not.
+     */
+    bool findRaw(const std::string &section, const std::string &entry,
+                 std::string &value) const;
+
+    /** Determine whether an entry exists in a section. */
+    bool entryExists(const std::string &section,
+                     const std::string &entry) const;
+
+    /** Determine whether a section exists. */
+    bool sectionExists(const std::string &section) const;
+
+    /** Push all section names into the given vector. */
+    void getSectionNames(std::vector<std::string> &list) const;
+
+    /**
+     * Format the value of a raw entry as a space separated list of
+     * numbers.
+     *
+     * @retval True if successful, false if the value is malformed.
+     */
+    static bool rawToText(const std::string &raw, std::string &text);
+};
+
+#endif // __BASE_BINARY_INIFILE_HH__
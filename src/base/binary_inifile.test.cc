@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "base/binary_inifile.hh"
+
+using namespace std;
+
+namespace {
+
+const string cptFile = "binary_inifile.test.bin";
+
+void
+writeTestFile()
+{
+    BinaryIniWriter writer(cptFile);
+    ASSERT_TRUE(writer.is_open());
+
+    writer << "## header comment, ignored\n";
+    writer << "\n[General]\n";
+    writer << "Test1=BARasdf\n";
+    writer << "   Test2  =  bar  \n";
+
+    const vector<uint32_t> words = {1, 2, 300000};
+    writer.addRaw("Words", BinaryIni::Unsigned, words.data(),
+                  sizeof(uint32_t), words.size());
+    writer << "Test3=89\n";
+
+    writer << "\n[Junk]\n";
+    writer << "Test4=mama\n";
+    const int8_t bytes[] = {-1, 2};
+    writer.addRaw("Bytes", BinaryIni::Signed, bytes, 1, 2);
+    const double doubles[] = {0.5, -2.25};
+    writer.addRaw("Doubles", BinaryIni::Float, doubles, sizeof(double), 2);
+
+    writer << "\n[General]\n";
+    writer << "Test4=42\n";
+    writer << "\n[Junk]\n";
+    writer << "Test4+=mia";
+
+    ASSERT_TRUE(writer.close());
+}
+
+} // anonymous namespace
+
+TEST(BinaryIniTest, TextEntries)
+{
+    writeTestFile();
+
+    BinaryIniFile cpt;
+    ASSERT_TRUE(cpt.load(cptFile));
+
+    string value;
+    ASSERT_TRUE(cpt.find("General", "Test1", value));
+    EXPECT_EQ("BARasdf", value);
+    ASSERT_TRUE(cpt.find("General", "Test2", value));
+    EXPECT_EQ("bar", value);
+    ASSERT_TRUE(cpt.find("General", "Test3", value));
+    EXPECT_EQ("89", value);
+
+    // sections appearing twice are merged, and appends are applied
+    ASSERT_TRUE(cpt.find("General", "Test4", value));
+    EXPECT_EQ("42", value);
+    ASSERT_TRUE(cpt.find("Junk", "Test4", value));
+    EXPECT_EQ("mama mia", value);
+
+    EXPECT_TRUE(cpt.sectionExists("Junk"));
+    EXPECT_FALSE(cpt.sectionExists("Foo"));
+    EXPECT_TRUE(cpt.entryExists("General", "Test1"));
+    EXPECT_FALSE(cpt.entryExists("General", "Test5"));
+    EXPECT_FALSE(cpt.find("Foo", "Test1", value));
+
+    remove(cptFile.c_str());
+}
+
+TEST(BinaryIniTest, RawEntries)
+{
+    writeTestFile();
+
+    BinaryIniFile cpt;
+    ASSERT_TRUE(cpt.load(cptFile));
+
+    string raw;
+    ASSERT_TRUE(cpt.findRaw("General", "Words", raw));
+    BinaryIni::RawHeader header;
+    ASSERT_EQ(sizeof(header) + 3 * sizeof(uint32_t), raw.size());
+    memcpy(&header, raw.data(), sizeof(header));
+    EXPECT_EQ(BinaryIni::Unsigned, header.kind);
+    EXPECT_EQ(sizeof(uint32_t), header.elemSize);
+    uint32_t words[3];
+    memcpy(words, raw.data() + sizeof(header), sizeof(words));
+    EXPECT_EQ(300000, words[2]);
+
+    // text entries are not raw
+    EXPECT_FALSE(cpt.findRaw("General", "Test1", raw));
+
+    // raw entries can also be read as text
+    string value;
+    ASSERT_TRUE(cpt.find("General", "Words", value));
+    EXPECT_EQ("1 2 300000", value);
+    ASSERT_TRUE(cpt.find("Junk", "Bytes", value));
+    EXPECT_EQ("-1 2", value);
+    ASSERT_TRUE(cpt.find("Junk", "Doubles", value));
+    EXPECT_EQ("0.5 -2.25", value);
+
+    remove(cptFile.c_str());
+}
+
+TEST(BinaryIniTest, NotBinary)
+{
+    {
+        ofstream text(cptFile);
+        text << "[General]\nTest1=foo\n";
+    }
+
+    BinaryIniFile cpt;
+    EXPECT_FALSE(cpt.load(cptFile));
+    EXPECT_FALSE(cpt.load("binary_inifile.test.missing"));
+
+    remove(cptFile.c_str());
+}
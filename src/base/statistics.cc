@@ -154,6 +154,38 @@ nameMap()
 
 int Info::id_count = 0;
 
+__thread unsigned _shardIndex = 0;
+
+static unsigned _numShards = 1;
+
+unsigned
+numShards()
+{
+    return _numShards;
+}
+
+void
+setNumShards(unsigned num_shards)
+{
+    fatal_if(num_shards == 0, "Sharded stats need at least one shard.\n");
+    _numShards = num_shards;
+}
+
+#if DETAILED_STATS
+bool _detailedEnabled = true;
+#endif
+
+void
+setDetailedEnabled(bool enabled)
+{
+#if DETAILED_STATS
+    _detailedEnabled = enabled;
+#else
+    warn_if(enabled, "Detailed stats were compiled out, rebuild with "
+            "DETAILED_STATS=True to enable them.\n");
+#endif
+}
+
 int debug_break_id = -1;
 
 Info::Info()
@@ -277,11 +309,15 @@ Info::baseCheck() const
 void
 Info::enable()
 {
+    if (flags.isSet(detailed) && !detailedEnabled())
+        flags.clear(display);
 }
 
 void
 VectorInfo::enable()
 {
+    Info::enable();
+
     size_type s = size();
     if (subnames.size() < s)
         subnames.resize(s);
@@ -292,6 +328,8 @@ VectorInfo::enable()
 void
 VectorDistInfo::enable()
 {
+    Info::enable();
+
     size_type s = size();
     if (subnames.size() < s)
         subnames.resize(s);
@@ -302,6 +340,8 @@ VectorDistInfo::enable()
 void
 Vector2dInfo::enable()
 {
+    Info::enable();
+
     if (subnames.size() < x)
         subnames.resize(x);
     if (subdescs.size() < x)
@@ -414,6 +454,51 @@ HistStor::add(HistStor *hs)
         cvec[i] += hs->cvec[i];
 }
 
+Counter
+hdrBucketLow(size_type index, unsigned bits)
+{
+    const size_type half = size_type(1) << (bits - 1);
+    if (index < 2 * half)
+        return index;
+
+    // Buckets past the first 2^bits values come in groups of half,
+    // each group being twice as wide as the previous one
+    const unsigned shift = index / half - 1;
+    return (Counter)((uint64_t)(index - shift * half) << shift);
+}
+
+Counter
+hdrBucketHigh(size_type index, unsigned bits)
+{
+    return hdrBucketLow(index + 1, bits) - 1;
+}
+
+Result
+hdrPercentile(const DistData &data, double pct)
+{
+    assert(data.type == Hdr);
+
+    Counter total = data.underflow + data.overflow;
+    for (const auto &count : data.cvec)
+        total += count;
+    if (total == 0)
+        return NAN;
+
+    const Counter target = std::max(1.0, std::ceil(total * pct / 100));
+    Counter count = data.underflow;
+    if (count >= target)
+        return data.min_val;
+
+    const unsigned bits = data.bucket_size;
+    for (size_type i = 0; i < data.cvec.size(); ++i) {
+        count += data.cvec[i];
+        if (count >= target)
+            return std::min(hdrBucketHigh(i, bits), data.max_val);
+    }
+
+    return data.max_val;
+}
+
 Formula::Formula(Group *parent, const char *name, const char *desc)
     : DataWrapVec<Formula, FormulaInfoProxy>(parent, name, desc)
 
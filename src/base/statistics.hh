@@ -81,6 +81,7 @@
 #include "base/intmath.hh"
 #include "base/str.hh"
 #include "base/types.hh"
+#include "config/detailed_stats.hh"
 
 class Callback;
 
@@ -584,8 +585,14 @@ class AvgStor
     void
     set(Counter val)
     {
-        total += current * (curTick() - last);
-        last = curTick();
+        // Only weight the count by time when time has advanced, which
+        // makes repeated updates in the same tick as cheap as for a
+        // plain scalar.
+        const Tick now = curTick();
+        if (now != last) {
+            total += current * (now - last);
+            last = now;
+        }
         current = val;
     }
 
@@ -608,14 +615,16 @@ class AvgStor
     Counter value() const { return current; }
 
     /**
-     * Return the current average.
+     * Return the current average. The count since the last change is
+     * accounted for, so the stat does not need to be prepared first.
      * @return The current average.
      */
     Result
     result() const
     {
-        assert(last == curTick());
-        return (Result)(total + current) / (Result)(curTick() - lastReset + 1);
+        const Result pending = current * (curTick() - last);
+        return (Result)(total + pending + current) /
+            (Result)(curTick() - lastReset + 1);
     }
 
     /**
@@ -646,6 +655,284 @@ class AvgStor
 
 };
 
+#if DETAILED_STATS
+extern bool _detailedEnabled;
+#endif
+
+/**
+ * Whether detailed stats are enabled. Always false when they are
+ * compiled out, so that the updates in STATS_DETAILED are removed.
+ */
+inline bool
+detailedEnabled()
+{
+#if DETAILED_STATS
+    return _detailedEnabled;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Enable or disable detailed stats. This must be done before stats
+ * are enabled, as disabled detailed stats are not printed.
+ */
+void setDetailedEnabled(bool enabled);
+
+/** Index of the stat shard updated by the current thread. */
+extern __thread unsigned _shardIndex;
+
+/**
+ * Get the index of the stat shard updated by the current thread, see
+ * ShardedStor.
+ */
+inline unsigned shardIndex() { return _shardIndex; }
+
+/** Set the index of the stat shard updated by the current thread. */
+inline void setShardIndex(unsigned index) { _shardIndex = index; }
+
+/** Get the number of shards of the sharded stats. */
+unsigned numShards();
+
+/**
+ * Set the number of shards of the sharded stats, which is the number
+ * of threads that can update them, usually the number of event
+ * queues. This must be done before sharded stats are created.
+ */
+void setNumShards(unsigned num_shards);
+
+/**
+ * Stores shards of a stat, one per thread updating it.
+ *
+ * When there is more than one shard, the shards are spaced so that
+ * there is at least a cache line between two of them, and threads do
+ * not share lines.
+ */
+template <class Shard>
+class ShardArray
+{
+  private:
+    /** Number of elements used by a shard. */
+    const size_t stride;
+    std::vector<Shard> shards;
+
+  public:
+    ShardArray()
+        : stride(numShards() > 1 ?
+                 (64 + 2 * sizeof(Shard) - 1) / sizeof(Shard) : 1),
+          shards(numShards() * stride)
+    { }
+
+    /** Number of shards. */
+    size_t size() const { return shards.size() / stride; }
+
+    Shard &
+    operator[](size_t index)
+    {
+        assert(index * stride < shards.size());
+        return shards[index * stride];
+    }
+
+    const Shard &
+    operator[](size_t index) const
+    {
+        assert(index * stride < shards.size());
+        return shards[index * stride];
+    }
+
+    /** The shard of the current thread. */
+    Shard &local() { return (*this)[shardIndex()]; }
+};
+
+/**
+ * Storage for a scalar stat that can be updated from several threads,
+ * typically by objects that are accessed from more than one event
+ * queue. Each thread updates its own shard without synchronization,
+ * and the shards are summed when the stat is read, which must only
+ * happen while the threads are stopped, e.g., when dumping stats.
+ */
+class ShardedStor
+{
+  private:
+    ShardArray<Counter> shards;
+
+  public:
+    struct Params : public StorageParams {};
+
+  public:
+    ShardedStor(Info *info) { }
+
+    /**
+     * Set the value of the stat. This overwrites the updates of all
+     * threads, and must not be done while other threads update the
+     * stat.
+     * @param val The new value.
+     */
+    void
+    set(Counter val)
+    {
+        reset(nullptr);
+        shards[0] = val;
+    }
+
+    /**
+     * Increment the shard of the current thread.
+     * @param val The amount to increment.
+     */
+    void inc(Counter val) { shards.local() += val; }
+
+    /**
+     * Decrement the shard of the current thread.
+     * @param val The amount to decrement.
+     */
+    void dec(Counter val) { shards.local() -= val; }
+
+    /**
+     * Return the sum of all the shards.
+     * @return The value of this stat.
+     */
+    Counter
+    value() const
+    {
+        Counter total = Counter();
+        for (size_t i = 0; i < shards.size(); ++i)
+            total += shards[i];
+        return total;
+    }
+
+    Result result() const { return (Result)value(); }
+
+    void prepare(Info *info) { }
+
+    void
+    reset(Info *info)
+    {
+        for (size_t i = 0; i < shards.size(); ++i)
+            shards[i] = Counter();
+    }
+
+    bool zero() const { return value() == Counter(); }
+};
+
+/**
+ * Storage for a per-tick average stat that can be updated from
+ * several threads. Each thread keeps its own count, weighted by the
+ * current tick of its event queue, and the counts are only combined
+ * when the stat is prepared for dumping. As the average of a sum is
+ * the sum of the averages, the result is the same as that of an
+ * AvgStor updated with all the changes.
+ */
+class ShardedAvgStor
+{
+  private:
+    struct Shard
+    {
+        /** The current count of the shard. */
+        Counter current;
+        /** The total count for all ticks. */
+        Result total;
+        /** The tick that current last changed. */
+        Tick last;
+    };
+
+    ShardArray<Shard> shards;
+
+    /** The tick of the last reset */
+    Tick lastReset;
+
+  public:
+    struct Params : public StorageParams {};
+
+  public:
+    ShardedAvgStor(Info *info)
+        : lastReset(0)
+    { }
+
+    /**
+     * Set the current count of the shard of the current thread.
+     * @param val The new count.
+     */
+    void
+    set(Counter val)
+    {
+        Shard &shard = shards.local();
+        const Tick now = curTick();
+        if (now != shard.last) {
+            shard.total += shard.current * (now - shard.last);
+            shard.last = now;
+        }
+        shard.current = val;
+    }
+
+    void inc(Counter val) { set(shards.local().current + val); }
+
+    void dec(Counter val) { set(shards.local().current - val); }
+
+    /**
+     * Return the current count of all the shards.
+     */
+    Counter
+    value() const
+    {
+        Counter current = 0;
+        for (size_t i = 0; i < shards.size(); ++i)
+            current += shards[i].current;
+        return current;
+    }
+
+    /**
+     * Return the current average. As for AvgStor, the stat does not
+     * need to be prepared first.
+     */
+    Result
+    result() const
+    {
+        const Tick now = curTick();
+        Result total = 0;
+        for (size_t i = 0; i < shards.size(); ++i) {
+            const Shard &shard = shards[i];
+            total += shard.total + shard.current * (now - shard.last) +
+                shard.current;
+        }
+        return total / (Result)(now - lastReset + 1);
+    }
+
+    bool
+    zero() const
+    {
+        for (size_t i = 0; i < shards.size(); ++i) {
+            if (shards[i].total != 0.0)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Bring all the shards up to the current tick.
+     */
+    void
+    prepare(Info *info)
+    {
+        const Tick now = curTick();
+        for (size_t i = 0; i < shards.size(); ++i) {
+            Shard &shard = shards[i];
+            shard.total += shard.current * (now - shard.last);
+            shard.last = now;
+        }
+    }
+
+    void
+    reset(Info *info)
+    {
+        const Tick now = curTick();
+        for (size_t i = 0; i < shards.size(); ++i) {
+            shards[i].total = 0.0;
+            shards[i].last = now;
+        }
+        lastReset = now;
+    }
+};
+
 /**
  * Implementation of a scalar stat. The type of stat is determined by the
  * Storage template.
@@ -707,6 +994,8 @@ class ScalarBase : public DataWrap<Derived, ScalarInfoProxy>
         this->doInit();
     }
 
+    ~ScalarBase() { data()->~Storage(); }
+
   public:
     // Common operators for stats
     /**
@@ -1683,6 +1972,172 @@ class HistStor
     }
 };
 
+/**
+ * Templatized storage and interface for a distribution with high
+ * dynamic range (HDR) buckets. Every value below 2^bits has a bucket
+ * of its own, and every following power of two is split in
+ * 2^(bits-1) buckets, so a bucket is never wider than 2^(1-bits)
+ * times its values. The number of buckets only grows with the
+ * logarithm of the largest value tracked, and sampling a value costs
+ * a few integer operations. Values are truncated to integers.
+ */
+class HdrStor
+{
+  public:
+    /** The parameters for an HDR distribution stat. */
+    struct Params : public DistParams
+    {
+        /** The maximum value to track. */
+        Counter max;
+        /** The number of significant bits of the buckets. */
+        unsigned bits;
+        /** The number of buckets. Equal to bucketIndex(max, bits) + 1. */
+        size_type buckets;
+
+        Params() : DistParams(Hdr), max(0), bits(0), buckets(0) {}
+    };
+
+    /**
+     * Find the bucket of a value.
+     * @param val The value.
+     * @param bits The number of significant bits of the buckets.
+     * @return The index of the bucket.
+     */
+    static size_type
+    bucketIndex(uint64_t val, unsigned bits)
+    {
+        if (val < (ULL(1) << bits))
+            return val;
+
+        const unsigned shift = floorLog2(val) - (bits - 1);
+        return ((size_type)shift << (bits - 1)) + (val >> shift);
+    }
+
+  private:
+    /** The maximum value to track. */
+    Counter max_track;
+    /** The number of significant bits of the buckets. */
+    unsigned bits;
+
+    /** The smallest value sampled. */
+    Counter min_val;
+    /** The largest value sampled. */
+    Counter max_val;
+    /** The number of negative values sampled. */
+    Counter underflow;
+    /** The number of values sampled more than max. */
+    Counter overflow;
+    /** The current sum. */
+    Counter sum;
+    /** The sum of squares. */
+    Counter squares;
+    /** The number of samples. */
+    Counter samples;
+    /** Counter for each bucket. */
+    VCounter cvec;
+
+  public:
+    HdrStor(Info *info)
+        : cvec(safe_cast<const Params *>(info->storageParams)->buckets)
+    {
+        reset(info);
+    }
+
+    /**
+     * Add a value to the distribution for the given number of times.
+     * @param val The value to add.
+     * @param number The number of times to add the value.
+     */
+    void
+    sample(Counter val, int number)
+    {
+        if (val < 0)
+            underflow += number;
+        else if (val > max_track)
+            overflow += number;
+        else {
+            size_type index = bucketIndex((uint64_t)val, bits);
+            assert(index < size());
+            cvec[index] += number;
+        }
+
+        if (val < min_val)
+            min_val = val;
+
+        if (val > max_val)
+            max_val = val;
+
+        sum += val * number;
+        squares += val * val * number;
+        samples += number;
+    }
+
+    /**
+     * Return the number of buckets in this distribution.
+     * @return the number of buckets.
+     */
+    size_type size() const { return cvec.size(); }
+
+    /**
+     * Returns true if any calls to sample have been made.
+     * @return True if any values have been sampled.
+     */
+    bool
+    zero() const
+    {
+        return samples == Counter();
+    }
+
+    void
+    prepare(Info *info, DistData &data)
+    {
+        const Params *params = safe_cast<const Params *>(info->storageParams);
+
+        assert(params->type == Hdr);
+        data.type = params->type;
+        data.min = 0;
+        data.max = params->max;
+        data.bucket_size = params->bits;
+
+        data.min_val = (min_val == CounterLimits::max()) ? 0 : min_val;
+        data.max_val = (max_val == CounterLimits::min()) ? 0 : max_val;
+        data.underflow = underflow;
+        data.overflow = overflow;
+
+        data.cvec.resize(params->buckets);
+        for (off_type i = 0; i < params->buckets; ++i)
+            data.cvec[i] = cvec[i];
+
+        data.sum = sum;
+        data.squares = squares;
+        data.samples = samples;
+    }
+
+    /**
+     * Reset stat value to default
+     */
+    void
+    reset(Info *info)
+    {
+        const Params *params = safe_cast<const Params *>(info->storageParams);
+        max_track = params->max;
+        bits = params->bits;
+
+        min_val = CounterLimits::max();
+        max_val = CounterLimits::min();
+        underflow = Counter();
+        overflow = Counter();
+
+        size_type size = cvec.size();
+        for (off_type i = 0; i < size; ++i)
+            cvec[i] = Counter();
+
+        sum = Counter();
+        squares = Counter();
+        samples = Counter();
+    }
+};
+
 /**
  * Templatized storage and interface for a distribution that calculates mean
  * and variance.
@@ -2530,6 +2985,39 @@ class Average : public ScalarBase<Average, AvgStor>
     }
 };
 
+/**
+ * A scalar stat that can be updated from several event queues.
+ * @sa Stat, ScalarBase, ShardedStor
+ */
+class ShardedScalar : public ScalarBase<ShardedScalar, ShardedStor>
+{
+  public:
+    using ScalarBase<ShardedScalar, ShardedStor>::operator=;
+
+    ShardedScalar(Group *parent = nullptr, const char *name = nullptr,
+                  const char *desc = nullptr)
+        : ScalarBase<ShardedScalar, ShardedStor>(parent, name, desc)
+    {
+    }
+};
+
+/**
+ * A per tick average stat that can be updated from several event
+ * queues.
+ * @sa Stat, ScalarBase, ShardedAvgStor
+ */
+class ShardedAverage : public ScalarBase<ShardedAverage, ShardedAvgStor>
+{
+  public:
+    using ScalarBase<ShardedAverage, ShardedAvgStor>::operator=;
+
+    ShardedAverage(Group *parent = nullptr, const char *name = nullptr,
+                   const char *desc = nullptr)
+        : ScalarBase<ShardedAverage, ShardedAvgStor>(parent, name, desc)
+    {
+    }
+};
+
 class Value : public ValueBase<Value>
 {
   public:
@@ -2568,6 +3056,37 @@ class AverageVector : public VectorBase<AverageVector, AvgStor>
     }
 };
 
+/**
+ * A vector of scalar stats that can be updated from several event
+ * queues.
+ * @sa Stat, VectorBase, ShardedStor
+ */
+class ShardedVector : public VectorBase<ShardedVector, ShardedStor>
+{
+  public:
+    ShardedVector(Group *parent = nullptr, const char *name = nullptr,
+                  const char *desc = nullptr)
+        : VectorBase<ShardedVector, ShardedStor>(parent, name, desc)
+    {
+    }
+};
+
+/**
+ * A vector of Average stats that can be updated from several event
+ * queues.
+ * @sa Stat, VectorBase, ShardedAvgStor
+ */
+class ShardedAverageVector
+    : public VectorBase<ShardedAverageVector, ShardedAvgStor>
+{
+  public:
+    ShardedAverageVector(Group *parent = nullptr, const char *name = nullptr,
+                         const char *desc = nullptr)
+        : VectorBase<ShardedAverageVector, ShardedAvgStor>(parent, name, desc)
+    {
+    }
+};
+
 /**
  * A 2-Dimensional vecto of scalar stats.
  * @sa Stat, Vector2dBase, StatStor
@@ -2582,6 +3101,21 @@ class Vector2d : public Vector2dBase<Vector2d, StatStor>
     }
 };
 
+/**
+ * A 2-Dimensional vector of scalar stats that can be updated from
+ * several event queues.
+ * @sa Stat, Vector2dBase, ShardedStor
+ */
+class ShardedVector2d : public Vector2dBase<ShardedVector2d, ShardedStor>
+{
+  public:
+    ShardedVector2d(Group *parent = nullptr, const char *name = nullptr,
+                    const char *desc = nullptr)
+        : Vector2dBase<ShardedVector2d, ShardedStor>(parent, name, desc)
+    {
+    }
+};
+
 /**
  * A simple distribution stat.
  * @sa Stat, DistBase, DistStor
@@ -2648,6 +3182,41 @@ class Histogram : public DistBase<Histogram, HistStor>
     }
 };
 
+/**
+ * A histogram with HDR buckets, which keeps the same relative
+ * precision from the smallest to the largest values, e.g., to report
+ * latency percentiles.
+ * @sa Stat, DistBase, HdrStor
+ */
+class HdrHistogram : public DistBase<HdrHistogram, HdrStor>
+{
+  public:
+    HdrHistogram(Group *parent = nullptr, const char *name = nullptr,
+                 const char *desc = nullptr)
+        : DistBase<HdrHistogram, HdrStor>(parent, name, desc)
+    {
+    }
+
+    /**
+     * Set the parameters of this histogram. @sa HdrStor::Params
+     * @param max The maximum value of the histogram.
+     * @param bits The number of significant bits of the buckets.
+     * @return A reference to this histogram.
+     */
+    HdrHistogram &
+    init(Counter max, unsigned bits = 7)
+    {
+        assert(max >= 0 && bits > 0 && bits < 32);
+        HdrStor::Params *params = new HdrStor::Params;
+        params->max = max;
+        params->bits = bits;
+        params->buckets = HdrStor::bucketIndex((uint64_t)max, bits) + 1;
+        this->setParams(params);
+        this->doInit();
+        return this->self();
+    }
+};
+
 /**
  * Calculates the mean and variance of all the samples.
  * @sa DistBase, SampleStor
@@ -2723,6 +3292,41 @@ class VectorDistribution : public VectorDistBase<VectorDistribution, DistStor>
     }
 };
 
+/**
+ * A vector of HDR histograms.
+ * @sa VectorDistBase, HdrStor
+ */
+class VectorHdrHistogram
+    : public VectorDistBase<VectorHdrHistogram, HdrStor>
+{
+  public:
+    VectorHdrHistogram(Group *parent = nullptr, const char *name = nullptr,
+                       const char *desc = nullptr)
+        : VectorDistBase<VectorHdrHistogram, HdrStor>(parent, name, desc)
+    {
+    }
+
+    /**
+     * Initialize storage and parameters for this histogram.
+     * @param size The size of the vector (the number of histograms).
+     * @param max The maximum value of the histograms.
+     * @param bits The number of significant bits of the buckets.
+     * @return A reference to this histogram.
+     */
+    VectorHdrHistogram &
+    init(size_type size, Counter max, unsigned bits = 7)
+    {
+        assert(max >= 0 && bits > 0 && bits < 32);
+        HdrStor::Params *params = new HdrStor::Params;
+        params->max = max;
+        params->bits = bits;
+        params->buckets = HdrStor::bucketIndex((uint64_t)max, bits) + 1;
+        this->setParams(params);
+        this->doInit(size);
+        return this->self();
+    }
+};
+
 /**
  * This is a vector of StandardDeviation stats.
  * @sa VectorDistBase, SampleStor
@@ -3176,6 +3780,34 @@ class Temp
         : node(new VectorStatNode(s.info()))
     { }
 
+    /**
+     * Create a new ScalarStatNode.
+     * @param s The ShardedScalar to place in a node.
+     */
+    Temp(const ShardedScalar &s)
+        : node(new ScalarStatNode(s.info()))
+    { }
+
+    /**
+     * Create a new ScalarStatNode.
+     * @param s The ShardedAverage to place in a node.
+     */
+    Temp(const ShardedAverage &s)
+        : node(new ScalarStatNode(s.info()))
+    { }
+
+    /**
+     * Create a new VectorStatNode.
+     * @param s The ShardedVector to place in a node.
+     */
+    Temp(const ShardedVector &s)
+        : node(new VectorStatNode(s.info()))
+    { }
+
+    Temp(const ShardedAverageVector &s)
+        : node(new VectorStatNode(s.info()))
+    { }
+
     /**
      *
      */
@@ -3396,4 +4028,16 @@ bool validateStatName(const std::string &name);
 
 void debugDumpStats();
 
+/**
+ * Update a detailed stat (see Stats::detailed). The statement is only
+ * executed when detailed stats are enabled at run time, which costs a
+ * single branch, and is removed by the compiler when they are compiled
+ * out as the condition is then constant.
+ */
+#define STATS_DETAILED(...) do {                \
+    if (Stats::detailedEnabled()) {             \
+        __VA_ARGS__;                            \
+    }                                           \
+} while (0)
+
 #endif // __BASE_STATISTICS_HH__
@@ -0,0 +1,474 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/stats/async_output.hh"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include "base/stats/info.hh"
+
+namespace Stats {
+
+namespace {
+
+/**
+ * Frozen copy of a stat, holding the values the stat had when it was
+ * last updated. The static fields of the stat (name, flags, ...) are
+ * copied when the copy is created, by init(), and the values are
+ * copied at every dump, by update().
+ */
+template <class Base>
+class Frozen : public Base
+{
+  public:
+    bool check() const override { return true; }
+    void prepare() override {}
+    void reset() override {}
+    bool zero() const override { return isZero; }
+    void visit(Output &visitor) override { visitor.visit(*this); }
+
+    bool isZero = false;
+
+  protected:
+    void
+    initInfo(const Info &info)
+    {
+        this->name = info.name;
+        this->desc = info.desc;
+        this->flags = info.flags;
+        this->precision = info.precision;
+        this->id = info.id;
+        this->storageParams = info.storageParams;
+    }
+};
+
+/** Stand-in for the prerequisite of a stat when it is zero. */
+const Info &
+zeroPrereq()
+{
+    class ZeroInfo : public Frozen<SparseHistInfo>
+    {
+      public:
+        ZeroInfo() { isZero = true; }
+    };
+
+    static ZeroInfo info;
+    return info;
+}
+
+class FrozenScalar : public Frozen<ScalarInfo>
+{
+  public:
+    Counter value() const override { return _value; }
+    Result result() const override { return _result; }
+    Result total() const override { return _total; }
+
+    void init(const ScalarInfo &info) { initInfo(info); }
+
+    void
+    update(const ScalarInfo &info)
+    {
+        _value = info.value();
+        _result = info.result();
+        _total = info.total();
+    }
+
+  private:
+    Counter _value;
+    Result _result;
+    Result _total;
+};
+
+template <class Base>
+class FrozenVectorBase : public Frozen<Base>
+{
+  public:
+    size_type size() const override { return _result.size(); }
+    const VCounter &value() const override { return _value; }
+    const VResult &result() const override { return _result; }
+    Result total() const override { return _total; }
+
+    void
+    init(const Base &info)
+    {
+        this->initInfo(info);
+        this->subnames = info.subnames;
+        this->subdescs = info.subdescs;
+    }
+
+    void
+    update(const Base &info)
+    {
+        _value = info.value();
+        _result = info.result();
+        _total = info.total();
+    }
+
+  private:
+    VCounter _value;
+    VResult _result;
+    Result _total;
+};
+
+typedef FrozenVectorBase<VectorInfo> FrozenVector;
+
+class FrozenFormula : public FrozenVectorBase<FormulaInfo>
+{
+  public:
+    std::string str() const override { return _str; }
+
+    void
+    init(const FormulaInfo &info)
+    {
+        FrozenVectorBase<FormulaInfo>::init(info);
+        _str = info.str();
+    }
+
+  private:
+    std::string _str;
+};
+
+class FrozenDist : public Frozen<DistInfo>
+{
+  public:
+    void init(const DistInfo &info) { initInfo(info); }
+    void update(const DistInfo &info) { data = info.data; }
+};
+
+class FrozenVectorDist : public Frozen<VectorDistInfo>
+{
+  public:
+    size_type size() const override { return data.size(); }
+
+    void
+    init(const VectorDistInfo &info)
+    {
+        initInfo(info);
+        subnames = info.subnames;
+        subdescs = info.subdescs;
+    }
+
+    void update(const VectorDistInfo &info) { data = info.data; }
+};
+
+class FrozenVector2d : public Frozen<Vector2dInfo>
+{
+  public:
+    Result total() const override { return _total; }
+
+    void
+    init(const Vector2dInfo &info)
+    {
+        initInfo(info);
+        subnames = info.subnames;
+        subdescs = info.subdescs;
+        y_subnames = info.y_subnames;
+        x = info.x;
+        y = info.y;
+    }
+
+    void
+    update(const Vector2dInfo &info)
+    {
+        cvec = info.cvec;
+        _total = info.total();
+    }
+
+  private:
+    Result _total;
+};
+
+class FrozenSparseHist : public Frozen<SparseHistInfo>
+{
+  public:
+    void init(const SparseHistInfo &info) { initInfo(info); }
+    void update(const SparseHistInfo &info) { data = info.data; }
+};
+
+/** All the background outputs, to flush them. */
+std::vector<AsyncOutput *> &
+asyncOutputs()
+{
+    static std::vector<AsyncOutput *> outputs;
+    return outputs;
+}
+
+} // anonymous namespace
+
+AsyncOutput::AsyncOutput(Output &output)
+    : output(output), current(nullptr),
+      freeSnapshots{&snapshots[0], &snapshots[1]},
+      writing(false), stopping(false), outputValid(output.valid()),
+      writerPid(0)
+{
+    asyncOutputs().push_back(this);
+}
+
+AsyncOutput::~AsyncOutput()
+{
+    auto &outputs = asyncOutputs();
+    outputs.erase(std::remove(outputs.begin(), outputs.end(), this),
+                  outputs.end());
+
+    if (writerPid != getpid()) {
+        // the writer thread belongs to another process
+        if (writer.joinable())
+            writer.detach();
+        return;
+    }
+
+    stopWriter();
+}
+
+void
+AsyncOutput::startWriter()
+{
+    if (writer.joinable()) {
+        // The process has been forked, and the writer thread only
+        // exists in the parent. Snapshots that were being written
+        // there are lost, so recycle them.
+        writer.detach();
+        writing = false;
+        freeSnapshots.clear();
+        for (auto &snapshot : snapshots) {
+            if (&snapshot != current &&
+                std::find(readySnapshots.begin(), readySnapshots.end(),
+                          &snapshot) == readySnapshots.end()) {
+                freeSnapshots.push_back(&snapshot);
+            }
+        }
+    }
+
+    writerPid = getpid();
+    writer = std::thread(&AsyncOutput::writerLoop, this);
+}
+
+void
+AsyncOutput::stopWriter()
+{
+    if (!writer.joinable() || writerPid != getpid())
+        return;
+
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cond.notify_all();
+    writer.join();
+    stopping = false;
+}
+
+void
+AsyncOutput::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cond.wait(lock, [this] {
+            return stopping || !readySnapshots.empty();
+        });
+        if (readySnapshots.empty())
+            return;
+
+        Snapshot *snapshot = readySnapshots.front();
+        readySnapshots.pop_front();
+        writing = true;
+        lock.unlock();
+
+        output.begin();
+        for (size_t i = 0; i < snapshot->numOps; ++i) {
+            Op &op = snapshot->ops[i];
+            switch (op.type) {
+              case Op::BeginGroup:
+                output.beginGroup(op.name.c_str());
+                break;
+              case Op::EndGroup:
+                output.endGroup();
+                break;
+              case Op::Visit:
+                op.info->visit(output);
+                break;
+            }
+        }
+        output.end();
+        outputValid = output.valid();
+
+        lock.lock();
+        writing = false;
+        freeSnapshots.push_back(snapshot);
+        cond.notify_all();
+    }
+}
+
+void
+AsyncOutput::flush()
+{
+    if (writerPid != getpid())
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return readySnapshots.empty() && !writing; });
+}
+
+void
+AsyncOutput::flushAll()
+{
+    // The writer threads are stopped as well, since a process forked
+    // while they wait for a snapshot could not destroy the condition
+    // variable they wait on. They are restarted by the next dump.
+    for (auto *output : asyncOutputs())
+        output->stopWriter();
+}
+
+void
+AsyncOutput::begin()
+{
+    if (!writer.joinable() || writerPid != getpid())
+        startWriter();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return !freeSnapshots.empty(); });
+    current = freeSnapshots.front();
+    freeSnapshots.pop_front();
+    current->numOps = 0;
+}
+
+void
+AsyncOutput::end()
+{
+    assert(current);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readySnapshots.push_back(current);
+        current = nullptr;
+    }
+    cond.notify_all();
+}
+
+bool
+AsyncOutput::valid() const
+{
+    return outputValid;
+}
+
+AsyncOutput::Op &
+AsyncOutput::addOp(Op::Type type)
+{
+    assert(current);
+    if (current->numOps == current->ops.size())
+        current->ops.emplace_back();
+
+    Op &op = current->ops[current->numOps++];
+    op.type = type;
+    return op;
+}
+
+void
+AsyncOutput::beginGroup(const char *name)
+{
+    addOp(Op::BeginGroup).name = name;
+}
+
+void
+AsyncOutput::endGroup()
+{
+    addOp(Op::EndGroup);
+}
+
+template <class FrozenInfo, class Live>
+void
+AsyncOutput::freeze(const Live &info)
+{
+    std::unique_ptr<Info> &slot = current->infos[&info];
+    if (!slot) {
+        FrozenInfo *frozen = new FrozenInfo();
+        frozen->init(info);
+        slot.reset(frozen);
+    }
+
+    FrozenInfo &frozen = static_cast<FrozenInfo &>(*slot);
+    frozen.update(info);
+    // prerequisites are only used to know if they are zero
+    frozen.prereq = info.prereq && info.prereq->zero() ?
+        &zeroPrereq() : nullptr;
+
+    addOp(Op::Visit).info = &frozen;
+}
+
+void
+AsyncOutput::visit(const ScalarInfo &info)
+{
+    freeze<FrozenScalar>(info);
+}
+
+void
+AsyncOutput::visit(const VectorInfo &info)
+{
+    freeze<FrozenVector>(info);
+}
+
+void
+AsyncOutput::visit(const DistInfo &info)
+{
+    freeze<FrozenDist>(info);
+}
+
+void
+AsyncOutput::visit(const VectorDistInfo &info)
+{
+    freeze<FrozenVectorDist>(info);
+}
+
+void
+AsyncOutput::visit(const Vector2dInfo &info)
+{
+    freeze<FrozenVector2d>(info);
+}
+
+void
+AsyncOutput::visit(const FormulaInfo &info)
+{
+    freeze<FrozenFormula>(info);
+}
+
+void
+AsyncOutput::visit(const SparseHistInfo &info)
+{
+    freeze<FrozenSparseHist>(info);
+}
+
+std::unique_ptr<Output>
+initAsync(Output *output)
+{
+    return std::unique_ptr<Output>(new AsyncOutput(*output));
+}
+
+} // namespace Stats
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BASE_STATS_ASYNC_OUTPUT_HH__
+#define __BASE_STATS_ASYNC_OUTPUT_HH__
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "base/stats/output.hh"
+
+namespace Stats {
+
+class Info;
+
+/**
+ * Stat output that writes stats in the background.
+ *
+ * During a dump, the values of the stats are copied to a snapshot,
+ * and the snapshot is then passed to another output on a writer
+ * thread, which does the formatting and the file I/O while
+ * simulation continues. The snapshots are made of frozen copies of
+ * the Info objects of the stats, which are allocated at the first
+ * dump and reused afterwards, so later dumps only copy values.
+ *
+ * At most two snapshots exist at a time. If the writer is still busy
+ * with the previous dump when a new one starts, the dump waits for
+ * it, which bounds the memory used.
+ */
+class AsyncOutput : public Output
+{
+  public:
+    /**
+     * @param output The output to write the stats to. It must outlive
+     * this object, and must not be used by anything else.
+     */
+    AsyncOutput(Output &output);
+
+    ~AsyncOutput();
+
+    AsyncOutput() = delete;
+    AsyncOutput(const AsyncOutput &other) = delete;
+
+    /** Wait until all the dumps started so far have been written. */
+    void flush();
+
+    /** Flush all the background outputs and stop their writers. */
+    static void flushAll();
+
+  public: // Output interface
+    void begin() override;
+    void end() override;
+    bool valid() const override;
+
+    void beginGroup(const char *name) override;
+    void endGroup() override;
+
+    void visit(const ScalarInfo &info) override;
+    void visit(const VectorInfo &info) override;
+    void visit(const DistInfo &info) override;
+    void visit(const VectorDistInfo &info) override;
+    void visit(const Vector2dInfo &info) override;
+    void visit(const FormulaInfo &info) override;
+    void visit(const SparseHistInfo &info) override;
+
+  protected:
+    /** An action of the dump to replay on the output. */
+    struct Op
+    {
+        enum Type { BeginGroup, EndGroup, Visit };
+
+        Type type;
+        /** Name of the group for BeginGroup. */
+        std::string name;
+        /** Frozen stat for Visit. */
+        Info *info;
+    };
+
+    /** The stats of a dump. */
+    struct Snapshot
+    {
+        /** The actions of the dump, of which numOps are used. */
+        std::vector<Op> ops;
+        size_t numOps = 0;
+
+        /** Frozen copies of the stats, indexed by the live stats. */
+        std::unordered_map<const Info *, std::unique_ptr<Info>> infos;
+    };
+
+    /** Append an action to the current snapshot. */
+    Op &addOp(Op::Type type);
+
+    /**
+     * Get the frozen copy of a stat in the current snapshot, creating
+     * it if needed, and add a Visit action for it.
+     */
+    template <class FrozenInfo, class Live>
+    void freeze(const Live &info);
+
+    /** Start the writer thread. */
+    void startWriter();
+
+    /** Write the pending dumps and stop the writer thread. */
+    void stopWriter();
+
+    /** Body of the writer thread. */
+    void writerLoop();
+
+  protected:
+    Output &output;
+
+    Snapshot snapshots[2];
+
+    /** Snapshot being filled by the current dump. */
+    Snapshot *current;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    /** Snapshots that can be filled. */
+    std::deque<Snapshot *> freeSnapshots;
+
+    /** Snapshots waiting to be written. */
+    std::deque<Snapshot *> readySnapshots;
+
+    /** Whether the writer is writing a snapshot. */
+    bool writing;
+
+    /** Whether the writer thread should exit. */
+    bool stopping;
+
+    /** Whether the output was valid after its last dump. */
+    std::atomic<bool> outputValid;
+
+    std::thread writer;
+
+    /** Process in which the writer thread was started. */
+    pid_t writerPid;
+};
+
+/**
+ * Write the stats of an output in the background.
+ *
+ * @param output The output, which must outlive the returned one.
+ */
+std::unique_ptr<Output> initAsync(Output *output);
+
+} // namespace Stats
+
+#endif // __BASE_STATS_ASYNC_OUTPUT_HH__
@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/stats/columnar.hh"
+
+#include <zlib.h>
+
+#include <cstring>
+
+#include "base/logging.hh"
+#include "base/output.hh"
+#include "base/stats/info.hh"
+
+namespace Stats {
+
+const char Columnar::magic[8] = { 'g', 'e', 'm', '5', 's', 't', 'c', 'l' };
+
+namespace {
+
+template <class T>
+void
+appendValue(std::string &buf, const T &value)
+{
+    buf.append((const char *)&value, sizeof(value));
+}
+
+void
+appendString(std::string &buf, const std::string &str)
+{
+    appendValue(buf, (uint32_t)str.size());
+    buf.append(str);
+}
+
+void
+appendStrings(std::string &buf, const std::vector<std::string> &strs)
+{
+    // empty lists of names are common, store them compactly
+    bool empty = true;
+    for (const auto &s : strs)
+        empty = empty && s.empty();
+
+    appendValue(buf, (uint32_t)(empty ? 0 : strs.size()));
+    if (!empty) {
+        for (const auto &s : strs)
+            appendString(buf, s);
+    }
+}
+
+} // anonymous namespace
+
+Columnar::Columnar(const std::string &file, bool desc, bool formulas,
+                   bool compress)
+    : fname(file), enableDescriptions(desc), enableFormula(formulas),
+      enableCompression(compress), schemaChanged(false), curColumn(0),
+      dumpCount(0)
+{
+    this->file.open(fname, std::ios::out | std::ios::trunc |
+                    std::ios::binary);
+    if (!this->file.is_open())
+        fatal("Unable to open statistics file %s for writing\n", fname);
+
+    FileHeader header;
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = version;
+    header.flags = enableCompression ? compressedFlag : 0;
+    this->file.write((const char *)&header, sizeof(header));
+}
+
+Columnar::~Columnar()
+{
+}
+
+void
+Columnar::begin()
+{
+    schemaChanged = false;
+    curColumn = 0;
+    values.clear();
+}
+
+void
+Columnar::end()
+{
+    assert(path.empty());
+
+    // stats may also have disappeared at the end of the schema
+    if (!schemaChanged && curColumn != columns.size()) {
+        schemaChanged = true;
+        newColumns.assign(columns.begin(), columns.begin() + curColumn);
+    }
+
+    if (schemaChanged) {
+        columns.swap(newColumns);
+        newColumns.clear();
+        writeSchema();
+        prevValues.clear();
+    }
+
+    writeData();
+    file.flush();
+
+    dumpCount++;
+}
+
+bool
+Columnar::valid() const
+{
+    return file.good();
+}
+
+void
+Columnar::beginGroup(const char *name)
+{
+    if (path.empty())
+        path.push_back(name);
+    else
+        path.push_back(path.back() + "." + name);
+}
+
+void
+Columnar::endGroup()
+{
+    assert(!path.empty());
+    path.pop_back();
+}
+
+void
+Columnar::addColumn(const Info &info, Kind kind, size_type num_values)
+{
+    const size_t pos = curColumn++;
+    if (!schemaChanged) {
+        if (pos < columns.size() && columns[pos].id == info.id &&
+            columns[pos].kind == kind &&
+            columns[pos].numValues == num_values) {
+            // the Info may be a new copy of the same stat
+            columns[pos].info = &info;
+            return;
+        }
+
+        // the stats up to here are unchanged, keep their names
+        schemaChanged = true;
+        newColumns.assign(columns.begin(), columns.begin() + pos);
+    }
+
+    newColumns.push_back(Column{&info, info.id, kind, num_values,
+            path.empty() ? info.name : path.back() + "." + info.name});
+}
+
+void
+Columnar::visit(const ScalarInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    addColumn(info, ScalarKind, 1);
+    values.push_back(info.result());
+}
+
+void
+Columnar::visit(const VectorInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    const VResult &vr(info.result());
+    addColumn(info, VectorKind, vr.size());
+    values.insert(values.end(), vr.begin(), vr.end());
+}
+
+void
+Columnar::appendDist(const DistData &data)
+{
+    values.push_back(data.samples);
+    values.push_back(data.sum);
+    values.push_back(data.squares);
+    values.push_back(data.logs);
+    values.push_back(data.min_val);
+    values.push_back(data.max_val);
+    values.push_back(data.underflow);
+    values.push_back(data.overflow);
+    values.insert(values.end(), data.cvec.begin(), data.cvec.end());
+}
+
+void
+Columnar::visit(const DistInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    addColumn(info, DistKind, distFields + info.data.cvec.size());
+    appendDist(info.data);
+}
+
+void
+Columnar::visit(const VectorDistInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    size_type num_values = 0;
+    for (const auto &data : info.data)
+        num_values += distFields + data.cvec.size();
+
+    addColumn(info, VectorDistKind, num_values);
+    for (const auto &data : info.data)
+        appendDist(data);
+}
+
+void
+Columnar::visit(const Vector2dInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    addColumn(info, Vector2dKind, info.cvec.size());
+    values.insert(values.end(), info.cvec.begin(), info.cvec.end());
+}
+
+void
+Columnar::visit(const FormulaInfo &info)
+{
+    if (!enableFormula || !info.flags.isSet(display))
+        return;
+
+    const VResult &vr(info.result());
+    addColumn(info, FormulaKind, vr.size());
+    values.insert(values.end(), vr.begin(), vr.end());
+}
+
+void
+Columnar::visit(const SparseHistInfo &info)
+{
+    warn_once("Columnar stat files don't support sparse histograms.\n");
+}
+
+void
+Columnar::writeRecord(RecordType type, const std::string &payload)
+{
+    const uint64_t size = payload.size();
+    file.write((const char *)&type, sizeof(type));
+    file.write((const char *)&size, sizeof(size));
+    file.write(payload.data(), payload.size());
+}
+
+void
+Columnar::writeSchema()
+{
+    static const std::vector<std::string> no_names;
+
+    std::string buf;
+    appendValue(buf, (uint32_t)columns.size());
+    for (const auto &column : columns) {
+        const Info &info = *column.info;
+        const std::vector<std::string> *subnames = &no_names;
+        const std::vector<std::string> *y_subnames = &no_names;
+        uint32_t x = 0, y = 0;
+        const DistData *dist = nullptr;
+
+        switch (column.kind) {
+          case VectorKind:
+          case FormulaKind:
+            subnames = &static_cast<const VectorInfo &>(info).subnames;
+            x = column.numValues;
+            break;
+          case DistKind:
+            dist = &static_cast<const DistInfo &>(info).data;
+            break;
+          case VectorDistKind: {
+              const auto &vdist = static_cast<const VectorDistInfo &>(info);
+              subnames = &vdist.subnames;
+              x = vdist.data.size();
+              if (!vdist.data.empty())
+                  dist = &vdist.data.front();
+            }
+            break;
+          case Vector2dKind: {
+              const auto &v2d = static_cast<const Vector2dInfo &>(info);
+              subnames = &v2d.subnames;
+              y_subnames = &v2d.y_subnames;
+              x = v2d.x;
+              y = v2d.y;
+            }
+            break;
+          default:
+            break;
+        }
+
+        appendString(buf, column.name);
+        appendValue(buf, column.kind);
+        appendValue(buf, (uint32_t)column.numValues);
+        appendString(buf, enableDescriptions ? info.desc : "");
+        appendStrings(buf, *subnames);
+        appendStrings(buf, *y_subnames);
+        appendValue(buf, x);
+        appendValue(buf, y);
+        appendValue(buf, (uint8_t)(dist ? dist->type : Deviation));
+        appendValue(buf, dist ? dist->min : 0.0);
+        appendValue(buf, dist ? dist->max : 0.0);
+        appendValue(buf, dist ? dist->bucket_size : 0.0);
+    }
+
+    writeRecord(SchemaRecord, buf);
+}
+
+void
+Columnar::writeData()
+{
+    const uint64_t raw_size = values.size() * sizeof(double);
+    std::string buf;
+    appendValue(buf, dumpCount);
+
+    if (!enableCompression) {
+        buf.append((const char *)values.data(), raw_size);
+        writeRecord(DataRecord, buf);
+        return;
+    }
+
+    // XOR with the previous dump, so that the values that did not
+    // change compress to almost nothing
+    prevValues.resize(values.size(), 0.0);
+    std::vector<uint64_t> delta(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        uint64_t cur, prev;
+        memcpy(&cur, &values[i], sizeof(cur));
+        memcpy(&prev, &prevValues[i], sizeof(prev));
+        delta[i] = cur ^ prev;
+    }
+    prevValues = values;
+
+    appendValue(buf, raw_size);
+    const size_t header_size = buf.size();
+    uLongf compressed_size = compressBound(raw_size);
+    buf.resize(header_size + compressed_size);
+    if (compress2((Bytef *)&buf[header_size], &compressed_size,
+                  (const Bytef *)delta.data(), raw_size,
+                  Z_BEST_SPEED) != Z_OK) {
+        panic("Failed to compress stats dump %d\n", dumpCount);
+    }
+    buf.resize(header_size + compressed_size);
+
+    writeRecord(CompressedDataRecord, buf);
+}
+
+std::unique_ptr<Output>
+initColumnar(const std::string &filename, bool desc, bool formulas,
+             bool compress)
+{
+    return std::unique_ptr<Output>(
+        new Columnar(simout.resolve(filename), desc, formulas, compress));
+}
+
+} // namespace Stats
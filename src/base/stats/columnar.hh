@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BASE_STATS_COLUMNAR_HH__
+#define __BASE_STATS_COLUMNAR_HH__
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/stats/output.hh"
+#include "base/stats/types.hh"
+
+namespace Stats {
+
+class Info;
+struct DistData;
+
+/**
+ * Binary, columnar statistics output.
+ *
+ * The names and shapes of the stats are written once, as a schema,
+ * and each dump then only writes the values of all the stats as one
+ * array of doubles in the order of the schema. This makes dumps
+ * cheap enough to collect fine grained time series. A new schema is
+ * only written when the set of stats changes between two dumps.
+ *
+ * The file starts with a FileHeader, followed by records, each made
+ * of a one byte RecordType, a 64-bit payload size and the
+ * payload. All fields are in host byte order, and strings are
+ * stored as a 32-bit size followed by the characters.
+ *
+ * A schema record holds the number of stats followed by, for every
+ * stat, its name, Kind, number of values, description, subnames,
+ * y subnames, x and y sizes (32-bit), distribution type (8-bit) and
+ * the min, max and bucket size of distributions (doubles).
+ *
+ * A data record holds the index of the dump (64-bit) followed by the
+ * values. In a compressed data record, the values are first XORed
+ * with the values of the previous dump using the same schema, which
+ * turns the stats that did not change into zeros, then compressed
+ * with zlib. The index of the dump is followed by the size of the
+ * uncompressed values (64-bit) and the compressed data.
+ *
+ * Distributions are stored as the number of samples, sum, sum of
+ * squares, sum of logs, min value, max value, underflow and overflow
+ * followed by the buckets. Sparse histograms are not supported.
+ */
+class Columnar : public Output
+{
+  public:
+    /** Header at the start of a columnar stats file. */
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+    };
+
+    static const char magic[8];
+    static const uint32_t version = 1;
+
+    /** Flag set in the header when data records are compressed. */
+    static const uint32_t compressedFlag = 0x1;
+
+    enum RecordType : uint8_t
+    {
+        SchemaRecord = 'S',
+        DataRecord = 'D',
+        CompressedDataRecord = 'Z',
+    };
+
+    enum Kind : uint8_t
+    {
+        ScalarKind = 0,
+        VectorKind = 1,
+        DistKind = 2,
+        VectorDistKind = 3,
+        Vector2dKind = 4,
+        FormulaKind = 5,
+    };
+
+    /** Number of values stored for a distribution before its buckets. */
+    static const size_type distFields = 8;
+
+  public:
+    Columnar(const std::string &file, bool desc, bool formulas,
+             bool compress);
+
+    ~Columnar();
+
+    Columnar() = delete;
+    Columnar(const Columnar &other) = delete;
+
+  public: // Output interface
+    void begin() override;
+    void end() override;
+    bool valid() const override;
+
+    void beginGroup(const char *name) override;
+    void endGroup() override;
+
+    void visit(const ScalarInfo &info) override;
+    void visit(const VectorInfo &info) override;
+    void visit(const DistInfo &info) override;
+    void visit(const VectorDistInfo &info) override;
+    void visit(const Vector2dInfo &info) override;
+    void visit(const FormulaInfo &info) override;
+    void visit(const SparseHistInfo &info) override;
+
+  protected:
+    /** A stat in the schema. */
+    struct Column
+    {
+        const Info *info;
+        /**
+         * Id of the stat, which unlike the Info pointer also
+         * identifies stats copied by an AsyncOutput.
+         */
+        int id;
+        Kind kind;
+        size_type numValues;
+        std::string name;
+    };
+
+    /**
+     * Check the stat about to be added at the end of the current dump
+     * against the schema, and start a new schema if it differs.
+     *
+     * @param info The stat.
+     * @param kind The kind of the stat.
+     * @param num_values Number of values added for the stat.
+     */
+    void addColumn(const Info &info, Kind kind, size_type num_values);
+
+    /** Append the values of a distribution to the current dump. */
+    void appendDist(const DistData &data);
+
+    /** Write a record to the file. */
+    void writeRecord(RecordType type, const std::string &payload);
+
+    /** Write the schema of the current dump. */
+    void writeSchema();
+
+    /** Write the values of the current dump. */
+    void writeData();
+
+  protected:
+    const std::string fname;
+    const bool enableDescriptions;
+    const bool enableFormula;
+    const bool enableCompression;
+
+    std::ofstream file;
+
+    /** Names of the enclosing groups, separated by dots. */
+    std::vector<std::string> path;
+
+    /** Schema of the last dump written. */
+    std::vector<Column> columns;
+
+    /** Schema of the current dump, if it differs from columns. */
+    std::vector<Column> newColumns;
+
+    /** Whether the schema of the current dump differs. */
+    bool schemaChanged;
+
+    /** Number of stats added to the current dump so far. */
+    size_t curColumn;
+
+    /** Values of the current dump. */
+    std::vector<double> values;
+
+    /** Values of the previous dump, for compressed records. */
+    std::vector<double> prevValues;
+
+    uint64_t dumpCount;
+};
+
+std::unique_ptr<Output> initColumnar(const std::string &filename,
+                                     bool desc = true, bool formulas = true,
+                                     bool compress = true);
+
+} // namespace Stats
+
+#endif // __BASE_STATS_COLUMNAR_HH__
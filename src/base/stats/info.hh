@@ -59,6 +59,11 @@ const FlagsType nozero =        0x0100;
 const FlagsType nonan =         0x0200;
 /** Print all values on a single line. Useful only for histograms. */
 const FlagsType oneline =       0x0400;
+/**
+ * Detailed stat, which is only updated and printed when detailed
+ * stats are enabled, see STATS_DETAILED.
+ */
+const FlagsType detailed =      0x0800;
 
 /** Mask of flags that can't be set directly */
 const FlagsType __reserved =    init | display;
@@ -170,13 +175,17 @@ class VectorInfo : public Info
     virtual Result total() const = 0;
 };
 
-enum DistType { Deviation, Dist, Hist };
+enum DistType { Deviation, Dist, Hist, Hdr };
 
 struct DistData
 {
     DistType type;
     Counter min;
     Counter max;
+    /**
+     * The number of values in each bucket, or the number of
+     * significant bits of an Hdr distribution.
+     */
     Counter bucket_size;
 
     Counter min_val;
@@ -190,6 +199,26 @@ struct DistData
     Counter samples;
 };
 
+/**
+ * @name Buckets of Hdr distributions, see HdrStor.
+ * @{
+ */
+/** The smallest value of a bucket. */
+Counter hdrBucketLow(size_type index, unsigned bits);
+/** The largest value of a bucket. */
+Counter hdrBucketHigh(size_type index, unsigned bits);
+/**
+ * Estimate a percentile of an Hdr distribution from its buckets. The
+ * estimate is the largest value of the bucket holding the percentile,
+ * so it is at most 2^(1-bits) away from the exact value.
+ *
+ * @param data The distribution.
+ * @param pct The percentile, between 0 and 100.
+ * @return The percentile, or NAN if nothing was sampled.
+ */
+Result hdrPercentile(const DistData &data, double pct);
+/** @} */
+
 class DistInfo : public Info
 {
   public:
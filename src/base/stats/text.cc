@@ -466,14 +466,30 @@ DistPrint::operator()(ostream &stream) const
     if (data.type == Deviation)
         return;
 
+    if (data.type == Hdr) {
+        static const struct {
+            const char *name;
+            double pct;
+        } percentiles[] = {
+            { "p50", 50 }, { "p90", 90 }, { "p99", 99 }, { "p99_9", 99.9 },
+        };
+        for (const auto &p : percentiles) {
+            print.name = base + p.name;
+            print.value = hdrPercentile(data, p.pct);
+            print(stream);
+        }
+    }
+
+    // Distributions with under and overflows
+    const bool bounded = data.type == Dist || data.type == Hdr;
     size_t size = data.cvec.size();
 
     Result total = 0.0;
-    if (data.type == Dist && data.underflow != NAN)
+    if (bounded && data.underflow != NAN)
         total += data.underflow;
     for (off_type i = 0; i < size; ++i)
         total += data.cvec[i];
-    if (data.type == Dist && data.overflow != NAN)
+    if (bounded && data.overflow != NAN)
         total += data.overflow;
 
     if (total) {
@@ -481,7 +497,7 @@ DistPrint::operator()(ostream &stream) const
         print.cdf = 0.0;
     }
 
-    if (data.type == Dist && data.underflow != NAN) {
+    if (bounded && data.underflow != NAN) {
         print.name = base + "underflows";
         print.update(data.underflow, total);
         print(stream);
@@ -492,11 +508,21 @@ DistPrint::operator()(ostream &stream) const
     }
 
     for (off_type i = 0; i < size; ++i) {
+        // Most of the many buckets of an HDR histogram are empty
+        if (data.type == Hdr && data.cvec[i] == 0)
+            continue;
+
         stringstream namestr;
         namestr << base;
 
-        Counter low = i * data.bucket_size + data.min;
-        Counter high = ::min(low + data.bucket_size - 1.0, data.max);
+        Counter low, high;
+        if (data.type == Hdr) {
+            low = hdrBucketLow(i, data.bucket_size);
+            high = hdrBucketHigh(i, data.bucket_size);
+        } else {
+            low = i * data.bucket_size + data.min;
+            high = ::min(low + data.bucket_size - 1.0, data.max);
+        }
         namestr << low;
         if (low < high)
             namestr << "-" << high;
@@ -514,7 +540,7 @@ DistPrint::operator()(ostream &stream) const
         stream << endl;
     }
 
-    if (data.type == Dist && data.overflow != NAN) {
+    if (bounded && data.overflow != NAN) {
         print.name = base + "overflows";
         print.update(data.overflow, total);
         print(stream);
@@ -523,13 +549,13 @@ DistPrint::operator()(ostream &stream) const
     print.pdf = NAN;
     print.cdf = NAN;
 
-    if (data.type == Dist && data.min_val != NAN) {
+    if (bounded && data.min_val != NAN) {
         print.name = base + "min_value";
         print.value = data.min_val;
         print(stream);
     }
 
-    if (data.type == Dist && data.max_val != NAN) {
+    if (bounded && data.max_val != NAN) {
         print.name = base + "max_value";
         print.value = data.max_val;
         print(stream);
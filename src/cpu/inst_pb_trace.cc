@@ -66,8 +66,16 @@ InstPBTraceRecord::dump()
         tracer.traceMem(staticInst, getAddr(), getSize(), getFlags());
 }
 
+InstPBTrace::InstPBTraceStats::InstPBTraceStats(InstPBTrace &tracer)
+    : Stats::Group(&tracer),
+    ADD_STAT(tracedInsts, "Number of instructions written to the trace"),
+    ADD_STAT(traceStalls, "Number of instructions whose writing waited "
+             "for the trace output")
+{
+}
+
 InstPBTrace::InstPBTrace(const InstPBTraceParams *p)
-    : InstTracer(p), buf(nullptr), bufSize(0), curMsg(nullptr)
+    : InstTracer(p), buf(nullptr), bufSize(0), curMsg(nullptr), stats(*this)
 {
     // Create our output file
     createTraceFile(p->file_name);
@@ -99,11 +107,8 @@ InstPBTrace::createTraceFile(std::string filename)
 void
 InstPBTrace::closeStreams()
 {
-    if (curMsg) {
-        traceStream->write(*curMsg);
-        delete curMsg;
-        curMsg = NULL;
-    }
+    if (curMsg)
+        writeCurMsg();
 
     if (!traceStream)
         return;
@@ -112,11 +117,35 @@ InstPBTrace::closeStreams()
     traceStream = NULL;
 }
 
+void
+InstPBTrace::writeCurMsg()
+{
+    const uint64_t stalls = traceStream->stalls();
+    traceStream->write(*curMsg);
+    ++stats.tracedInsts;
+    stats.traceStalls += traceStream->stalls() - stalls;
+
+    delete curMsg;
+    curMsg = NULL;
+}
+
 InstPBTrace::~InstPBTrace()
 {
     closeStreams();
 }
 
+DrainState
+InstPBTrace::drain()
+{
+    // The current instruction has committed, so write it out rather
+    // than waiting for the next one
+    if (curMsg)
+        writeCurMsg();
+    if (traceStream)
+        traceStream->flush();
+    return DrainState::Drained;
+}
+
 InstPBTraceRecord*
 InstPBTrace::getInstRecord(Tick when, ThreadContext *tc, const StaticInstPtr si,
                            TheISA::PCState pc, const StaticInstPtr mi)
@@ -134,9 +163,7 @@ InstPBTrace::traceInst(ThreadContext *tc, StaticInstPtr si, TheISA::PCState pc)
 {
     if (curMsg) {
         /// @todo if we are running multi-threaded I assume we'd need a lock here
-        traceStream->write(*curMsg);
-        delete curMsg;
-        curMsg = NULL;
+        writeCurMsg();
     }
 
     size_t instSize = si->asBytes(buf.get(), bufSize);
@@ -39,6 +39,7 @@
 #define __CPU_INST_PB_TRACE_HH__
 
 #include "arch/types.hh"
+#include "base/statistics.hh"
 #include "base/trace.hh"
 #include "base/types.hh"
 #include "cpu/static_inst_fwd.hh"
@@ -90,6 +91,9 @@ class InstPBTrace : public InstTracer
                                     StaticInstPtr si, TheISA::PCState pc, const
                                     StaticInstPtr mi = NULL) override;
 
+    /** Write out the trace so that it is complete so far. */
+    DrainState drain() override;
+
   protected:
     std::unique_ptr<uint8_t []> buf;
     size_t bufSize;
@@ -115,6 +119,10 @@ class InstPBTrace : public InstTracer
      */
     void closeStreams();
 
+    /** Write the current instruction message to the trace and delete it
+     */
+    void writeCurMsg();
+
     /** Write an instruction to the trace file
      * @param tc thread context for the cpu ID
      * @param si for the machInst and opClass
@@ -130,6 +138,20 @@ class InstPBTrace : public InstTracer
      */
     void traceMem(StaticInstPtr si, Addr a, Addr s, unsigned f);
 
+    struct InstPBTraceStats : public Stats::Group
+    {
+        InstPBTraceStats(InstPBTrace &tracer);
+
+        /** Number of instructions written to the trace */
+        Stats::Scalar tracedInsts;
+
+        /**
+         * Number of instructions whose writing waited for the
+         * compression and the I/O of the previous ones
+         */
+        Stats::Scalar traceStalls;
+    } stats;
+
     friend class InstPBTraceRecord;
 };
 } // namespace Trace
@@ -167,7 +167,7 @@ DefaultCommit<Impl>::regStats()
         .init(0,commitWidth,1)
         .name(name() + ".committed_per_cycle")
         .desc("Number of insts commited each cycle")
-        .flags(Stats::pdf)
+        .flags(Stats::pdf | Stats::detailed)
         ;
 
     instsCommitted
@@ -258,7 +258,7 @@ DefaultCommit<Impl>::regStats()
         .init(numThreads,Enums::Num_OpClass)
         .name(name() + ".op_class")
         .desc("Class of committed instruction")
-        .flags(total | pdf | dist)
+        .flags(total | pdf | dist | detailed)
         ;
     statCommittedInstType.ysubnames(Enums::OpClassStrings);
 
@@ -1042,7 +1042,8 @@ DefaultCommit<Impl>::commitInsts()
 
             if (commit_success) {
                 ++num_committed;
-                statCommittedInstType[tid][head_inst->opClass()]++;
+                STATS_DETAILED(
+                    statCommittedInstType[tid][head_inst->opClass()]++);
                 ppCommit->notify(head_inst);
 
                 changedROBNumEntries[tid] = true;
@@ -1137,7 +1138,7 @@ DefaultCommit<Impl>::commitInsts()
     }
 
     DPRINTF(CommitRate, "%i\n", num_committed);
-    numCommittedDist.sample(num_committed);
+    STATS_DETAILED(numCommittedDist.sample(num_committed));
 
     if (num_committed == commitWidth) {
         commitEligibleSamples++;
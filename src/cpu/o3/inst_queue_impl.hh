@@ -253,7 +253,7 @@ InstructionQueue<Impl>::regStats()
         .init(0,totalWidth,1)
         .name(name() + ".issued_per_cycle")
         .desc("Number of insts issued each cycle")
-        .flags(pdf)
+        .flags(pdf | detailed)
         ;
 /*
     dist_unissued
@@ -270,7 +270,7 @@ InstructionQueue<Impl>::regStats()
         .init(numThreads,Enums::Num_OpClass)
         .name(name() + ".FU_type")
         .desc("Type of FU issued")
-        .flags(total | pdf | dist)
+        .flags(total | pdf | dist | detailed)
         ;
     statIssuedInstType.ysubnames(Enums::OpClassStrings);
 
@@ -302,7 +302,7 @@ InstructionQueue<Impl>::regStats()
         .init(Num_OpClasses)
         .name(name() + ".fu_full")
         .desc("attempts to use FU when none available")
-        .flags(pdf | dist)
+        .flags(pdf | dist | detailed)
         ;
     for (int i=0; i < Num_OpClasses; ++i) {
         statFuBusy.subname(i, Enums::OpClassStrings[i]);
@@ -914,15 +914,15 @@ InstructionQueue<Impl>::scheduleReadyInsts()
             }
 
             listOrder.erase(order_it++);
-            statIssuedInstType[tid][op_class]++;
+            STATS_DETAILED(statIssuedInstType[tid][op_class]++);
         } else {
-            statFuBusy[op_class]++;
+            STATS_DETAILED(statFuBusy[op_class]++);
             fuBusy[tid]++;
             ++order_it;
         }
     }
 
-    numIssuedDist.sample(total_issued);
+    STATS_DETAILED(numIssuedDist.sample(total_issued));
     iqInstsIssued+= total_issued;
 
     // If we issued any instructions, tell the CPU we had activity.
@@ -159,7 +159,9 @@ ElasticTrace::fetchReqTrace(const RequestPtr &req)
     inst_fetch_pkt.set_addr(req->getPaddr());
     inst_fetch_pkt.set_size(req->getSize());
     // Write the message to the stream.
+    const uint64_t stalls = instTraceStream->stalls();
     instTraceStream->write(inst_fetch_pkt);
+    numTraceStalls += instTraceStream->stalls() - stalls;
 }
 
 void
@@ -785,6 +787,7 @@ ElasticTrace::writeDepTrace(uint32_t num_to_write)
     // Computational delay with respect to last completed dependency
     // List of physical register RAW dependencies - optional, repeated
     // Weight of a node equal to no. of filtered nodes before it - optional
+    const uint64_t stalls = dataTraceStream->stalls();
     uint16_t num_filtered_nodes = 0;
     depTraceItr dep_trace_itr(depTrace.begin());
     depTraceItr dep_trace_itr_start = dep_trace_itr;
@@ -874,6 +877,8 @@ ElasticTrace::writeDepTrace(uint32_t num_to_write)
         num_to_write--;
     }
     depTrace.erase(dep_trace_itr_start, dep_trace_itr);
+
+    numTraceStalls += dataTraceStream->stalls() - stalls;
 }
 
 void
@@ -929,6 +934,11 @@ ElasticTrace::regStats() {
         .name(name() + ".maxPhysRegDepMapSize")
         .desc("Maximum size of register dependency map")
         ;
+
+    numTraceStalls
+        .name(name() + ".numTraceStalls")
+        .desc("Number of trace writes that waited for the trace output")
+        ;
 }
 
 const std::string&
@@ -951,6 +961,18 @@ ElasticTrace::flushTraces()
     // Delete the stream objects
     delete dataTraceStream;
     delete instTraceStream;
+    dataTraceStream = nullptr;
+    instTraceStream = nullptr;
+}
+
+DrainState
+ElasticTrace::drain()
+{
+    if (dataTraceStream)
+        dataTraceStream->flush();
+    if (instTraceStream)
+        instTraceStream->flush();
+    return DrainState::Drained;
 }
 
 ElasticTrace*
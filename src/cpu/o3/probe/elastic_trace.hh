@@ -114,6 +114,9 @@ class ElasticTrace : public ProbeListenerObject
      */
     void flushTraces();
 
+    /** Flush the output streams so that the traces are complete so far. */
+    DrainState drain() override;
+
     /**
      * Take the fields of the request class object that are relevant to create
      * an instruction fetch request. It creates a protobuf message containing
@@ -552,5 +555,11 @@ class ElasticTrace : public ProbeListenerObject
      * */
     Stats::Scalar maxPhysRegDepMapSize;
 
+    /**
+     * Number of times writing to a trace waited for the compression
+     * and the I/O of the previous messages.
+     */
+    Stats::Scalar numTraceStalls;
+
 };
 #endif//__CPU_O3_PROBE_ELASTIC_TRACE_HH__
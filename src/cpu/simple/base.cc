@@ -681,6 +681,10 @@ BaseSimpleCPU::advancePC(const Fault &fault)
         } else {
             // Mis-predicted branch
             branchPred->squash(cur_sn, thread->pcState(), branching, curThread);
+            // The branch is committed as well, which leaves no history
+            // behind in case the predictor is taken over by another
+            // CPU.
+            branchPred->update(cur_sn, curThread);
             ++t_info.numBranchMispred;
         }
     }
@@ -0,0 +1,89 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from m5.params import *
+from m5.proxy import *
+from m5.SimObject import SimObject
+from m5.objects.ClockedObject import ClockedObject
+
+# Address patterns of the streams of a MultiStreamTrafficGen
+class TrafficStreamPattern(ScopedEnum): vals = [ 'linear', 'random' ]
+
+# An independent stream of requests of a MultiStreamTrafficGen, with
+# its own address pattern, address range, rate and stream ID. Every
+# stream gets a master ID of its own, so the memory system and the
+# statistics also tell the streams apart.
+class TrafficStream(SimObject):
+    type = 'TrafficStream'
+    cxx_header = "cpu/testers/traffic_gen/multi_stream_gen.hh"
+
+    system = Param.System(Parent.any, "System this stream is part of")
+
+    pattern = Param.TrafficStreamPattern('linear',
+                                         "Address pattern of the requests")
+    start_addr = Param.Addr(0, "Start address of the stream")
+    end_addr = Param.Addr("End address of the stream")
+    block_size = Param.Unsigned(64, "Size of the requests in bytes")
+
+    # The rate of the stream, set min_period == max_period for a fixed
+    # inter-transaction time
+    min_period = Param.Latency("Minimum time between two requests")
+    max_period = Param.Latency("Maximum time between two requests")
+
+    read_percent = Param.Percent(100, "Percentage of reads")
+    data_limit = Param.Addr(0, "Bytes to access before the stream is " \
+                            "done, 0 for no limit")
+    duration = Param.Latency('0ns', "Time to generate requests for, 0 " \
+                             "for no limit")
+
+    stream_id = Param.Int(-1, "Stream ID of the requests, -1 for none")
+    max_outstanding_reqs = Param.Unsigned(0, "Maximum number of " \
+                                          "outstanding requests of the " \
+                                          "stream, 0 for no limit")
+
+# A traffic generator driving many independent streams of requests
+# through a single port, e.g. to saturate a multi-channel memory
+# system or a network-on-chip without instantiating and wiring one
+# traffic generator per stream. The streams start in timing mode, and
+# are all simulated by the event queue of the generator.
+class MultiStreamTrafficGen(ClockedObject):
+    type = 'MultiStreamTrafficGen'
+    cxx_header = "cpu/testers/traffic_gen/multi_stream_gen.hh"
+
+    port = MasterPort("Master port")
+
+    system = Param.System(Parent.any, "System this generator is part of")
+
+    streams = VectorParam.TrafficStream([], "Streams of requests")
+
+    # Should requests respond to back-pressure or not, if true, the
+    # rate of a stream will be slowed down if its requests are not
+    # immediately accepted
+    elastic_req = Param.Bool(False,
+                             "Slow down requests in case of backpressure")
+
+    exit_when_done = Param.Bool(False, "Exit the simulation loop once " \
+                                "all the streams are done")
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cpu/testers/traffic_gen/multi_stream_gen.hh"
+
+#include "cpu/testers/traffic_gen/linear_gen.hh"
+#include "cpu/testers/traffic_gen/random_gen.hh"
+#include "debug/TrafficGen.hh"
+#include "params/MultiStreamTrafficGen.hh"
+#include "params/TrafficStream.hh"
+#include "sim/sim_exit.hh"
+#include "sim/stats.hh"
+#include "sim/system.hh"
+
+TrafficStream::TrafficStream(const TrafficStreamParams *p)
+    : SimObject(p),
+      system(p->system),
+      masterID(system->getMasterId(this)),
+      pattern(p->pattern),
+      startAddr(p->start_addr),
+      endAddr(p->end_addr),
+      blockSize(p->block_size),
+      minPeriod(p->min_period),
+      maxPeriod(p->max_period),
+      readPercent(p->read_percent),
+      dataLimit(p->data_limit),
+      duration(p->duration),
+      streamId(p->stream_id),
+      maxOutstandingReqs(p->max_outstanding_reqs),
+      owner(nullptr),
+      endTick(MaxTick),
+      blockedWaitingResp(false),
+      updateEvent([this]{ update(); }, name()),
+      stats(this)
+{
+    fatal_if(startAddr >= endAddr, "%s: The address range is empty.\n",
+             name());
+}
+
+void
+TrafficStream::bind(MultiStreamTrafficGen &gen)
+{
+    fatal_if(owner, "%s belongs to more than one traffic generator.\n",
+             name());
+    owner = &gen;
+}
+
+void
+TrafficStream::start()
+{
+    assert(owner && !generator);
+
+    const Tick gen_duration = duration ? duration : MaxTick;
+    switch (pattern) {
+      case TrafficStreamPattern::linear:
+        generator = std::make_shared<LinearGen>(
+            *this, masterID, gen_duration, startAddr, endAddr, blockSize,
+            system->cacheLineSize(), minPeriod, maxPeriod, readPercent,
+            dataLimit);
+        break;
+      case TrafficStreamPattern::random:
+        generator = std::make_shared<RandomGen>(
+            *this, masterID, gen_duration, startAddr, endAddr, blockSize,
+            system->cacheLineSize(), minPeriod, maxPeriod, readPercent,
+            dataLimit);
+        break;
+      default:
+        panic("%s: Unknown traffic stream pattern.\n", name());
+    }
+
+    endTick = duration ? curTick() + duration : MaxTick;
+    generator->enter();
+    scheduleUpdate(0);
+}
+
+void
+TrafficStream::stop()
+{
+    if (updateEvent.scheduled())
+        deschedule(updateEvent);
+    blockedWaitingResp = false;
+
+    if (generator) {
+        generator->exit();
+        generator.reset();
+    }
+}
+
+void
+TrafficStream::finish()
+{
+    DPRINTF(TrafficGen, "%s: Done generating requests.\n", name());
+    stop();
+    owner->streamDone();
+}
+
+void
+TrafficStream::update()
+{
+    if (curTick() >= endTick) {
+        finish();
+        return;
+    }
+
+    // Wait for a response if there are too many outstanding requests
+    if (maxOutstandingReqs && waitingResp.size() >= maxOutstandingReqs) {
+        blockedWaitingResp = true;
+        return;
+    }
+
+    PacketPtr pkt = generator->getNextPacket();
+    if (streamId >= 0)
+        pkt->req->setStreamId(streamId);
+
+    assert(pkt->needsResponse());
+    assert(waitingResp.find(pkt->req) == waitingResp.end());
+    waitingResp[pkt->req] = curTick();
+    ++stats.numPackets;
+
+    // Otherwise wait for the packet to be sent
+    if (owner->sendPacket(*this, pkt))
+        scheduleUpdate(0);
+}
+
+void
+TrafficStream::scheduleUpdate(Tick delay)
+{
+    const Tick next = generator->nextPacketTick(owner->elasticReq, delay);
+    if (next == MaxTick || next >= endTick) {
+        finish();
+        return;
+    }
+
+    schedule(updateEvent, std::max(curTick(), next));
+}
+
+void
+TrafficStream::retrySent(Tick delay)
+{
+    stats.retryTicks += delay;
+
+    // The stream may have been stopped while the packet was waiting
+    if (generator)
+        scheduleUpdate(delay);
+}
+
+void
+TrafficStream::recvResponse(PacketPtr pkt)
+{
+    auto iter = waitingResp.find(pkt->req);
+    panic_if(iter == waitingResp.end(), "%s: "
+             "Received unexpected response [%s reqPtr=%x]\n",
+             name(), pkt->print(), pkt->req);
+    assert(iter->second <= curTick());
+
+    if (pkt->isWrite()) {
+        ++stats.totalWrites;
+        stats.bytesWritten += pkt->req->getSize();
+        stats.totalWriteLatency += curTick() - iter->second;
+    } else {
+        ++stats.totalReads;
+        stats.bytesRead += pkt->req->getSize();
+        stats.totalReadLatency += curTick() - iter->second;
+    }
+
+    waitingResp.erase(iter);
+
+    if (blockedWaitingResp) {
+        blockedWaitingResp = false;
+        schedule(updateEvent, curTick());
+    }
+}
+
+TrafficStream::StreamStats::StreamStats(Stats::Group *parent)
+    : Stats::Group(parent),
+      ADD_STAT(numPackets, "Number of packets generated"),
+      ADD_STAT(retryTicks, "Time spent waiting due to back-pressure (ticks)"),
+      ADD_STAT(bytesRead, "Number of bytes read"),
+      ADD_STAT(bytesWritten, "Number of bytes written"),
+      ADD_STAT(totalReadLatency, "Total latency of read requests"),
+      ADD_STAT(totalWriteLatency, "Total latency of write requests"),
+      ADD_STAT(totalReads, "Total num of reads"),
+      ADD_STAT(totalWrites, "Total num of writes"),
+      ADD_STAT(avgReadLatency, "Avg latency of read requests",
+               totalReadLatency / totalReads),
+      ADD_STAT(avgWriteLatency, "Avg latency of write requests",
+               totalWriteLatency / totalWrites),
+      ADD_STAT(readBW, "Read bandwidth in bytes/s",
+               bytesRead / simSeconds),
+      ADD_STAT(writeBW, "Write bandwidth in bytes/s",
+               bytesWritten / simSeconds)
+{
+}
+
+TrafficStream *
+TrafficStreamParams::create()
+{
+    return new TrafficStream(this);
+}
+
+MultiStreamTrafficGen::MultiStreamTrafficGen(
+    const MultiStreamTrafficGenParams *p)
+    : ClockedObject(p),
+      elasticReq(p->elastic_req),
+      system(p->system),
+      port(name() + ".port", *this),
+      streams(p->streams),
+      exitWhenDone(p->exit_when_done),
+      numActiveStreams(0),
+      stats(this)
+{
+    fatal_if(streams.empty(), "%s has no traffic streams.\n", name());
+
+    for (auto stream : streams) {
+        stream->bind(*this);
+        streamsByMaster[stream->masterId()] = stream;
+    }
+}
+
+Port &
+MultiStreamTrafficGen::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "port") {
+        return port;
+    } else {
+        return ClockedObject::getPort(if_name, idx);
+    }
+}
+
+void
+MultiStreamTrafficGen::init()
+{
+    ClockedObject::init();
+
+    if (!port.isConnected())
+        fatal("The port of %s is not connected!\n", name());
+
+    for (auto stream : streams) {
+        fatal_if(stream->eventQueue() != eventQueue(),
+                 "%s is not on the event queue of %s.\n",
+                 stream->name(), name());
+    }
+}
+
+void
+MultiStreamTrafficGen::initState()
+{
+    ClockedObject::initState();
+
+    // when not restoring from a checkpoint, make sure we kick things off
+    if (system->isTimingMode()) {
+        DPRINTF(TrafficGen, "Timing mode, activating %d streams\n",
+                streams.size());
+        numActiveStreams = streams.size();
+        for (auto stream : streams)
+            stream->start();
+    } else {
+        DPRINTF(TrafficGen,
+                "Traffic generator is only active in timing mode\n");
+    }
+}
+
+DrainState
+MultiStreamTrafficGen::drain()
+{
+    // shut things down, the packets waiting for a retry still have to
+    // be sent
+    for (auto stream : streams)
+        stream->stop();
+    numActiveStreams = 0;
+
+    return retryQueue.empty() ? DrainState::Drained : DrainState::Draining;
+}
+
+bool
+MultiStreamTrafficGen::sendPacket(TrafficStream &stream, PacketPtr pkt)
+{
+    // Only send if no packet is waiting for a retry, so that the
+    // streams keep the order in which they generated their packets
+    if (retryQueue.empty() && port.sendTimingReq(pkt))
+        return true;
+
+    ++stats.numQueued;
+    retryQueue.push_back({&stream, pkt, curTick()});
+    return false;
+}
+
+void
+MultiStreamTrafficGen::recvReqRetry()
+{
+    DPRINTF(TrafficGen, "Received retry\n");
+    ++stats.numRetries;
+
+    while (!retryQueue.empty()) {
+        const QueuedPacket &queued = retryQueue.front();
+        if (!port.sendTimingReq(queued.pkt))
+            return;
+
+        TrafficStream *stream = queued.stream;
+        const Tick delay = curTick() - queued.tick;
+        retryQueue.pop_front();
+        stream->retrySent(delay);
+    }
+
+    if (drainState() == DrainState::Draining)
+        signalDrainDone();
+}
+
+bool
+MultiStreamTrafficGen::recvTimingResp(PacketPtr pkt)
+{
+    auto iter = streamsByMaster.find(pkt->req->masterId());
+    panic_if(iter == streamsByMaster.end(), "%s: "
+             "Received response of unknown master %d\n",
+             name(), pkt->req->masterId());
+
+    iter->second->recvResponse(pkt);
+    delete pkt;
+
+    return true;
+}
+
+void
+MultiStreamTrafficGen::streamDone()
+{
+    assert(numActiveStreams > 0);
+    if (--numActiveStreams == 0 && exitWhenDone)
+        exitSimLoop(name() + " is done generating requests");
+}
+
+MultiStreamTrafficGen::GenStats::GenStats(Stats::Group *parent)
+    : Stats::Group(parent),
+      ADD_STAT(numRetries, "Number of retries"),
+      ADD_STAT(numQueued, "Number of packets that waited for a retry")
+{
+}
+
+MultiStreamTrafficGen *
+MultiStreamTrafficGenParams::create()
+{
+    return new MultiStreamTrafficGen(this);
+}
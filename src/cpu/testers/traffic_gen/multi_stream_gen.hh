@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CPU_TRAFFIC_GEN_MULTI_STREAM_GEN_HH__
+#define __CPU_TRAFFIC_GEN_MULTI_STREAM_GEN_HH__
+
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "enums/TrafficStreamPattern.hh"
+#include "mem/port.hh"
+#include "sim/clocked_object.hh"
+#include "sim/sim_object.hh"
+
+class BaseGen;
+class MultiStreamTrafficGen;
+class System;
+struct MultiStreamTrafficGenParams;
+struct TrafficStreamParams;
+
+/**
+ * An independent stream of requests of a MultiStreamTrafficGen, with
+ * its own address pattern, address range, rate, stream ID and
+ * statistics. Every stream has a MasterID of its own, and an update
+ * event on the event queue of its generator.
+ */
+class TrafficStream : public SimObject
+{
+  public:
+    TrafficStream(const TrafficStreamParams *p);
+
+    /** Attach the stream to the generator sending its requests. */
+    void bind(MultiStreamTrafficGen &owner);
+
+    /** Start generating requests. */
+    void start();
+
+    /** Stop generating requests for good. */
+    void stop();
+
+    /** Whether the stream is generating requests. */
+    bool active() const { return (bool)generator; }
+
+    MasterID masterId() const { return masterID; }
+
+    /**
+     * Notify the stream that its packet waiting for a retry of the
+     * port was sent.
+     *
+     * @param delay Time the packet spent waiting
+     */
+    void retrySent(Tick delay);
+
+    /** Handle the response to a request of the stream. */
+    void recvResponse(PacketPtr pkt);
+
+  private:
+    /** Generate the next packet and try to send it. */
+    void update();
+
+    /**
+     * Schedule the next update, or finish the stream if it has no
+     * packets left.
+     *
+     * @param delay Time the previous packet spent waiting
+     */
+    void scheduleUpdate(Tick delay);
+
+    /** Stop the stream and tell the generator. */
+    void finish();
+
+    System *const system;
+
+    const MasterID masterID;
+
+    const TrafficStreamPattern pattern;
+    const Addr startAddr;
+    const Addr endAddr;
+    const Addr blockSize;
+    const Tick minPeriod;
+    const Tick maxPeriod;
+    const uint8_t readPercent;
+    const Addr dataLimit;
+
+    /** Time to generate requests for, 0 for no limit. */
+    const Tick duration;
+
+    /** Stream ID of the requests, negative for none. */
+    const int streamId;
+
+    /** Maximum number of outstanding requests, 0 for no limit. */
+    const unsigned maxOutstandingReqs;
+
+    /** Generator sending the requests. */
+    MultiStreamTrafficGen *owner;
+
+    /** Address pattern of the stream, null when not active. */
+    std::shared_ptr<BaseGen> generator;
+
+    /** Tick at which the stream stops generating requests. */
+    Tick endTick;
+
+    /** Set when waiting for responses before generating requests. */
+    bool blockedWaitingResp;
+
+    /** Issue tick of the requests waiting for a response. */
+    std::unordered_map<RequestPtr, Tick> waitingResp;
+
+    EventFunctionWrapper updateEvent;
+
+    struct StreamStats : public Stats::Group
+    {
+        StreamStats(Stats::Group *parent);
+
+        /** Count the number of generated packets. */
+        Stats::Scalar numPackets;
+
+        /** Count the time incurred from back-pressure. */
+        Stats::Scalar retryTicks;
+
+        /** Count the number of bytes read. */
+        Stats::Scalar bytesRead;
+
+        /** Count the number of bytes written. */
+        Stats::Scalar bytesWritten;
+
+        /** Total num of ticks read reqs took to complete  */
+        Stats::Scalar totalReadLatency;
+
+        /** Total num of ticks write reqs took to complete  */
+        Stats::Scalar totalWriteLatency;
+
+        /** Count the number reads. */
+        Stats::Scalar totalReads;
+
+        /** Count the number writes. */
+        Stats::Scalar totalWrites;
+
+        /** Avg num of ticks each read req took to complete  */
+        Stats::Formula avgReadLatency;
+
+        /** Avg num of ticks each write reqs took to complete  */
+        Stats::Formula avgWriteLatency;
+
+        /** Read bandwidth in bytes/s  */
+        Stats::Formula readBW;
+
+        /** Write bandwidth in bytes/s  */
+        Stats::Formula writeBW;
+    } stats;
+};
+
+/**
+ * A traffic generator driving many independent TrafficStreams through
+ * a single master port, e.g. to saturate a multi-channel memory
+ * system or a network-on-chip without one traffic generator per
+ * stream. The streams share the port in the order they generate their
+ * packets: once the port refuses a packet, the packets of all the
+ * streams queue up until the port asks for a retry, and the streams
+ * resume as their packets are sent.
+ *
+ * All the streams are simulated by the event queue of the generator.
+ */
+class MultiStreamTrafficGen : public ClockedObject
+{
+  public:
+    MultiStreamTrafficGen(const MultiStreamTrafficGenParams *p);
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+
+    void init() override;
+
+    void initState() override;
+
+    DrainState drain() override;
+
+    /**
+     * Send a packet of a stream, or queue it if the port is waiting
+     * for a retry.
+     *
+     * @param stream The stream the packet belongs to
+     * @param pkt The packet to send
+     * @return True if the packet was sent, false if it was queued
+     */
+    bool sendPacket(TrafficStream &stream, PacketPtr pkt);
+
+    /** Notify the generator that a stream generated all its requests. */
+    void streamDone();
+
+    /**
+     * Determine whether to add elasticity in the request injection,
+     * thus responding to backpressure by slowing things down.
+     */
+    const bool elasticReq;
+
+  private:
+    /** Master port specialisation for the traffic generator */
+    class GenPort : public MasterPort
+    {
+      public:
+        GenPort(const std::string& name, MultiStreamTrafficGen& gen)
+            : MasterPort(name, &gen), gen(gen)
+        { }
+
+      protected:
+        void recvReqRetry() override { gen.recvReqRetry(); }
+
+        bool recvTimingResp(PacketPtr pkt) override
+        { return gen.recvTimingResp(pkt); }
+
+        void recvTimingSnoopReq(PacketPtr pkt) override { }
+
+        void recvFunctionalSnoop(PacketPtr pkt) override { }
+
+        Tick recvAtomicSnoop(PacketPtr pkt) override { return 0; }
+
+      private:
+        MultiStreamTrafficGen& gen;
+    };
+
+    /** Send the queued packets until the port refuses one. */
+    void recvReqRetry();
+
+    bool recvTimingResp(PacketPtr pkt);
+
+    System *const system;
+
+    GenPort port;
+
+    /** The streams, and the same indexed by MasterID. */
+    std::vector<TrafficStream *> streams;
+    std::unordered_map<MasterID, TrafficStream *> streamsByMaster;
+
+    /** A packet waiting for a retry of the port. */
+    struct QueuedPacket
+    {
+        TrafficStream *stream;
+        PacketPtr pkt;
+        /** Tick when the packet was meant to be sent. */
+        Tick tick;
+    };
+
+    /** Packets waiting for a retry, in the order they were generated. */
+    std::deque<QueuedPacket> retryQueue;
+
+    /** Whether to exit the simulation loop when all streams are done. */
+    const bool exitWhenDone;
+
+    /** Number of streams still generating requests. */
+    unsigned numActiveStreams;
+
+    struct GenStats : public Stats::Group
+    {
+        GenStats(Stats::Group *parent);
+
+        /** Count the number of retries. */
+        Stats::Scalar numRetries;
+
+        /** Count the number of packets queued waiting for a retry. */
+        Stats::Scalar numQueued;
+    } stats;
+};
+
+#endif //__CPU_TRAFFIC_GEN_MULTI_STREAM_GEN_HH__
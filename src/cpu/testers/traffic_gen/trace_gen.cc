@@ -45,17 +45,30 @@
 #include "proto/packet.pb.h"
 
 TraceGen::InputStream::InputStream(const std::string& filename)
-    : trace(filename)
 {
+    if (PacketTrace::isBinaryTrace(filename)) {
+        binaryTrace.reset(new PacketTrace::Reader(filename));
+    } else {
+        trace.reset(
+            new ProtoReadAheadStream<ProtoMessage::Packet>(filename));
+    }
     init();
 }
 
 void
 TraceGen::InputStream::init()
 {
+    if (binaryTrace) {
+        if (binaryTrace->tickFreq() != SimClock::Frequency) {
+            panic("Trace was recorded with a different tick frequency %d\n",
+                  binaryTrace->tickFreq());
+        }
+        return;
+    }
+
     // Create a protobuf message for the header and read it from the stream
     ProtoMessage::PacketHeader header_msg;
-    if (!trace.read(header_msg)) {
+    if (!trace->readHeader(header_msg)) {
         panic("Failed to read packet header from trace\n");
     } else if (header_msg.tick_freq() != SimClock::Frequency) {
         panic("Trace was recorded with a different tick frequency %d\n",
@@ -66,15 +79,32 @@ TraceGen::InputStream::init()
 void
 TraceGen::InputStream::reset()
 {
-    trace.reset();
+    if (binaryTrace) {
+        binaryTrace->reset();
+        return;
+    }
+
+    trace->reset();
     init();
 }
 
 bool
 TraceGen::InputStream::read(TraceElement& element)
 {
+    if (binaryTrace) {
+        PacketTrace::Packet pkt;
+        if (!binaryTrace->read(pkt))
+            return false;
+        element.cmd = pkt.cmd;
+        element.addr = pkt.addr;
+        element.blocksize = pkt.size;
+        element.tick = pkt.tick;
+        element.flags = pkt.flags;
+        return true;
+    }
+
     ProtoMessage::Packet pkt_msg;
-    if (trace.read(pkt_msg)) {
+    if (trace->read(pkt_msg)) {
         element.cmd = pkt_msg.cmd();
         element.addr = pkt_msg.addr();
         element.blocksize = pkt_msg.size();
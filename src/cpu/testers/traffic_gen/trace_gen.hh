@@ -44,10 +44,14 @@
 #ifndef __CPU_TRAFFIC_GEN_TRACE_GEN_HH__
 #define __CPU_TRAFFIC_GEN_TRACE_GEN_HH__
 
+#include <memory>
+
 #include "base/bitfield.hh"
 #include "base/intmath.hh"
 #include "base_gen.hh"
 #include "mem/packet.hh"
+#include "mem/packet_trace.hh"
+#include "proto/packet.pb.h"
 #include "proto/protoio.hh"
 
 /**
@@ -107,13 +111,17 @@ class TraceGen : public BaseGen
 
       private:
 
-        /// Input file stream for the protobuf trace
-        ProtoInputStream trace;
+        /// Input file stream for the protobuf trace, decoded ahead
+        std::unique_ptr<ProtoReadAheadStream<ProtoMessage::Packet>> trace;
+
+        /// Input file for a binary trace, used instead of the above
+        std::unique_ptr<PacketTrace::Reader> binaryTrace;
 
       public:
 
         /**
-         * Create a trace input stream for a given file name.
+         * Create a trace input stream for a given file name. The
+         * trace is either a protobuf trace or a binary packet trace.
          *
          * @param filename Path to the file to read from
          */
@@ -40,7 +40,7 @@
 #include "sim/sim_exit.hh"
 
 // Declare and initialize the static counter for number of trace CPUs.
-int TraceCPU::numTraceCPUs = 0;
+std::atomic<int> TraceCPU::numTraceCPUs(0);
 
 TraceCPU::TraceCPU(TraceCPUParams *params)
     :   BaseCPU(params),
@@ -57,7 +57,8 @@ TraceCPU::TraceCPU(TraceCPUParams *params)
         dcacheNextEvent([this]{ schedDcacheNext(); }, name()),
         oneTraceComplete(false),
         traceOffset(0),
-        execCompleteEvent(nullptr),
+        execCompleteEvent([this]{ execComplete(); }, name(), false,
+                          Event::Sim_Exit_Pri),
         enableEarlyExit(params->enableEarlyExit),
         progressMsgInterval(params->progressMsgInterval),
         progressMsgThreshold(params->progressMsgInterval)
@@ -136,17 +137,6 @@ TraceCPU::init()
     // send its first request at the first event and schedule subsequent
     // events using a relative tick delta
     dcacheGen.adjustInitTraceOffset(traceOffset);
-
-    // If the Trace CPU simulation is configured to exit on any one trace
-    // completion then we don't need a counted event to count down all Trace
-    // CPUs in the system. If not then instantiate a counted event.
-    if (!enableEarlyExit) {
-        // The static counter for number of Trace CPUs is correctly set at
-        // this point so create an event and pass it.
-        execCompleteEvent = new CountedExitEvent("end of all traces reached.",
-                                                 numTraceCPUs);
-    }
-
 }
 
 void
@@ -204,11 +194,21 @@ TraceCPU::checkAndSchedExitEvent()
         if (enableEarlyExit) {
             exitSimLoop("End of trace reached");
         } else {
-            schedule(*execCompleteEvent, curTick());
+            schedule(execCompleteEvent, curTick());
         }
     }
 }
 
+void
+TraceCPU::execComplete()
+{
+    // The static counter for number of Trace CPUs is shared by all event
+    // queues, so only the last Trace CPU to complete sees it reach zero
+    if (--numTraceCPUs == 0) {
+        exitSimLoop("end of all traces reached.");
+    }
+}
+
 void
 TraceCPU::regStats()
 {
@@ -1259,7 +1259,7 @@ TraceCPU::ElasticDataGen::InputStream::InputStream(
 {
     // Create a protobuf message for the header and read it from the stream
     ProtoMessage::InstDepRecordHeader header_msg;
-    if (!trace.read(header_msg)) {
+    if (!trace.readHeader(header_msg)) {
         panic("Failed to read packet header from %s\n", filename);
 
         if (header_msg.tick_freq() != SimClock::Frequency) {
@@ -1465,7 +1465,7 @@ TraceCPU::FixedRetryGen::InputStream::InputStream(const std::string& filename)
 {
     // Create a protobuf message for the header and read it from the stream
     ProtoMessage::PacketHeader header_msg;
-    if (!trace.read(header_msg)) {
+    if (!trace.readHeader(header_msg)) {
         panic("Failed to read packet header from %s\n", filename);
 
         if (header_msg.tick_freq() != SimClock::Frequency) {
@@ -39,6 +39,7 @@
 #define __CPU_TRACE_TRACE_CPU_HH__
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <queue>
 #include <set>
@@ -132,9 +133,10 @@
  * Strictly-ordered requests are skipped and the dependencies on such requests
  * are handled by simply marking them complete immediately.
  *
- * A CountedExitEvent that contains a static int belonging to the Trace CPU
- * class as a down counter is used to implement multi Trace CPU simulation
- * exit.
+ * An event that decrements a static atomic counter belonging to the Trace
+ * CPU class is used to implement multi Trace CPU simulation exit. As the
+ * counter is atomic, the Trace CPUs and their private caches can be
+ * distributed over multiple event queues to replay the traces in parallel.
  */
 
 class TraceCPU : public BaseCPU
@@ -305,11 +307,11 @@ class TraceCPU : public BaseCPU
         void recvReqRetry();
 
         /**
-         * Required functionally.
+         * The snoops are ignored, so do not ask for them.
          *
-         * @return true since we have to snoop
+         * @return false since we do not act on snoops
          */
-        bool isSnooping() const { return true; }
+        bool isSnooping() const { return false; }
 
       private:
         TraceCPU* owner;
@@ -391,8 +393,8 @@ class TraceCPU : public BaseCPU
 
           private:
 
-            // Input file stream for the protobuf trace
-            ProtoInputStream trace;
+            // Input file stream for the protobuf trace, decoded ahead
+            ProtoReadAheadStream<ProtoMessage::Packet> trace;
 
           public:
 
@@ -790,8 +792,8 @@ class TraceCPU : public BaseCPU
 
           private:
 
-            /** Input file stream for the protobuf trace */
-            ProtoInputStream trace;
+            /** Input file stream for the protobuf trace, decoded ahead */
+            ProtoReadAheadStream<ProtoMessage::InstDepRecord> trace;
 
             /**
              * A multiplier for the compute delays in the trace to modulate
@@ -1095,19 +1097,23 @@ class TraceCPU : public BaseCPU
     Tick traceOffset;
 
     /**
-     * Number of Trace CPUs in the system used as a shared variable and passed
-     * to the CountedExitEvent event used for counting down exit events.  It is
-     * incremented in the constructor call so that the total is arrived at
-     * automatically.
+     * Number of Trace CPUs in the system used as a shared variable for
+     * counting down exit events. It is incremented in the constructor
+     * call so that the total is arrived at automatically. It is atomic
+     * as Trace CPUs on different event queues may complete at the same
+     * time.
      */
-    static int numTraceCPUs;
+    static std::atomic<int> numTraceCPUs;
 
    /**
-    * A CountedExitEvent which when serviced decrements the counter. A sim
-    * exit event is scheduled when the counter equals zero, that is all
+    * An event which when serviced decrements the counter. A sim exit
+    * event is scheduled when the counter equals zero, that is all
     * instances of Trace CPU have had their execCompleteEvent serviced.
     */
-    CountedExitEvent *execCompleteEvent;
+    EventFunctionWrapper execCompleteEvent;
+
+    /** Count down the completion of this Trace CPU. */
+    void execComplete();
 
     /**
      * Exit when any one Trace CPU completes its execution. If this is
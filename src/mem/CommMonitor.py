@@ -79,6 +79,15 @@ class CommMonitor(SimObject):
     itt_max_bin = Param.Latency('100ns', "Max bin of ITT distributions")
     disable_itt_dists = Param.Bool(False, "Disable ITT distributions")
 
+    # latency and ITT histograms with high dynamic range (HDR) buckets,
+    # which keep the same relative precision for all values up to the
+    # maximum instead of relying on tuned bins, and report the
+    # percentiles
+    hdr_bits = Param.Unsigned(0, "Significant bits of the buckets of HDR " \
+                                  "latency and ITT histograms, 0 to " \
+                                  "disable them")
+    hdr_max = Param.Latency('1ms', "Max latency and ITT of HDR histograms")
+
     # outstanding requests (that did not yet get a response) per
     # sample period
     outstanding_bins = Param.Unsigned('20', "# bins in outstanding " \
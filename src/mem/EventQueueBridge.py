@@ -0,0 +1,50 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from m5.params import *
+from m5.SimObject import SimObject
+
+# A pass-through letting the objects on its two sides be simulated by
+# different event queues, e.g. to simulate the CPUs in parallel with
+# the memory system. The slave side belongs to the event queue of the
+# bridge, set through eventq_index, and the master side to
+# mem_side_eventq_index. Packets are delivered at the tick they are
+# sent plus the delay, unless the receiving side has already gone past
+# it, as the event queues only synchronise at the end of each
+# simulation quantum. The late packets are counted in the stats of the
+# bridge, and none is late if the delay is at least one quantum. Snoops
+# cannot cross the bridge.
+class EventQueueBridge(SimObject):
+    type = 'EventQueueBridge'
+    cxx_header = "mem/eventq_bridge.hh"
+
+    master = MasterPort("Master port, facing the memory side")
+    slave = SlavePort("Slave port, facing the CPU side")
+
+    mem_side_eventq_index = Param.UInt32(0, "Event queue of the objects "
+                                         "on the memory side")
+
+    delay = Param.Latency('0ns', "Delay of the packets crossing the bridge")
@@ -123,6 +123,13 @@ class BaseCache(ClockedObject):
     # cache.
     writeback_clean = Param.Bool(False, "Writeback clean lines")
 
+    # Save the tags, state and dirty data of the cache in checkpoints,
+    # so that simulations restored from them start with a warm cache
+    # rather than needing a long warmup period. When disabled, the
+    # checkpoint only records whether the cache held dirty data.
+    checkpoint_contents = Param.Bool(False,
+        "Save and restore the cache contents in checkpoints")
+
     # Control whether this cache should be mostly inclusive or mostly
     # exclusive with respect to upstream caches. The behaviour on a
     # fill is determined accordingly. For a mostly inclusive cache,
@@ -141,6 +148,15 @@ class BaseCache(ClockedObject):
     # data cache.
     write_allocator = Param.WriteAllocator(NULL, "Write allocator")
 
+    # Record the miss latencies in a histogram with high dynamic range
+    # (HDR) buckets, which keep the same relative precision for all
+    # latencies up to the maximum and report the percentiles.
+    miss_latency_hdr_bits = Param.Unsigned(0,
+        "Significant bits of the buckets of the HDR miss latency " \
+        "histogram, 0 to disable it")
+    miss_latency_hdr_max = Param.Latency('1ms',
+        "Max latency of the HDR miss latency histogram")
+
 class Cache(BaseCache):
     type = 'Cache'
     cxx_header = 'mem/cache/cache.hh'
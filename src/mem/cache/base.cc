@@ -45,6 +45,9 @@
 
 #include "mem/cache/base.hh"
 
+#include <algorithm>
+#include <cstring>
+
 #include "base/compiler.hh"
 #include "base/logging.hh"
 #include "debug/Cache.hh"
@@ -56,6 +59,7 @@
 #include "mem/cache/mshr.hh"
 #include "mem/cache/prefetch/base.hh"
 #include "mem/cache/queue_entry.hh"
+#include "mem/cache/replacement_policies/base.hh"
 #include "mem/cache/tags/super_blk.hh"
 #include "params/BaseCache.hh"
 #include "params/WriteAllocator.hh"
@@ -81,9 +85,11 @@ BaseCache::BaseCache(const BaseCacheParams *p, unsigned blk_size)
       writeBuffer("write buffer", p->write_buffers, p->mshrs), // see below
       tags(p->tags),
       compressor(p->compressor),
+      replacementPolicy(p->replacement_policy),
       prefetcher(p->prefetcher),
       writeAllocator(p->write_allocator),
       writebackClean(p->writeback_clean),
+      checkpointContents(p->checkpoint_contents),
       tempBlockWriteback(nullptr),
       writebackTempBlockAtomicEvent([this]{ writebackTempBlockAtomic(); },
                                     name(), false,
@@ -103,6 +109,8 @@ BaseCache::BaseCache(const BaseCacheParams *p, unsigned blk_size)
       order(0),
       noTargetMSHR(nullptr),
       missCount(p->max_miss_count),
+      missLatencyHdrBits(p->miss_latency_hdr_bits),
+      missLatencyHdrMax(p->miss_latency_hdr_max),
       addrRanges(p->addr_ranges.begin(), p->addr_ranges.end()),
       system(p->system),
       stats(*this)
@@ -184,6 +192,47 @@ BaseCache::init()
     forwardSnoops = cpuSidePort.isSnooping();
 }
 
+void
+BaseCache::startup()
+{
+    // Read the data of the clean blocks restored from a checkpoint. The
+    // blocks are ignored by functional accesses until they are filled,
+    // so that the data comes from the memory below, or from another
+    // cache holding the line dirty, even if that cache has not been
+    // filled yet.
+    std::vector<const CacheBlk*> blks(unfilledBlks.begin(),
+                                      unfilledBlks.end());
+    for (const CacheBlk *const_blk : blks) {
+        CacheBlk *blk = const_cast<CacheBlk*>(const_blk);
+
+        RequestPtr request = std::make_shared<Request>(
+            regenerateBlkAddr(blk), blkSize, 0, Request::funcMasterId);
+
+        request->taskId(blk->task_id);
+        if (blk->isSecure()) {
+            request->setFlags(Request::SECURE);
+        }
+
+        Packet packet(request, MemCmd::ReadReq);
+        packet.dataStatic(blk->data);
+
+        memSidePort.sendFunctional(&packet);
+        unfilledBlks.erase(blk);
+
+        if (compressor) {
+            // The size was restored from the checkpoint, only the
+            // decompression latency is missing
+            Cycles compression_lat = Cycles(0);
+            Cycles decompression_lat = Cycles(0);
+            std::size_t size_bits = 0;
+            compressor->compress(packet.getConstPtr<uint64_t>(),
+                                 compression_lat, decompression_lat,
+                                 size_bits);
+            compressor->setDecompressionLatency(blk, decompression_lat);
+        }
+    }
+}
+
 Port &
 BaseCache::getPort(const std::string &if_name, PortID idx)
 {
@@ -271,7 +320,8 @@ BaseCache::handleTimingReqMiss(PacketPtr pkt, MSHR *mshr, CacheBlk *blk,
                         pkt->print());
 
                 assert(pkt->req->masterId() < system->maxMasters());
-                stats.cmdStats(pkt).mshr_hits[pkt->req->masterId()]++;
+                STATS_DETAILED(
+                    stats.cmdStats(pkt).mshr_hits[pkt->req->masterId()]++);
 
                 // We use forward_time here because it is the same
                 // considering new targets. We have multiple
@@ -295,7 +345,8 @@ BaseCache::handleTimingReqMiss(PacketPtr pkt, MSHR *mshr, CacheBlk *blk,
     } else {
         // no MSHR
         assert(pkt->req->masterId() < system->maxMasters());
-        stats.cmdStats(pkt).mshr_misses[pkt->req->masterId()]++;
+        STATS_DETAILED(
+            stats.cmdStats(pkt).mshr_misses[pkt->req->masterId()]++);
 
         if (pkt->isEviction() || pkt->cmd == MemCmd::WriteClean) {
             // We use forward_time here because there is an
@@ -438,17 +489,18 @@ BaseCache::recvTimingResp(PacketPtr pkt)
     }
 
     // Initial target is used just for stats
-    const QueueEntry::Target *initial_tgt = mshr->getTarget();
-    const Tick miss_latency = curTick() - initial_tgt->recvTime;
-    if (pkt->req->isUncacheable()) {
-        assert(pkt->req->masterId() < system->maxMasters());
-        stats.cmdStats(initial_tgt->pkt)
-            .mshr_uncacheable_lat[pkt->req->masterId()] += miss_latency;
-    } else {
+    STATS_DETAILED({
+        const QueueEntry::Target *initial_tgt = mshr->getTarget();
+        const Tick miss_latency = curTick() - initial_tgt->recvTime;
         assert(pkt->req->masterId() < system->maxMasters());
-        stats.cmdStats(initial_tgt->pkt)
-            .mshr_miss_latency[pkt->req->masterId()] += miss_latency;
-    }
+        if (pkt->req->isUncacheable()) {
+            stats.cmdStats(initial_tgt->pkt)
+                .mshr_uncacheable_lat[pkt->req->masterId()] += miss_latency;
+        } else {
+            stats.cmdStats(initial_tgt->pkt)
+                .mshr_miss_latency[pkt->req->masterId()] += miss_latency;
+        }
+    });
 
     PacketList writebacks;
 
@@ -634,7 +686,7 @@ BaseCache::functionalAccess(PacketPtr pkt, bool from_cpu_side)
     // we have it, but only declare it satisfied if we are the owner.
 
     // see if we have data at all (owned or otherwise)
-    bool have_data = blk && blk->isValid()
+    bool have_data = blk && blk->isValid() && !unfilledBlks.count(blk)
         && pkt->trySatisfyFunctional(&cbpw, blk_addr, is_secure, blkSize,
                                      blk->data);
 
@@ -775,7 +827,8 @@ BaseCache::getNextQueueEntry()
                 // Update statistic on number of prefetches issued
                 // (hwpf_mshr_misses)
                 assert(pkt->req->masterId() < system->maxMasters());
-                stats.cmdStats(pkt).mshr_misses[pkt->req->masterId()]++;
+                STATS_DETAILED(
+                    stats.cmdStats(pkt).mshr_misses[pkt->req->masterId()]++);
 
                 // allocate an MSHR and return it, note
                 // that we send the packet straight away, so do not
@@ -1782,21 +1835,78 @@ BaseCache::sendWriteQueuePacket(WriteQueueEntry* wq_entry)
 void
 BaseCache::serialize(CheckpointOut &cp) const
 {
-    bool dirty(isDirty());
+    if (!checkpointContents) {
+        bool dirty(isDirty());
+
+        if (dirty) {
+            warn("*** The cache still contains dirty data. ***\n");
+            warn("    Make sure to drain the system using the correct "
+                 "flags.\n");
+            warn("    This checkpoint will not restore correctly " \
+                 "and dirty data in the cache will be lost!\n");
+        }
 
-    if (dirty) {
-        warn("*** The cache still contains dirty data. ***\n");
-        warn("    Make sure to drain the system using the correct flags.\n");
-        warn("    This checkpoint will not restore correctly " \
-             "and dirty data in the cache will be lost!\n");
+        // Since we don't checkpoint the data in the cache, any dirty
+        // data will be lost when restoring from a checkpoint of a system
+        // that wasn't drained properly. Flag the checkpoint as invalid
+        // if the cache contains dirty data.
+        bool bad_checkpoint(dirty);
+        SERIALIZE_SCALAR(bad_checkpoint);
+        return;
     }
 
-    // Since we don't checkpoint the data in the cache, any dirty data
-    // will be lost when restoring from a checkpoint of a system that
-    // wasn't drained properly. Flag the checkpoint as invalid if the
-    // cache contains dirty data.
-    bool bad_checkpoint(dirty);
+    bool bad_checkpoint(false);
     SERIALIZE_SCALAR(bad_checkpoint);
+
+    // Save the blocks in insertion order, so that inserting them in
+    // the same order on restore approximates the original placement
+    // when the replacement state cannot be restored.
+    std::vector<const CacheBlk*> blks;
+    tags->forEachBlk([&blks](CacheBlk &blk) {
+        if (blk.isValid()) {
+            blks.push_back(&blk);
+        }
+    });
+    std::stable_sort(blks.begin(), blks.end(),
+        [](const CacheBlk *a, const CacheBlk *b) {
+            return a->tickInserted < b->tickInserted;
+        });
+
+    std::vector<Addr> blk_addr;
+    std::vector<unsigned> blk_status;
+    std::vector<int> blk_master;
+    std::vector<uint32_t> blk_task;
+    std::vector<unsigned> blk_refs;
+    std::vector<Tick> blk_inserted;
+    std::vector<uint64_t> blk_repl;
+    std::vector<uint64_t> blk_size_bits;
+    std::vector<uint8_t> blk_data;
+    for (const CacheBlk *blk : blks) {
+        blk_addr.push_back(tags->regenerateBlkAddr(blk));
+        blk_status.push_back(blk->status);
+        blk_master.push_back(blk->srcMasterId);
+        blk_task.push_back(blk->task_id);
+        blk_refs.push_back(blk->refCount);
+        blk_inserted.push_back(blk->tickInserted);
+        blk_repl.push_back(blk->replacementData ?
+            replacementPolicy->getState(blk->replacementData) : 0);
+        blk_size_bits.push_back(compressor ?
+            static_cast<const CompressionBlk*>(blk)->getSizeBits() :
+            blkSize * 8);
+        if (blk->isDirty()) {
+            blk_data.insert(blk_data.end(), blk->data, blk->data + blkSize);
+        }
+    }
+
+    SERIALIZE_CONTAINER(blk_addr);
+    SERIALIZE_CONTAINER(blk_status);
+    SERIALIZE_CONTAINER(blk_master);
+    SERIALIZE_CONTAINER(blk_task);
+    SERIALIZE_CONTAINER(blk_refs);
+    SERIALIZE_CONTAINER(blk_inserted);
+    SERIALIZE_CONTAINER(blk_repl);
+    SERIALIZE_CONTAINER(blk_size_bits);
+    SERIALIZE_CONTAINER(blk_data);
 }
 
 void
@@ -1809,8 +1919,135 @@ BaseCache::unserialize(CheckpointIn &cp)
               "supported in the classic memory system. Please remove any "
               "caches or drain them properly before taking checkpoints.\n");
     }
-}
 
+    // Checkpoints taken without the cache contents start cold
+    if (!cp.entryExists(Serializable::currentSection(), "blk_addr")) {
+        return;
+    }
+
+    std::vector<Addr> blk_addr;
+    std::vector<unsigned> blk_status;
+    std::vector<int> blk_master;
+    std::vector<uint32_t> blk_task;
+    std::vector<unsigned> blk_refs;
+    std::vector<Tick> blk_inserted;
+    std::vector<uint64_t> blk_repl;
+    std::vector<uint64_t> blk_size_bits;
+    std::vector<uint8_t> blk_data;
+    UNSERIALIZE_CONTAINER(blk_addr);
+    UNSERIALIZE_CONTAINER(blk_status);
+    UNSERIALIZE_CONTAINER(blk_master);
+    UNSERIALIZE_CONTAINER(blk_task);
+    UNSERIALIZE_CONTAINER(blk_refs);
+    UNSERIALIZE_CONTAINER(blk_inserted);
+    UNSERIALIZE_CONTAINER(blk_repl);
+    UNSERIALIZE_CONTAINER(blk_size_bits);
+    UNSERIALIZE_CONTAINER(blk_data);
+
+    const std::size_t num_blks = blk_addr.size();
+    fatal_if(blk_status.size() != num_blks ||
+             blk_master.size() != num_blks ||
+             blk_task.size() != num_blks ||
+             blk_refs.size() != num_blks ||
+             blk_inserted.size() != num_blks ||
+             blk_repl.size() != num_blks ||
+             blk_size_bits.size() != num_blks,
+             "%s: Inconsistent cache contents in checkpoint.\n", name());
+
+    const std::size_t num_dirty = std::count_if(
+        blk_status.begin(), blk_status.end(),
+        [](unsigned status) { return (status & BlkDirty) != 0; });
+    fatal_if(blk_data.size() != num_dirty * blkSize,
+             "%s: Checkpoint does not hold the data of %d dirty blocks of "
+             "%d bytes.\n", name(), num_dirty, blkSize);
+
+    if (!checkpointContents) {
+        fatal_if(num_dirty, "%s: Cannot ignore the cache contents in the "
+                 "checkpoint as they include dirty data.\n", name());
+        return;
+    }
+
+    // Insert the blocks oldest first, as they would have been filled
+    const uint8_t *data = blk_data.data();
+    for (std::size_t i = 0; i < num_blks; i++) {
+        const Addr addr = blk_addr[i];
+        const bool is_secure = blk_status[i] & BlkSecure;
+        const bool is_dirty = blk_status[i] & BlkDirty;
+        const uint8_t *blk_bytes = data;
+        if (is_dirty) {
+            data += blkSize;
+        }
+
+        std::vector<CacheBlk*> evict_blks;
+        CacheBlk *victim = tags->findVictim(addr, is_secure,
+                                            blk_size_bits[i], evict_blks);
+
+        // The cache may be smaller than the one that was checkpointed.
+        // Clean blocks can simply be dropped, but dirty data must not
+        // be lost.
+        bool can_evict = victim != nullptr;
+        for (const auto &blk : evict_blks) {
+            if (blk->isValid() && blk->isDirty()) {
+                can_evict = false;
+            }
+        }
+        if (!can_evict) {
+            fatal_if(is_dirty, "%s: Cannot restore dirty block %#x from "
+                     "checkpoint as there is no room for it.\n", name(),
+                     addr);
+            continue;
+        }
+        for (auto &blk : evict_blks) {
+            if (blk->isValid()) {
+                unfilledBlks.erase(blk);
+                invalidateBlock(blk);
+            }
+        }
+
+        // Use the same requestor as the original fill, if it exists
+        const MasterID master_id = blk_master[i] >= 0 &&
+            blk_master[i] < system->maxMasters() ?
+            blk_master[i] : Request::funcMasterId;
+        RequestPtr request = std::make_shared<Request>(
+            addr, blkSize, 0, master_id);
+        request->taskId(blk_task[i]);
+        if (is_secure) {
+            request->setFlags(Request::SECURE);
+        }
+        Packet packet(request, MemCmd::ReadReq);
+
+        if (compressor) {
+            compressor->setSizeBits(victim, blk_size_bits[i]);
+        }
+        tags->insertBlock(&packet, victim);
+
+        // Whether the block is stored compressed is decided on insertion
+        victim->status = (blk_status[i] & ~BlkCompressed) |
+            (victim->status & BlkCompressed);
+        victim->refCount = blk_refs[i];
+        victim->tickInserted = blk_inserted[i];
+        if (victim->replacementData) {
+            replacementPolicy->setState(victim->replacementData,
+                                        blk_repl[i]);
+        }
+
+        if (is_dirty) {
+            std::memcpy(victim->data, blk_bytes, blkSize);
+            if (compressor) {
+                Cycles compression_lat = Cycles(0);
+                Cycles decompression_lat = Cycles(0);
+                std::size_t size_bits = 0;
+                compressor->compress(
+                    reinterpret_cast<const uint64_t*>(victim->data),
+                    compression_lat, decompression_lat, size_bits);
+                compressor->setDecompressionLatency(victim,
+                                                    decompression_lat);
+            }
+        } else {
+            unfilledBlks.insert(victim);
+        }
+    }
+}
 
 BaseCache::CacheCmdStats::CacheCmdStats(BaseCache &c,
                                         const std::string &name)
@@ -1890,7 +2127,7 @@ BaseCache::CacheCmdStats::regStatsFromParent()
     // Miss latency statistics
     missLatency
         .init(max_masters)
-        .flags(total | nozero | nonan)
+        .flags(total | nozero | nonan | detailed)
         ;
     for (int i = 0; i < max_masters; i++) {
         missLatency.subname(i, system->getMasterName(i));
@@ -1911,7 +2148,7 @@ BaseCache::CacheCmdStats::regStatsFromParent()
     }
 
     // miss latency formulas
-    avgMissLatency.flags(total | nozero | nonan);
+    avgMissLatency.flags(total | nozero | nonan | detailed);
     avgMissLatency = missLatency / misses;
     for (int i = 0; i < max_masters; i++) {
         avgMissLatency.subname(i, system->getMasterName(i));
@@ -1921,7 +2158,7 @@ BaseCache::CacheCmdStats::regStatsFromParent()
     // MSHR hit statistics
     mshr_hits
         .init(max_masters)
-        .flags(total | nozero | nonan)
+        .flags(total | nozero | nonan | detailed)
         ;
     for (int i = 0; i < max_masters; i++) {
         mshr_hits.subname(i, system->getMasterName(i));
@@ -1930,7 +2167,7 @@ BaseCache::CacheCmdStats::regStatsFromParent()
     // MSHR miss statistics
     mshr_misses
         .init(max_masters)
-        .flags(total | nozero | nonan)
+        .flags(total | nozero | nonan | detailed)
         ;
     for (int i = 0; i < max_masters; i++) {
         mshr_misses.subname(i, system->getMasterName(i));
@@ -1939,7 +2176,7 @@ BaseCache::CacheCmdStats::regStatsFromParent()
     // MSHR miss latency statistics
     mshr_miss_latency
         .init(max_masters)
-        .flags(total | nozero | nonan)
+        .flags(total | nozero | nonan | detailed)
         ;
     for (int i = 0; i < max_masters; i++) {
         mshr_miss_latency.subname(i, system->getMasterName(i));
@@ -1948,7 +2185,7 @@ BaseCache::CacheCmdStats::regStatsFromParent()
     // MSHR uncacheable statistics
     mshr_uncacheable
         .init(max_masters)
-        .flags(total | nozero | nonan)
+        .flags(total | nozero | nonan | detailed)
         ;
     for (int i = 0; i < max_masters; i++) {
         mshr_uncacheable.subname(i, system->getMasterName(i));
@@ -1957,14 +2194,14 @@ BaseCache::CacheCmdStats::regStatsFromParent()
     // MSHR miss latency statistics
     mshr_uncacheable_lat
         .init(max_masters)
-        .flags(total | nozero | nonan)
+        .flags(total | nozero | nonan | detailed)
         ;
     for (int i = 0; i < max_masters; i++) {
         mshr_uncacheable_lat.subname(i, system->getMasterName(i));
     }
 
     // MSHR miss rate formulas
-    mshrMissRate.flags(total | nozero | nonan);
+    mshrMissRate.flags(total | nozero | nonan | detailed);
     mshrMissRate = mshr_misses / accesses;
 
     for (int i = 0; i < max_masters; i++) {
@@ -1972,14 +2209,14 @@ BaseCache::CacheCmdStats::regStatsFromParent()
     }
 
     // mshrMiss latency formulas
-    avgMshrMissLatency.flags(total | nozero | nonan);
+    avgMshrMissLatency.flags(total | nozero | nonan | detailed);
     avgMshrMissLatency = mshr_miss_latency / mshr_misses;
     for (int i = 0; i < max_masters; i++) {
         avgMshrMissLatency.subname(i, system->getMasterName(i));
     }
 
     // mshrUncacheable latency formulas
-    avgMshrUncacheableLatency.flags(total | nozero | nonan);
+    avgMshrUncacheableLatency.flags(total | nozero | nonan | detailed);
     avgMshrUncacheableLatency = mshr_uncacheable_lat / mshr_uncacheable;
     for (int i = 0; i < max_masters; i++) {
         avgMshrUncacheableLatency.subname(i, system->getMasterName(i));
@@ -2011,6 +2248,8 @@ BaseCache::CacheStats::CacheStats(BaseCache &c)
                          "average overall miss latency"),
     overallAvgMissLatency(this, "overall_avg_miss_latency",
                           "average overall miss latency"),
+    missLatencyHdr(this, "miss_latency_hdr",
+                   "distribution of the overall miss latencies (ticks)"),
     blocked_cycles(this, "blocked_cycles",
                    "number of cycles access was blocked"),
     blocked_causes(this, "blocked", "number of cycles access was blocked"),
@@ -2105,13 +2344,13 @@ BaseCache::CacheStats::regStats()
         overallMisses.subname(i, system->getMasterName(i));
     }
 
-    demandMissLatency.flags(total | nozero | nonan);
+    demandMissLatency.flags(total | nozero | nonan | detailed);
     demandMissLatency = SUM_DEMAND(missLatency);
     for (int i = 0; i < max_masters; i++) {
         demandMissLatency.subname(i, system->getMasterName(i));
     }
 
-    overallMissLatency.flags(total | nozero | nonan);
+    overallMissLatency.flags(total | nozero | nonan | detailed);
     overallMissLatency = demandMissLatency + SUM_NON_DEMAND(missLatency);
     for (int i = 0; i < max_masters; i++) {
         overallMissLatency.subname(i, system->getMasterName(i));
@@ -2141,18 +2380,26 @@ BaseCache::CacheStats::regStats()
         overallMissRate.subname(i, system->getMasterName(i));
     }
 
-    demandAvgMissLatency.flags(total | nozero | nonan);
+    demandAvgMissLatency.flags(total | nozero | nonan | detailed);
     demandAvgMissLatency = demandMissLatency / demandMisses;
     for (int i = 0; i < max_masters; i++) {
         demandAvgMissLatency.subname(i, system->getMasterName(i));
     }
 
-    overallAvgMissLatency.flags(total | nozero | nonan);
+    overallAvgMissLatency.flags(total | nozero | nonan | detailed);
     overallAvgMissLatency = overallMissLatency / overallMisses;
     for (int i = 0; i < max_masters; i++) {
         overallAvgMissLatency.subname(i, system->getMasterName(i));
     }
 
+    // A disabled histogram is kept to a single bucket
+    fatal_if(cache.missLatencyHdrBits > 16, "%s: The HDR miss latency "
+             "histogram supports up to 16 significant bits.\n", cache.name());
+    missLatencyHdr
+        .init(cache.missLatencyHdrBits ? cache.missLatencyHdrMax : 0,
+              cache.missLatencyHdrBits ? cache.missLatencyHdrBits : 1)
+        .flags(cache.missLatencyHdrBits ? pdf : nozero);
+
     blocked_cycles.init(NUM_BLOCKED_CAUSES);
     blocked_cycles
         .subname(Blocked_NoMSHRs, "no_mshrs")
@@ -2182,44 +2429,44 @@ BaseCache::CacheStats::regStats()
         writebacks.subname(i, system->getMasterName(i));
     }
 
-    demandMshrHits.flags(total | nozero | nonan);
+    demandMshrHits.flags(total | nozero | nonan | detailed);
     demandMshrHits = SUM_DEMAND(mshr_hits);
     for (int i = 0; i < max_masters; i++) {
         demandMshrHits.subname(i, system->getMasterName(i));
     }
 
-    overallMshrHits.flags(total | nozero | nonan);
+    overallMshrHits.flags(total | nozero | nonan | detailed);
     overallMshrHits = demandMshrHits + SUM_NON_DEMAND(mshr_hits);
     for (int i = 0; i < max_masters; i++) {
         overallMshrHits.subname(i, system->getMasterName(i));
     }
 
-    demandMshrMisses.flags(total | nozero | nonan);
+    demandMshrMisses.flags(total | nozero | nonan | detailed);
     demandMshrMisses = SUM_DEMAND(mshr_misses);
     for (int i = 0; i < max_masters; i++) {
         demandMshrMisses.subname(i, system->getMasterName(i));
     }
 
-    overallMshrMisses.flags(total | nozero | nonan);
+    overallMshrMisses.flags(total | nozero | nonan | detailed);
     overallMshrMisses = demandMshrMisses + SUM_NON_DEMAND(mshr_misses);
     for (int i = 0; i < max_masters; i++) {
         overallMshrMisses.subname(i, system->getMasterName(i));
     }
 
-    demandMshrMissLatency.flags(total | nozero | nonan);
+    demandMshrMissLatency.flags(total | nozero | nonan | detailed);
     demandMshrMissLatency = SUM_DEMAND(mshr_miss_latency);
     for (int i = 0; i < max_masters; i++) {
         demandMshrMissLatency.subname(i, system->getMasterName(i));
     }
 
-    overallMshrMissLatency.flags(total | nozero | nonan);
+    overallMshrMissLatency.flags(total | nozero | nonan | detailed);
     overallMshrMissLatency =
         demandMshrMissLatency + SUM_NON_DEMAND(mshr_miss_latency);
     for (int i = 0; i < max_masters; i++) {
         overallMshrMissLatency.subname(i, system->getMasterName(i));
     }
 
-    overallMshrUncacheable.flags(total | nozero | nonan);
+    overallMshrUncacheable.flags(total | nozero | nonan | detailed);
     overallMshrUncacheable =
         SUM_DEMAND(mshr_uncacheable) + SUM_NON_DEMAND(mshr_uncacheable);
     for (int i = 0; i < max_masters; i++) {
@@ -2227,7 +2474,7 @@ BaseCache::CacheStats::regStats()
     }
 
 
-    overallMshrUncacheableLatency.flags(total | nozero | nonan);
+    overallMshrUncacheableLatency.flags(total | nozero | nonan | detailed);
     overallMshrUncacheableLatency =
         SUM_DEMAND(mshr_uncacheable_lat) +
         SUM_NON_DEMAND(mshr_uncacheable_lat);
@@ -2235,31 +2482,31 @@ BaseCache::CacheStats::regStats()
         overallMshrUncacheableLatency.subname(i, system->getMasterName(i));
     }
 
-    demandMshrMissRate.flags(total | nozero | nonan);
+    demandMshrMissRate.flags(total | nozero | nonan | detailed);
     demandMshrMissRate = demandMshrMisses / demandAccesses;
     for (int i = 0; i < max_masters; i++) {
         demandMshrMissRate.subname(i, system->getMasterName(i));
     }
 
-    overallMshrMissRate.flags(total | nozero | nonan);
+    overallMshrMissRate.flags(total | nozero | nonan | detailed);
     overallMshrMissRate = overallMshrMisses / overallAccesses;
     for (int i = 0; i < max_masters; i++) {
         overallMshrMissRate.subname(i, system->getMasterName(i));
     }
 
-    demandAvgMshrMissLatency.flags(total | nozero | nonan);
+    demandAvgMshrMissLatency.flags(total | nozero | nonan | detailed);
     demandAvgMshrMissLatency = demandMshrMissLatency / demandMshrMisses;
     for (int i = 0; i < max_masters; i++) {
         demandAvgMshrMissLatency.subname(i, system->getMasterName(i));
     }
 
-    overallAvgMshrMissLatency.flags(total | nozero | nonan);
+    overallAvgMshrMissLatency.flags(total | nozero | nonan | detailed);
     overallAvgMshrMissLatency = overallMshrMissLatency / overallMshrMisses;
     for (int i = 0; i < max_masters; i++) {
         overallAvgMshrMissLatency.subname(i, system->getMasterName(i));
     }
 
-    overallAvgMshrUncacheableLatency.flags(total | nozero | nonan);
+    overallAvgMshrUncacheableLatency.flags(total | nozero | nonan | detailed);
     overallAvgMshrUncacheableLatency =
         overallMshrUncacheableLatency / overallMshrUncacheable;
     for (int i = 0; i < max_masters; i++) {
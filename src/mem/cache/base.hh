@@ -49,6 +49,7 @@
 #include <cassert>
 #include <cstdint>
 #include <string>
+#include <unordered_set>
 
 #include "base/addr_range.hh"
 #include "base/statistics.hh"
@@ -78,6 +79,7 @@
 namespace Prefetcher {
     class Base;
 }
+class BaseReplacementPolicy;
 class MSHR;
 class MasterPort;
 class QueueEntry;
@@ -322,6 +324,9 @@ class BaseCache : public ClockedObject
     /** Compression method being used. */
     BaseCacheCompressor* compressor;
 
+    /** Replacement policy, used to save and restore replacement state. */
+    BaseReplacementPolicy *replacementPolicy;
+
     /** Prefetcher */
     Prefetcher::Base *prefetcher;
 
@@ -625,6 +630,19 @@ class BaseCache : public ClockedObject
      */
     const bool writebackClean;
 
+    /**
+     * Determine if the contents of the cache are saved in and restored
+     * from checkpoints, so that restored runs start with a warm cache.
+     */
+    const bool checkpointContents;
+
+    /**
+     * Clean blocks restored from a checkpoint, whose data is only
+     * read from the memory below at startup. Functional accesses
+     * ignore these blocks until then.
+     */
+    std::unordered_set<const CacheBlk*> unfilledBlks;
+
     /**
      * Writebacks from the tempBlock, resulting on the response path
      * in atomic mode, must happen after the call to recvAtomic has
@@ -911,6 +929,15 @@ class BaseCache : public ClockedObject
     /** The number of misses to trigger an exit event. */
     Counter missCount;
 
+    /**
+     * Significant bits of the HDR miss latency histogram, zero if it
+     * is disabled.
+     */
+    const unsigned missLatencyHdrBits;
+
+    /** The maximum latency of the HDR miss latency histogram. */
+    const Tick missLatencyHdrMax;
+
     /**
      * The address range to which the cache responds on the CPU side.
      * Normally this is all possible memory addresses. */
@@ -1011,6 +1038,9 @@ class BaseCache : public ClockedObject
         /** The average miss latency for all misses. */
         Stats::Formula overallAvgMissLatency;
 
+        /** The distribution of the latencies of all misses. */
+        Stats::HdrHistogram missLatencyHdr;
+
         /** The total number of cycles blocked for each blocked cause. */
         Stats::Vector blocked_cycles;
         /** The number of times this cache blocked for each blocked cause. */
@@ -1078,6 +1108,7 @@ class BaseCache : public ClockedObject
     ~BaseCache();
 
     void init() override;
+    void startup() override;
 
     Port &getPort(const std::string &if_name,
                   PortID idx=InvalidPortID) override;
@@ -1278,7 +1309,10 @@ class BaseCache : public ClockedObject
     /**
      * Serialize the state of the caches
      *
-     * We currently don't support checkpointing cache state, so this panics.
+     * The valid blocks are saved in insertion order, with their tag,
+     * state, replacement state and compressed size. Only the data of
+     * dirty blocks is saved, the data of clean blocks is read from the
+     * memory below when the simulation starts.
      */
     void serialize(CheckpointOut &cp) const override;
     void unserialize(CheckpointIn &cp) override;
@@ -326,7 +326,8 @@ Cache::handleTimingReqMiss(PacketPtr pkt, CacheBlk *blk, Tick forward_time,
         // should have flushed and have no valid block
         assert(!blk || !blk->isValid());
 
-        stats.cmdStats(pkt).mshr_uncacheable[pkt->req->masterId()]++;
+        STATS_DETAILED(
+            stats.cmdStats(pkt).mshr_uncacheable[pkt->req->masterId()]++);
 
         if (pkt->isWrite()) {
             allocateWriteBuffer(pkt, forward_time);
@@ -775,9 +776,11 @@ Cache::serviceMSHRTargets(MSHR *mshr, const PacketPtr pkt, CacheBlk *blk)
                 assert(!tgt_pkt->req->isUncacheable());
 
                 assert(tgt_pkt->req->masterId() < system->maxMasters());
-                stats.cmdStats(tgt_pkt)
-                    .missLatency[tgt_pkt->req->masterId()] +=
-                    completion_time - target.recvTime;
+                const Tick miss_latency = completion_time - target.recvTime;
+                STATS_DETAILED(stats.cmdStats(tgt_pkt)
+                    .missLatency[tgt_pkt->req->masterId()] += miss_latency);
+                if (missLatencyHdrBits)
+                    stats.missLatencyHdr.sample(miss_latency);
             } else if (pkt->cmd == MemCmd::UpgradeFailResp) {
                 // failed StoreCond upgrade
                 assert(tgt_pkt->cmd == MemCmd::StoreCondReq ||
@@ -270,8 +270,11 @@ NoncoherentCache::serviceMSHRTargets(MSHR *mshr, const PacketPtr pkt,
                 (transfer_offset ? pkt->payloadDelay : 0);
 
             assert(tgt_pkt->req->masterId() < system->maxMasters());
-            stats.cmdStats(tgt_pkt).missLatency[tgt_pkt->req->masterId()] +=
-                completion_time - target.recvTime;
+            STATS_DETAILED(stats.cmdStats(tgt_pkt)
+                .missLatency[tgt_pkt->req->masterId()] +=
+                completion_time - target.recvTime);
+            if (missLatencyHdrBits)
+                stats.missLatencyHdr.sample(completion_time - target.recvTime);
 
             tgt_pkt->makeTimingResponse();
             if (pkt->isError())
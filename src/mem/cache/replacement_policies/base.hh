@@ -29,6 +29,7 @@
 #ifndef __MEM_CACHE_REPLACEMENT_POLICIES_BASE_HH__
 #define __MEM_CACHE_REPLACEMENT_POLICIES_BASE_HH__
 
+#include <cstdint>
 #include <memory>
 
 #include "mem/cache/replacement_policies/replaceable_entry.hh"
@@ -100,6 +101,30 @@ class BaseReplacementPolicy : public SimObject
      * @return A shared pointer to the new replacement data.
      */
     virtual std::shared_ptr<ReplacementData> instantiateEntry() = 0;
+
+    /**
+     * Get the replacement state of an entry, so that it can be saved in
+     * a checkpoint. Policies without any state worth saving return 0.
+     *
+     * @param replacement_data Replacement data of the entry.
+     * @return The replacement state of the entry.
+     */
+    virtual uint64_t getState(const std::shared_ptr<ReplacementData>&
+                                            replacement_data) const
+    {
+        return 0;
+    }
+
+    /**
+     * Restore the replacement state of an entry from a value returned by
+     * getState(). This is done after the entry has been reset, so
+     * policies without any state worth saving do nothing.
+     *
+     * @param replacement_data Replacement data of the entry.
+     * @param state The replacement state to restore.
+     */
+    virtual void setState(const std::shared_ptr<ReplacementData>&
+                              replacement_data, uint64_t state) const {}
 };
 
 #endif // __MEM_CACHE_REPLACEMENT_POLICIES_BASE_HH__
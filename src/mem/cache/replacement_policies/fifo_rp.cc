@@ -82,6 +82,22 @@ FIFORP::getVictim(const ReplacementCandidates& candidates) const
     return victim;
 }
 
+uint64_t
+FIFORP::getState(const std::shared_ptr<ReplacementData>& replacement_data)
+const
+{
+    return std::static_pointer_cast<FIFOReplData>(
+        replacement_data)->tickInserted;
+}
+
+void
+FIFORP::setState(const std::shared_ptr<ReplacementData>& replacement_data,
+                 uint64_t state) const
+{
+    std::static_pointer_cast<FIFOReplData>(
+        replacement_data)->tickInserted = state;
+}
+
 std::shared_ptr<ReplacementData>
 FIFORP::instantiateEntry()
 {
@@ -112,6 +112,24 @@ class FIFORP : public BaseReplacementPolicy
      * @return A shared pointer to the new replacement data.
      */
     std::shared_ptr<ReplacementData> instantiateEntry() override;
+
+    /**
+     * Get the replacement state of an entry, which is its insertion tick.
+     *
+     * @param replacement_data Replacement data of the entry.
+     * @return The replacement state of the entry.
+     */
+    uint64_t getState(const std::shared_ptr<ReplacementData>&
+                                   replacement_data) const override;
+
+    /**
+     * Restore the insertion tick of an entry.
+     *
+     * @param replacement_data Replacement data of the entry.
+     * @param state The replacement state to restore.
+     */
+    void setState(const std::shared_ptr<ReplacementData>& replacement_data,
+                  uint64_t state) const override;
 };
 
 #endif // __MEM_CACHE_REPLACEMENT_POLICIES_FIFO_RP_HH__
@@ -84,6 +84,22 @@ LRURP::getVictim(const ReplacementCandidates& candidates) const
     return victim;
 }
 
+uint64_t
+LRURP::getState(const std::shared_ptr<ReplacementData>& replacement_data)
+const
+{
+    return std::static_pointer_cast<LRUReplData>(
+        replacement_data)->lastTouchTick;
+}
+
+void
+LRURP::setState(const std::shared_ptr<ReplacementData>& replacement_data,
+                uint64_t state) const
+{
+    std::static_pointer_cast<LRUReplData>(
+        replacement_data)->lastTouchTick = state;
+}
+
 std::shared_ptr<ReplacementData>
 LRURP::instantiateEntry()
 {
@@ -89,6 +89,22 @@ MRURP::getVictim(const ReplacementCandidates& candidates) const
     return victim;
 }
 
+uint64_t
+MRURP::getState(const std::shared_ptr<ReplacementData>& replacement_data)
+const
+{
+    return std::static_pointer_cast<MRUReplData>(
+        replacement_data)->lastTouchTick;
+}
+
+void
+MRURP::setState(const std::shared_ptr<ReplacementData>& replacement_data,
+                uint64_t state) const
+{
+    std::static_pointer_cast<MRUReplData>(
+        replacement_data)->lastTouchTick = state;
+}
+
 std::shared_ptr<ReplacementData>
 MRURP::instantiateEntry()
 {
@@ -136,6 +136,13 @@ CommMonitor::MonitorStats::MonitorStats(Stats::Group *parent,
       ADD_STAT(ittReqReq, "Request-to-request inter transaction time"),
       timeOfLastRead(0), timeOfLastWrite(0), timeOfLastReq(0),
 
+      hdrBits(params->hdr_bits),
+      ADD_STAT(readLatencyHdr, "Read request-response latency"),
+      ADD_STAT(writeLatencyHdr, "Write request-response latency"),
+      ADD_STAT(ittReadReadHdr, "Read-to-read inter transaction time"),
+      ADD_STAT(ittWriteWriteHdr, "Write-to-write inter transaction time"),
+      ADD_STAT(ittReqReqHdr, "Request-to-request inter transaction time"),
+
       disableOutstandingHists(params->disable_outstanding_hists),
       ADD_STAT(outstandingReadsHist, "Outstanding read transactions"),
       outstandingReadReqs(0),
@@ -212,6 +219,35 @@ CommMonitor::MonitorStats::MonitorStats(Stats::Group *parent,
               params->itt_bins)
         .flags(disableITTDists ? nozero : pdf);
 
+    fatal_if(hdrBits > 16, "%s: HDR histograms support up to 16 "
+             "significant bits.\n", params->name);
+
+    // Disabled HDR histograms are kept to a single bucket
+    const Tick hdr_max = hdrBits ? params->hdr_max : 0;
+    const unsigned hdr_bits = hdrBits ? hdrBits : 1;
+    const bool latency_hdr = hdrBits && !disableLatencyHists;
+    const bool itt_hdr = hdrBits && !disableITTDists;
+
+    readLatencyHdr
+        .init(hdr_max, hdr_bits)
+        .flags(latency_hdr ? pdf : nozero);
+
+    writeLatencyHdr
+        .init(hdr_max, hdr_bits)
+        .flags(latency_hdr ? pdf : nozero);
+
+    ittReadReadHdr
+        .init(hdr_max, hdr_bits)
+        .flags(itt_hdr ? pdf : nozero);
+
+    ittWriteWriteHdr
+        .init(hdr_max, hdr_bits)
+        .flags(itt_hdr ? pdf : nozero);
+
+    ittReqReqHdr
+        .init(hdr_max, hdr_bits)
+        .flags(itt_hdr ? pdf : nozero);
+
     outstandingReadsHist
         .init(params->outstanding_bins)
         .flags(disableOutstandingHists ? nozero : pdf);
@@ -258,12 +294,13 @@ CommMonitor::MonitorStats::updateReqStats(
         if (!disableITTDists) {
             // Sample value of read-read inter transaction time
             if (timeOfLastRead != 0)
-                ittReadRead.sample(curTick() - timeOfLastRead);
+                sampleITT(ittReadRead, ittReadReadHdr,
+                          curTick() - timeOfLastRead);
             timeOfLastRead = curTick();
 
             // Sample value of req-req inter transaction time
             if (timeOfLastReq != 0)
-                ittReqReq.sample(curTick() - timeOfLastReq);
+                sampleITT(ittReqReq, ittReqReqHdr, curTick() - timeOfLastReq);
             timeOfLastReq = curTick();
         }
         if (!is_atomic && !disableOutstandingHists && expects_response)
@@ -290,12 +327,13 @@ CommMonitor::MonitorStats::updateReqStats(
         if (!disableITTDists) {
             // Sample value of write-to-write inter transaction time
             if (timeOfLastWrite != 0)
-                ittWriteWrite.sample(curTick() - timeOfLastWrite);
+                sampleITT(ittWriteWrite, ittWriteWriteHdr,
+                          curTick() - timeOfLastWrite);
             timeOfLastWrite = curTick();
 
             // Sample value of req-to-req inter transaction time
             if (timeOfLastReq != 0)
-                ittReqReq.sample(curTick() - timeOfLastReq);
+                sampleITT(ittReqReq, ittReqReqHdr, curTick() - timeOfLastReq);
             timeOfLastReq = curTick();
         }
 
@@ -304,6 +342,15 @@ CommMonitor::MonitorStats::updateReqStats(
     }
 }
 
+void
+CommMonitor::MonitorStats::sampleITT(Stats::Distribution &dist,
+                                     Stats::HdrHistogram &hdr, Tick itt)
+{
+    dist.sample(itt);
+    if (hdrBits)
+        hdr.sample(itt);
+}
+
 void
 CommMonitor::MonitorStats::updateRespStats(
     const ProbePoints::PacketInfo& pkt_info, Tick latency, bool is_atomic)
@@ -315,8 +362,11 @@ CommMonitor::MonitorStats::updateRespStats(
             --outstandingReadReqs;
         }
 
-        if (!disableLatencyHists)
+        if (!disableLatencyHists) {
             readLatencyHist.sample(latency);
+            if (hdrBits)
+                readLatencyHdr.sample(latency);
+        }
 
         // Update the bandwidth stats based on responses for reads
         if (!disableBandwidthHists) {
@@ -331,8 +381,11 @@ CommMonitor::MonitorStats::updateRespStats(
             --outstandingWriteReqs;
         }
 
-        if (!disableLatencyHists)
+        if (!disableLatencyHists) {
             writeLatencyHist.sample(latency);
+            if (hdrBits)
+                writeLatencyHdr.sample(latency);
+        }
     }
 }
 
@@ -326,6 +326,23 @@ class CommMonitor : public SimObject
         Tick timeOfLastWrite;
         Tick timeOfLastReq;
 
+        /**
+         * Significant bits of the HDR histograms, zero if they are
+         * disabled.
+         */
+        const unsigned hdrBits;
+
+        /**
+         * Latency and ITT histograms with HDR buckets, which also
+         * report the percentiles. They are only sampled if the
+         * corresponding histograms and distributions are.
+         */
+        Stats::HdrHistogram readLatencyHdr;
+        Stats::HdrHistogram writeLatencyHdr;
+        Stats::HdrHistogram ittReadReadHdr;
+        Stats::HdrHistogram ittWriteWriteHdr;
+        Stats::HdrHistogram ittReqReqHdr;
+
         /** Disable flag for outstanding histograms. */
         bool disableOutstandingHists;
 
@@ -388,6 +405,10 @@ class CommMonitor : public SimObject
                             bool expects_response);
         void updateRespStats(const ProbePoints::PacketInfo& pkt, Tick latency,
                              bool is_atomic);
+
+        /** Sample an ITT and its HDR histogram if enabled. */
+        void sampleITT(Stats::Distribution &dist, Stats::HdrHistogram &hdr,
+                       Tick itt);
     };
 
     /** This function is called periodically at the end of each time bin */
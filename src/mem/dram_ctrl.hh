@@ -1097,7 +1097,14 @@ class DRAMCtrl : public QoS::MemCtrl
      */
     Tick nextReqTime;
 
-    /** All statistics that the model needs to capture */
+    /**
+     * All statistics that the model needs to capture. The counts are
+     * sharded as requests may be received from the event queues of
+     * the requestors. The queue length averages are set to the
+     * occupancy of the queues rather than accumulated, and the
+     * histograms are only sampled by the controller's own events,
+     * so they are left unsharded.
+     */
     struct DRAMStats : public Stats::Group {
         DRAMStats(DRAMCtrl &dram);
 
@@ -1106,52 +1113,52 @@ class DRAMCtrl : public QoS::MemCtrl
 
         DRAMCtrl &dram;
 
-        Stats::Scalar readReqs;
-        Stats::Scalar writeReqs;
-        Stats::Scalar readBursts;
-        Stats::Scalar writeBursts;
-        Stats::Scalar servicedByWrQ;
-        Stats::Scalar mergedWrBursts;
-        Stats::Scalar neitherReadNorWriteReqs;
-        Stats::Vector perBankRdBursts;
-        Stats::Vector perBankWrBursts;
+        Stats::ShardedScalar readReqs;
+        Stats::ShardedScalar writeReqs;
+        Stats::ShardedScalar readBursts;
+        Stats::ShardedScalar writeBursts;
+        Stats::ShardedScalar servicedByWrQ;
+        Stats::ShardedScalar mergedWrBursts;
+        Stats::ShardedScalar neitherReadNorWriteReqs;
+        Stats::ShardedVector perBankRdBursts;
+        Stats::ShardedVector perBankWrBursts;
 
         // Average queue lengths
         Stats::Average avgRdQLen;
         Stats::Average avgWrQLen;
 
         // Latencies summed over all requests
-        Stats::Scalar totQLat;
-        Stats::Scalar totBusLat;
-        Stats::Scalar totMemAccLat;
+        Stats::ShardedScalar totQLat;
+        Stats::ShardedScalar totBusLat;
+        Stats::ShardedScalar totMemAccLat;
 
         // Average latencies per request
         Stats::Formula avgQLat;
         Stats::Formula avgBusLat;
         Stats::Formula avgMemAccLat;
 
-        Stats::Scalar numRdRetry;
-        Stats::Scalar numWrRetry;
+        Stats::ShardedScalar numRdRetry;
+        Stats::ShardedScalar numWrRetry;
 
         // Row hit count and rate
-        Stats::Scalar readRowHits;
-        Stats::Scalar writeRowHits;
+        Stats::ShardedScalar readRowHits;
+        Stats::ShardedScalar writeRowHits;
         Stats::Formula readRowHitRate;
         Stats::Formula writeRowHitRate;
 
-        Stats::Vector readPktSize;
-        Stats::Vector writePktSize;
-        Stats::Vector rdQLenPdf;
-        Stats::Vector wrQLenPdf;
+        Stats::ShardedVector readPktSize;
+        Stats::ShardedVector writePktSize;
+        Stats::ShardedVector rdQLenPdf;
+        Stats::ShardedVector wrQLenPdf;
         Stats::Histogram bytesPerActivate;
         Stats::Histogram rdPerTurnAround;
         Stats::Histogram wrPerTurnAround;
 
-        Stats::Scalar bytesReadDRAM;
-        Stats::Scalar bytesReadWrQ;
-        Stats::Scalar bytesWritten;
-        Stats::Scalar bytesReadSys;
-        Stats::Scalar bytesWrittenSys;
+        Stats::ShardedScalar bytesReadDRAM;
+        Stats::ShardedScalar bytesReadWrQ;
+        Stats::ShardedScalar bytesWritten;
+        Stats::ShardedScalar bytesReadSys;
+        Stats::ShardedScalar bytesWrittenSys;
 
         // Average bandwidth
         Stats::Formula avgRdBW;
@@ -1164,24 +1171,24 @@ class DRAMCtrl : public QoS::MemCtrl
         Stats::Formula busUtilRead;
         Stats::Formula busUtilWrite;
 
-        Stats::Scalar totGap;
+        Stats::ShardedScalar totGap;
         Stats::Formula avgGap;
 
         // per-master bytes read and written to memory
-        Stats::Vector masterReadBytes;
-        Stats::Vector masterWriteBytes;
+        Stats::ShardedVector masterReadBytes;
+        Stats::ShardedVector masterWriteBytes;
 
         // per-master bytes read and written to memory rate
         Stats::Formula masterReadRate;
         Stats::Formula masterWriteRate;
 
         // per-master read and write serviced memory accesses
-        Stats::Vector masterReadAccesses;
-        Stats::Vector masterWriteAccesses;
+        Stats::ShardedVector masterReadAccesses;
+        Stats::ShardedVector masterWriteAccesses;
 
         // per-master read and write total memory access latency
-        Stats::Vector masterReadTotalLat;
-        Stats::Vector masterWriteTotalLat;
+        Stats::ShardedVector masterReadTotalLat;
+        Stats::ShardedVector masterWriteTotalLat;
 
         // per-master raed and write average memory access latency
         Stats::Formula masterReadAvgLat;
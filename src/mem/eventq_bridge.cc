@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/eventq_bridge.hh"
+
+#include "base/logging.hh"
+
+EventQueueBridge::EventQueueBridge(const EventQueueBridgeParams *p)
+    : SimObject(p),
+      masterPort(name() + ".master", *this),
+      slavePort(name() + ".slave", *this),
+      memSideQueue(getEventQueue(p->mem_side_eventq_index)),
+      delay(p->delay),
+      requests(*this, name() + ".requests", memSideQueue,
+               [this](PacketPtr pkt) {
+                   return masterPort.sendTimingReq(pkt);
+               }),
+      responses(*this, name() + ".responses", eventQueue(),
+                [this](PacketPtr pkt) {
+                    return slavePort.sendTimingResp(pkt);
+                }),
+      inFlight(0),
+      stats(*this)
+{
+}
+
+void
+EventQueueBridge::init()
+{
+    if (!slavePort.isConnected() || !masterPort.isConnected())
+        fatal("Event queue bridge %s is not connected on both sides.\n",
+              name());
+
+    fatal_if(slavePort.isSnooping(), "Event queue bridge %s cannot pass "
+             "snoops, and must be placed where the CPU side does not "
+             "snoop, e.g., between a CPU and its caches.\n", name());
+}
+
+EventQueueBridge::EventQueueBridgeStats::EventQueueBridgeStats(
+    EventQueueBridge &bridge)
+    : Stats::Group(&bridge),
+      ADD_STAT(packets, "Number of packets delivered across the bridge"),
+      ADD_STAT(latePackets, "Number of packets delivered after their "
+               "tick, as the receiving side had gone past it"),
+      ADD_STAT(lateTicks, "Total number of ticks by which the late "
+               "packets were late (Tick)")
+{
+}
+
+DrainState
+EventQueueBridge::drain()
+{
+    return inFlight == 0 ? DrainState::Drained : DrainState::Draining;
+}
+
+Port &
+EventQueueBridge::getPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "master") {
+        return masterPort;
+    } else if (if_name == "slave") {
+        return slavePort;
+    } else {
+        return SimObject::getPort(if_name, idx);
+    }
+}
+
+void
+EventQueueBridge::packetDelivered()
+{
+    // only the thread sending the last packet signals the end of the
+    // drain
+    if (--inFlight == 0 && drainState() == DrainState::Draining)
+        signalDrainDone();
+}
+
+EventQueueBridge::Channel::Channel(EventQueueBridge &_bridge,
+                                   const std::string &_name,
+                                   EventQueue *dest_queue,
+                                   const std::function<bool(PacketPtr)> &_send)
+    : bridge(_bridge), name(_name), destQueue(dest_queue), send(_send),
+      waitingRetry(false)
+{
+}
+
+void
+EventQueueBridge::Channel::post(PacketPtr pkt)
+{
+    const Tick when = curTick() + bridge.delay;
+    ++bridge.inFlight;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        posted.emplace_back(when, pkt);
+    }
+
+    // Every packet gets its own event, which the receiving queue
+    // serves at the tick of the packet, or as soon as it sees it if
+    // that tick is already past. Events due at the same tick are not
+    // served in the order they are scheduled, so they take the
+    // packets from the front of the posted ones instead of carrying
+    // them.
+    auto *event = new EventFunctionWrapper([this] { deliver(); }, name,
+                                           true);
+    if (inParallelMode && destQueue != curEventQueue())
+        destQueue->scheduleRemote(event, when);
+    else
+        destQueue->schedule(event, when);
+}
+
+void
+EventQueueBridge::Channel::deliver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!posted.empty() && posted.front().first <= curTick()) {
+            const Tick late = curTick() - posted.front().first;
+            if (late > 0) {
+                ++bridge.stats.latePackets;
+                bridge.stats.lateTicks += late;
+            }
+            ready.push_back(posted.front().second);
+            posted.pop_front();
+        }
+    }
+
+    trySend();
+}
+
+void
+EventQueueBridge::Channel::trySend()
+{
+    while (!waitingRetry && !ready.empty()) {
+        if (!send(ready.front())) {
+            waitingRetry = true;
+            return;
+        }
+        ready.pop_front();
+        ++bridge.stats.packets;
+        bridge.packetDelivered();
+    }
+}
+
+void
+EventQueueBridge::Channel::retry()
+{
+    assert(waitingRetry);
+    waitingRetry = false;
+    trySend();
+}
+
+bool
+EventQueueBridge::Channel::trySatisfyFunctional(PacketPtr pkt)
+{
+    for (auto p : ready) {
+        if (pkt->trySatisfyFunctional(p))
+            return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &p : posted) {
+        if (pkt->trySatisfyFunctional(p.second))
+            return true;
+    }
+    return false;
+}
+
+// The calls received by the slave port come from the CPU side
+
+bool
+EventQueueBridge::BridgeSlavePort::recvTimingReq(PacketPtr pkt)
+{
+    bridge.requests.post(pkt);
+    return true;
+}
+
+bool
+EventQueueBridge::BridgeSlavePort::tryTiming(PacketPtr pkt)
+{
+    return true;
+}
+
+Tick
+EventQueueBridge::BridgeSlavePort::recvAtomic(PacketPtr pkt)
+{
+    // The CPU side waits for the access anyway, so it is done with
+    // the memory side event queue locked, as for KVM CPUs
+    EventQueue::ScopedMigration migrate(bridge.memSideQueue, inParallelMode);
+    return bridge.masterPort.sendAtomic(pkt);
+}
+
+void
+EventQueueBridge::BridgeSlavePort::recvFunctional(PacketPtr pkt)
+{
+    pkt->pushLabel(name());
+
+    // check the responses on their way to the CPU side, and then the
+    // requests on their way to the memory side with the memory side
+    // event queue locked
+    if (bridge.responses.trySatisfyFunctional(pkt)) {
+        pkt->makeResponse();
+        return;
+    }
+
+    EventQueue::ScopedMigration migrate(bridge.memSideQueue, inParallelMode);
+    if (bridge.requests.trySatisfyFunctional(pkt)) {
+        pkt->makeResponse();
+        return;
+    }
+
+    pkt->popLabel();
+
+    bridge.masterPort.sendFunctional(pkt);
+}
+
+void
+EventQueueBridge::BridgeSlavePort::recvRespRetry()
+{
+    bridge.responses.retry();
+}
+
+AddrRangeList
+EventQueueBridge::BridgeSlavePort::getAddrRanges() const
+{
+    // Only used while the system is set up, before any parallel
+    // simulation
+    return bridge.masterPort.getAddrRanges();
+}
+
+// The calls received by the master port come from the memory side
+
+bool
+EventQueueBridge::BridgeMasterPort::recvTimingResp(PacketPtr pkt)
+{
+    bridge.responses.post(pkt);
+    return true;
+}
+
+void
+EventQueueBridge::BridgeMasterPort::recvReqRetry()
+{
+    bridge.requests.retry();
+}
+
+void
+EventQueueBridge::BridgeMasterPort::recvRangeChange()
+{
+    bridge.slavePort.sendRangeChange();
+}
+
+EventQueueBridge*
+EventQueueBridgeParams::create()
+{
+    return new EventQueueBridge(this);
+}
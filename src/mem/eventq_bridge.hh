@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_EVENTQ_BRIDGE_HH__
+#define __MEM_EVENTQ_BRIDGE_HH__
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "base/statistics.hh"
+#include "mem/port.hh"
+#include "params/EventQueueBridge.hh"
+#include "sim/eventq.hh"
+#include "sim/sim_object.hh"
+
+/**
+ * A pass-through between two event queues. The bridge splices a link
+ * of the memory system, such as the link between a CPU and its
+ * caches, so that the objects on either side can be simulated by
+ * different event queues, and thus by different threads.
+ *
+ * The slave side belongs to the event queue of the bridge itself,
+ * and the master side to the event queue given by the
+ * mem_side_eventq_index parameter. The two sides never call each
+ * other directly. A packet crossing the bridge is posted to the
+ * other side, and delivered by the event queue of that side at the
+ * tick it was sent plus the delay of the bridge. The event queues are
+ * only synchronised at the end of each simulation quantum, so the
+ * receiving side may already have gone past that tick, in which case
+ * the packet is delivered as soon as possible instead. The late
+ * packets, and by how much they are late, are reported in the stats
+ * of the bridge. No packet is late when the delay is at least one
+ * quantum. The bridge accepts all the packets, and holds on to the
+ * ones refused by the receiver until it asks for a retry.
+ *
+ * Snoops cannot cross the bridge, as they have to be handled while
+ * the crossbar or cache that sends them waits, so the bridge cannot
+ * be placed on a link where the slave side snoops.
+ */
+class EventQueueBridge : public SimObject
+{
+  public:
+
+    EventQueueBridge(const EventQueueBridgeParams *p);
+
+    void init() override;
+
+    DrainState drain() override;
+
+    Port &getPort(const std::string &if_name,
+                  PortID idx=InvalidPortID) override;
+
+  private:
+
+    /**
+     * One direction of the bridge. Packets are posted by the thread
+     * of the sending side and delivered in order by the event queue
+     * of the receiving side.
+     */
+    class Channel
+    {
+      public:
+
+        /**
+         * @param _bridge The bridge the channel belongs to
+         * @param _name Name of the delivery events
+         * @param dest_queue Event queue of the receiving side
+         * @param _send Send a packet to the receiver, false if refused
+         */
+        Channel(EventQueueBridge &_bridge, const std::string &_name,
+                EventQueue *dest_queue,
+                const std::function<bool(PacketPtr)> &_send);
+
+        /** Post a packet to the receiving side. */
+        void post(PacketPtr pkt);
+
+        /** Send the packets again once the receiver asks for it. */
+        void retry();
+
+        /**
+         * Check the packets that are not delivered yet for a
+         * functional access. Only called with the event queue of the
+         * receiving side locked.
+         */
+        bool trySatisfyFunctional(PacketPtr pkt);
+
+      private:
+
+        /** Take the packets that are due and send them. */
+        void deliver();
+
+        /** Send the packets that are due, in order. */
+        void trySend();
+
+        EventQueueBridge &bridge;
+
+        const std::string name;
+
+        EventQueue *const destQueue;
+
+        const std::function<bool(PacketPtr)> send;
+
+        /** Protects the posted packets, shared by the two sides. */
+        std::mutex mutex;
+
+        /** Posted packets, with the tick they are due. */
+        std::deque<std::pair<Tick, PacketPtr>> posted;
+
+        /**
+         * Packets that are due, only accessed by the receiving side.
+         */
+        std::deque<PacketPtr> ready;
+
+        /** Whether the receiver refused a packet. */
+        bool waitingRetry;
+    };
+
+    /**
+     * Master port of the bridge, facing the memory side.
+     */
+    class BridgeMasterPort : public MasterPort
+    {
+      public:
+
+        BridgeMasterPort(const std::string &_name, EventQueueBridge &_bridge)
+            : MasterPort(_name, &_bridge), bridge(_bridge)
+        { }
+
+      protected:
+
+        bool recvTimingResp(PacketPtr pkt) override;
+
+        void recvReqRetry() override;
+
+        void recvRangeChange() override;
+
+      private:
+
+        EventQueueBridge &bridge;
+    };
+
+    /**
+     * Slave port of the bridge, facing the CPU side.
+     */
+    class BridgeSlavePort : public SlavePort
+    {
+      public:
+
+        BridgeSlavePort(const std::string &_name, EventQueueBridge &_bridge)
+            : SlavePort(_name, &_bridge), bridge(_bridge)
+        { }
+
+      protected:
+
+        bool recvTimingReq(PacketPtr pkt) override;
+
+        bool tryTiming(PacketPtr pkt) override;
+
+        Tick recvAtomic(PacketPtr pkt) override;
+
+        void recvFunctional(PacketPtr pkt) override;
+
+        void recvRespRetry() override;
+
+        AddrRangeList getAddrRanges() const override;
+
+      private:
+
+        EventQueueBridge &bridge;
+    };
+
+    /** A packet was sent by a channel. */
+    void packetDelivered();
+
+    /**
+     * Stats of the packets crossing the bridge. They are updated by
+     * the threads of both sides.
+     */
+    struct EventQueueBridgeStats : public Stats::Group
+    {
+        EventQueueBridgeStats(EventQueueBridge &bridge);
+
+        /** Number of packets delivered. */
+        Stats::ShardedScalar packets;
+
+        /** Number of packets delivered after their tick. */
+        Stats::ShardedScalar latePackets;
+
+        /** Ticks by which the late packets were late, in total. */
+        Stats::ShardedScalar lateTicks;
+    };
+
+    BridgeMasterPort masterPort;
+
+    BridgeSlavePort slavePort;
+
+    /** Event queue of the objects on the memory side. */
+    EventQueue *const memSideQueue;
+
+    /** Delay of the packets crossing the bridge. */
+    const Tick delay;
+
+    /** Requests, from the CPU side to the memory side. */
+    Channel requests;
+
+    /** Responses, from the memory side to the CPU side. */
+    Channel responses;
+
+    /** Number of packets posted but not sent yet, for draining. */
+    std::atomic<uint64_t> inFlight;
+
+    EventQueueBridgeStats stats;
+};
+
+#endif //__MEM_EVENTQ_BRIDGE_HH__
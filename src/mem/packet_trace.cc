@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/packet_trace.hh"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "base/logging.hh"
+
+using namespace std;
+
+namespace PacketTrace {
+
+const char magic[8] = {'g', 'e', 'm', '5', 'p', 'k', 't', 'b'};
+
+/** Write a plain value to a file. */
+template <class T>
+static void
+writeValue(ostream &os, const T &value)
+{
+    os.write((const char *)&value, sizeof(value));
+}
+
+/** Write a string to a file, preceded by its size. */
+static void
+writeString(ostream &os, const string &str)
+{
+    writeValue(os, (uint32_t)str.size());
+    os.write(str.data(), str.size());
+}
+
+/** Read a plain value from a file. */
+template <class T>
+static bool
+readValue(istream &is, T &value)
+{
+    return (bool)is.read((char *)&value, sizeof(value));
+}
+
+/** Read a string preceded by its size from a file. */
+static bool
+readString(istream &is, string &str)
+{
+    uint32_t size;
+    if (!readValue(is, size))
+        return false;
+    str.resize(size);
+    return size == 0 || (bool)is.read(&str[0], size);
+}
+
+bool
+isBinaryTrace(const string &filename)
+{
+    ifstream file(filename, ios::in | ios::binary);
+    char file_magic[sizeof(magic)];
+    return file.read(file_magic, sizeof(file_magic)) &&
+        memcmp(file_magic, magic, sizeof(magic)) == 0;
+}
+
+Writer::Writer(const string &filename, uint64_t tick_freq,
+               const string &obj_id, const map<uint16_t, string> &masters,
+               bool compress, uint32_t records_per_block)
+    : file(filename, ios::out | ios::binary | ios::trunc),
+      compress(compress), recordsPerBlock(records_per_block), firstTick(0)
+{
+    if (!file.good())
+        panic("Could not open %s for writing\n", filename);
+    panic_if(records_per_block == 0, "Blocks must hold records.\n");
+
+    FileHeader header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.flags = compress ? CompressedFlag : 0;
+    header.tickFreq = tick_freq;
+    header.recordsPerBlock = records_per_block;
+    header.numMasters = masters.size();
+    writeValue(file, header);
+
+    writeString(file, obj_id);
+    for (const auto &master : masters) {
+        writeValue(file, (uint32_t)master.first);
+        writeString(file, master.second);
+    }
+
+    records.reserve(recordsPerBlock);
+}
+
+Writer::~Writer()
+{
+    close();
+}
+
+void
+Writer::write(const Packet &pkt)
+{
+    // The ticks are stored relative to the first record of the block,
+    // so start a new block if the tick does not fit
+    if (!records.empty() &&
+        (records.size() == recordsPerBlock || pkt.tick < firstTick ||
+         pkt.tick - firstTick > numeric_limits<uint32_t>::max())) {
+        writeBlock();
+    }
+
+    if (records.empty())
+        firstTick = pkt.tick;
+
+    Record rec;
+    rec.addr = pkt.addr;
+    rec.pc = pkt.pc;
+    rec.tickDelta = pkt.tick - firstTick;
+    rec.flags = pkt.flags;
+    rec.size = pkt.size;
+    rec.cmd = pkt.cmd;
+    rec.master = pkt.master;
+    records.push_back(rec);
+}
+
+void
+Writer::writeBlock()
+{
+    BlockInfo info;
+    info.offset = file.tellp();
+    info.firstTick = firstTick;
+    info.numRecords = records.size();
+
+    const char *data = (const char *)records.data();
+    uLongf size = records.size() * sizeof(Record);
+    if (compress) {
+        vector<Bytef> buf(compressBound(size));
+        uLongf buf_size = buf.size();
+        if (compress2(buf.data(), &buf_size, (const Bytef *)data, size,
+                      Z_DEFAULT_COMPRESSION) != Z_OK) {
+            panic("Failed to compress a packet trace block\n");
+        }
+        file.write((const char *)buf.data(), buf_size);
+        info.storedSize = buf_size;
+    } else {
+        file.write(data, size);
+        info.storedSize = size;
+    }
+
+    index.push_back(info);
+    records.clear();
+}
+
+void
+Writer::flush()
+{
+    if (!records.empty())
+        writeBlock();
+    file.flush();
+}
+
+void
+Writer::close()
+{
+    if (!file.is_open())
+        return;
+
+    if (!records.empty())
+        writeBlock();
+
+    Footer footer;
+    footer.indexOffset = file.tellp();
+    footer.numBlocks = index.size();
+    memcpy(footer.magic, magic, sizeof(magic));
+
+    file.write((const char *)index.data(), index.size() * sizeof(BlockInfo));
+    writeValue(file, footer);
+    file.close();
+}
+
+Reader::Reader(const string &filename)
+    : file(filename, ios::in | ios::binary), filename(filename),
+      _numPackets(0), curBlock(0), curRecord(0)
+{
+    if (!file.good())
+        panic("Could not open %s for reading\n", filename);
+
+    if (!readValue(file, header) ||
+        memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        fatal("%s is not a binary packet trace.\n", filename);
+    }
+    fatal_if(header.version != version,
+             "Unsupported version %d of binary packet trace %s.\n",
+             header.version, filename);
+
+    bool good = readString(file, _objId);
+    for (uint32_t i = 0; good && i < header.numMasters; ++i) {
+        uint32_t id;
+        string name;
+        good = readValue(file, id) && readString(file, name);
+        _masters[id] = name;
+    }
+
+    Footer footer;
+    good = good && file.seekg(-(streamoff)sizeof(footer), ios::end) &&
+        readValue(file, footer) &&
+        memcmp(footer.magic, magic, sizeof(magic)) == 0;
+    if (good) {
+        index.resize(footer.numBlocks);
+        good = file.seekg(footer.indexOffset) &&
+            file.read((char *)index.data(),
+                      index.size() * sizeof(BlockInfo));
+    }
+    fatal_if(!good, "Binary packet trace %s is truncated.\n", filename);
+
+    for (const auto &info : index)
+        _numPackets += info.numRecords;
+
+    reset();
+}
+
+void
+Reader::loadBlock(size_t block)
+{
+    curBlock = block;
+    curRecord = 0;
+    records.clear();
+    if (block >= index.size())
+        return;
+
+    const BlockInfo &info = index[block];
+    records.resize(info.numRecords);
+    uLongf size = info.numRecords * sizeof(Record);
+
+    file.seekg(info.offset);
+    bool good;
+    if (header.flags & CompressedFlag) {
+        vector<Bytef> buf(info.storedSize);
+        good = file.read((char *)buf.data(), buf.size()) &&
+            uncompress((Bytef *)records.data(), &size, buf.data(),
+                       buf.size()) == Z_OK &&
+            size == info.numRecords * sizeof(Record);
+    } else {
+        good = (bool)file.read((char *)records.data(), size);
+    }
+    fatal_if(!good, "Failed to read block %d of binary packet trace %s.\n",
+             block, filename);
+}
+
+bool
+Reader::read(Packet &pkt)
+{
+    while (curRecord == records.size()) {
+        if (curBlock + 1 >= index.size())
+            return false;
+        loadBlock(curBlock + 1);
+    }
+
+    const Record &rec = records[curRecord++];
+    pkt.tick = index[curBlock].firstTick + rec.tickDelta;
+    pkt.addr = rec.addr;
+    pkt.pc = rec.pc;
+    pkt.flags = rec.flags;
+    pkt.size = rec.size;
+    pkt.cmd = rec.cmd;
+    pkt.master = rec.master;
+    return true;
+}
+
+void
+Reader::seek(Tick tick)
+{
+    // Find the last block starting at or before the tick, as it may
+    // hold the first packet at or after it
+    auto it = upper_bound(index.begin(), index.end(), tick,
+        [](Tick t, const BlockInfo &info) { return t < info.firstTick; });
+    loadBlock(it == index.begin() ? 0 : it - index.begin() - 1);
+
+    while (curBlock < index.size()) {
+        const Tick first_tick = index[curBlock].firstTick;
+        while (curRecord < records.size() &&
+               first_tick + records[curRecord].tickDelta < tick) {
+            ++curRecord;
+        }
+        if (curRecord < records.size() || curBlock + 1 >= index.size())
+            return;
+        loadBlock(curBlock + 1);
+    }
+}
+
+void
+Reader::reset()
+{
+    loadBlock(0);
+}
+
+} // namespace PacketTrace
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_PACKET_TRACE_HH__
+#define __MEM_PACKET_TRACE_HH__
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * @file
+ * A compact binary format for memory packet traces, as an alternative
+ * to the protobuf packet traces for traces of billions of packets.
+ *
+ * A file starts with a FileHeader, followed by the name of the traced
+ * object and the names of the masters, and then by blocks of
+ * fixed-size Records. The ticks of the records are stored relative
+ * to the tick of the first record of their block, and a block ends
+ * early if a tick does not fit. The file ends with an index giving
+ * the offset, first tick and number of records of every block,
+ * followed by a Footer locating the index.
+ *
+ * Blocks are optionally compressed with zlib, one block at a
+ * time, and the index makes the file seekable by tick. The blocks
+ * are not aligned, so they are read into a buffer rather than
+ * accessed in place. All fields are in host byte order.
+ */
+
+namespace PacketTrace {
+
+/** Magic string at the start and the end of a binary packet trace. */
+extern const char magic[8];
+
+/** Current version of the format. */
+const uint32_t version = 1;
+
+/** The blocks are compressed with zlib. */
+const uint32_t CompressedFlag = 0x1;
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t tickFreq;
+    uint32_t recordsPerBlock;
+    uint32_t numMasters;
+};
+
+/** A packet, as stored in a block. */
+struct Record
+{
+    uint64_t addr;
+    uint64_t pc;
+    /** Tick relative to the first record of the block. */
+    uint32_t tickDelta;
+    uint32_t flags;
+    uint32_t size;
+    uint16_t cmd;
+    uint16_t master;
+};
+
+/** Location of a block in the file. */
+struct BlockInfo
+{
+    uint64_t offset;
+    uint64_t firstTick;
+    uint32_t numRecords;
+    /** Size of the block in the file, which differs if compressed. */
+    uint32_t storedSize;
+};
+
+struct Footer
+{
+    uint64_t indexOffset;
+    uint64_t numBlocks;
+    char magic[8];
+};
+
+/** A packet of a trace, with its absolute tick. */
+struct Packet
+{
+    Tick tick;
+    Addr addr;
+    /** The PC of the request, 0 if not known. */
+    Addr pc;
+    uint32_t flags;
+    uint32_t size;
+    uint16_t cmd;
+    uint16_t master;
+};
+
+/**
+ * Determine whether a file is a binary packet trace.
+ *
+ * @param filename Path to the file
+ */
+bool isBinaryTrace(const std::string &filename);
+
+/**
+ * Writer of binary packet traces.
+ */
+class Writer
+{
+  public:
+    /**
+     * Create a binary packet trace and write its header.
+     *
+     * @param filename Path to the file to create or truncate
+     * @param tick_freq Tick frequency of the trace
+     * @param obj_id Name of the traced object
+     * @param masters Names of the masters, by master id
+     * @param compress Whether to compress the blocks
+     * @param records_per_block Maximum number of records of a block
+     */
+    Writer(const std::string &filename, uint64_t tick_freq,
+           const std::string &obj_id,
+           const std::map<uint16_t, std::string> &masters,
+           bool compress, uint32_t records_per_block = 4096);
+
+    /** Close the trace if not done yet. */
+    ~Writer();
+
+    /**
+     * Add a packet to the trace.
+     */
+    void write(const Packet &pkt);
+
+    /**
+     * Write the records added so far to the file, ending the current
+     * block.
+     */
+    void flush();
+
+    /**
+     * Write the remaining records and the index, and close the file.
+     */
+    void close();
+
+  private:
+    /** Write a block of the trace. */
+    void writeBlock();
+
+    std::ofstream file;
+
+    const bool compress;
+
+    const uint32_t recordsPerBlock;
+
+    /** Records of the current block. */
+    std::vector<Record> records;
+
+    /** Tick of the first record of the current block. */
+    Tick firstTick;
+
+    /** Location of the blocks written so far. */
+    std::vector<BlockInfo> index;
+};
+
+/**
+ * Reader of binary packet traces, which reads the file one block at a
+ * time.
+ */
+class Reader
+{
+  public:
+    /**
+     * Open a binary packet trace and read its header and index.
+     *
+     * @param filename Path to the file to read from
+     */
+    Reader(const std::string &filename);
+
+    /** The tick frequency the trace was recorded with. */
+    uint64_t tickFreq() const { return header.tickFreq; }
+
+    /** The name of the traced object. */
+    const std::string &objId() const { return _objId; }
+
+    /** The names of the masters, by master id. */
+    const std::map<uint16_t, std::string> &
+    masters() const
+    {
+        return _masters;
+    }
+
+    /** The number of packets of the trace. */
+    uint64_t numPackets() const { return _numPackets; }
+
+    /**
+     * Read the next packet of the trace.
+     *
+     * @param pkt Packet to populate
+     * @return True if a packet was read, false at the end of the trace
+     */
+    bool read(Packet &pkt);
+
+    /**
+     * Seek to the first packet at or after a tick. The packets are
+     * assumed to be ordered by tick.
+     *
+     * @param tick Tick to seek to
+     */
+    void seek(Tick tick);
+
+    /** Seek to the beginning of the trace. */
+    void reset();
+
+  private:
+    /** Read a block of the trace, making it the current one. */
+    void loadBlock(size_t block);
+
+    std::ifstream file;
+
+    const std::string filename;
+
+    FileHeader header;
+
+    std::string _objId;
+
+    std::map<uint16_t, std::string> _masters;
+
+    uint64_t _numPackets;
+
+    std::vector<BlockInfo> index;
+
+    /** Records of the current block. */
+    std::vector<Record> records;
+
+    /** Index of the current block. */
+    size_t curBlock;
+
+    /** Index of the next record of the current block. */
+    size_t curRecord;
+};
+
+} // namespace PacketTrace
+
+#endif // __MEM_PACKET_TRACE_HH__
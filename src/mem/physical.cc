@@ -39,21 +39,34 @@
 
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/user.h>
 #include <unistd.h>
 #include <zlib.h>
 
+#include <atomic>
 #include <cerrno>
 #include <climits>
+#include <cstddef>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
+#include <thread>
 
+#include "base/atomicio.hh"
+#include "base/intmath.hh"
+#include "base/str.hh"
 #include "base/trace.hh"
 #include "debug/AddrRanges.hh"
 #include "debug/Checkpoint.hh"
 #include "mem/abstract_mem.hh"
+#include "sim/byteswap.hh"
 
 /**
  * On Linux, MAP_NORESERVE allow us to simulate a very large memory
@@ -69,14 +82,323 @@
 
 using namespace std;
 
+/**
+ * Header of a chunked memory checkpoint file. The header is followed
+ * by the name of the base store of an incremental checkpoint, if
+ * any, relative to the directory of the file. Then follows an index
+ * with one entry per chunk, and the compressed chunks in the order
+ * they were written, which is not necessarily the order of the
+ * chunks in memory. All fields are little endian. Version 1 files do
+ * not have the base name size, and are never incremental. Version 2
+ * files do not have the identities, and their base is not checked.
+ */
+struct ChunkedStoreHeader
+{
+    char magic[8];
+    uint64_t version;
+    uint64_t rangeSize;
+    uint64_t chunkSize;
+    uint64_t numChunks;
+    uint64_t baseNameSize;
+    // digest of the contents of this store, including its base
+    uint64_t storeId;
+    // identity of the base store when this store was written
+    uint64_t baseStoreId;
+};
+
+/**
+ * Index entry of a chunk in a chunked memory checkpoint file. A size
+ * of zero means that the chunk is not stored, either because it only
+ * contains zeros, or, if the offset is chunkedStoreInBase, because it
+ * is unchanged since the base store.
+ */
+struct ChunkedStoreIndexEntry
+{
+    uint64_t offset;
+    uint64_t size;
+};
+
+static const char chunkedStoreMagic[8] = {'g', 'e', 'm', '5',
+                                          'p', 'm', 'e', 'm'};
+static const uint64_t chunkedStoreVersion = 3;
+static const uint64_t chunkedStoreChunkSize = 1 << 20;
+static const uint64_t chunkedStoreInBase = ~0ULL;
+
+/**
+ * Compute a 64-bit digest of a chunk of memory, used to find the
+ * chunks that changed since the previous checkpoint.
+ */
+static uint64_t
+chunkDigest(const uint8_t* data, uint64_t len)
+{
+    const uint64_t prime1 = 0x9e3779b185ebca87ULL;
+    const uint64_t prime2 = 0xc2b2ae3d27d4eb4fULL;
+
+    uint64_t words = len / sizeof(uint64_t);
+    const uint64_t* data_words = (const uint64_t*) data;
+    uint64_t h = len * prime1;
+    for (uint64_t i = 0; i < words; ++i) {
+        h ^= data_words[i] * prime2;
+        h = ((h << 31) | (h >> 33)) * prime1;
+    }
+    for (uint64_t i = words * sizeof(uint64_t); i < len; ++i)
+        h = (h ^ data[i]) * prime1;
+
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    return h;
+}
+
+/**
+ * Get the canonical absolute path of an existing file.
+ */
+static string
+absolutePath(const string& path)
+{
+    char* resolved = realpath(path.c_str(), NULL);
+    if (!resolved)
+        fatal("Can't resolve the path of '%s'\n", path);
+    string abs_path(resolved);
+    free(resolved);
+    return abs_path;
+}
+
+/**
+ * Express an absolute path relative to an absolute directory.
+ */
+static string
+relativePath(const string& dir, const string& path)
+{
+    vector<string> dir_parts, path_parts;
+    tokenize(dir_parts, dir, '/');
+    tokenize(path_parts, path, '/');
+
+    size_t common = 0;
+    while (common < dir_parts.size() && common + 1 < path_parts.size() &&
+           dir_parts[common] == path_parts[common])
+        ++common;
+
+    string rel_path;
+    for (size_t i = common; i < dir_parts.size(); ++i)
+        rel_path += "../";
+    for (size_t i = common; i < path_parts.size(); ++i)
+        rel_path += path_parts[i] + (i + 1 < path_parts.size() ? "/" : "");
+    return rel_path;
+}
+
+/**
+ * Get the directory part of a path.
+ */
+static string
+dirName(const string& path)
+{
+    size_t pos = path.rfind('/');
+    return pos == string::npos ? "." : path.substr(0, pos);
+}
+
+/**
+ * Check if a block of memory only contains zeros.
+ */
+static bool
+isZeroBlock(const uint8_t* data, uint64_t len)
+{
+    uint64_t words = len / sizeof(uint64_t);
+    const uint64_t* data_words = (const uint64_t*) data;
+    for (uint64_t i = 0; i < words; ++i)
+        if (data_words[i] != 0)
+            return false;
+    for (uint64_t i = words * sizeof(uint64_t); i < len; ++i)
+        if (data[i] != 0)
+            return false;
+    return true;
+}
+
+/**
+ * Read or write a block at a given offset in a file, retrying on
+ * partial transfers. These are safe to use from multiple threads.
+ */
+static bool
+preadAll(int fd, void* buf, uint64_t len, uint64_t offset)
+{
+    uint8_t* cur = (uint8_t*) buf;
+    while (len > 0) {
+        ssize_t ret = pread(fd, cur, len, offset);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        cur += ret;
+        len -= ret;
+        offset += ret;
+    }
+    return true;
+}
+
+static bool
+pwriteAll(int fd, const void* buf, uint64_t len, uint64_t offset)
+{
+    const uint8_t* cur = (const uint8_t*) buf;
+    while (len > 0) {
+        ssize_t ret = pwrite(fd, cur, len, offset);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        cur += ret;
+        len -= ret;
+        offset += ret;
+    }
+    return true;
+}
+
+/**
+ * Read the header and the base name of a chunked store.
+ *
+ * @return The offset of the index in the file
+ */
+static uint64_t
+readChunkedStoreHeader(int fd, const string& filepath,
+                       ChunkedStoreHeader& header, string& base_name)
+{
+    if (!preadAll(fd, &header, sizeof(header), 0) ||
+        memcmp(header.magic, chunkedStoreMagic, sizeof(header.magic)) ||
+        letoh(header.version) < 1 ||
+        letoh(header.version) > chunkedStoreVersion) {
+        fatal("Physical memory checkpoint file '%s' is not a chunked "
+              "store\n", filepath);
+    }
+
+    // older headers end before the fields they do not have
+    const uint64_t version = letoh(header.version);
+    if (version < 3)
+        header.storeId = header.baseStoreId = 0;
+    if (version < 2) {
+        header.baseNameSize = 0;
+        base_name.clear();
+        return offsetof(ChunkedStoreHeader, baseNameSize);
+    }
+
+    const uint64_t header_size = version < 3 ?
+        offsetof(ChunkedStoreHeader, storeId) : sizeof(header);
+    base_name.resize(letoh(header.baseNameSize));
+    if (!preadAll(fd, &base_name[0], base_name.size(), header_size))
+        fatal("Read failed on physical memory checkpoint file '%s'\n",
+              filepath);
+    return header_size + base_name.size();
+}
+
+/**
+ * Get the absolute paths of the chain of base stores of a chunked
+ * store, starting with the store itself.
+ */
+static vector<string>
+chunkedStoreChain(const string& filepath)
+{
+    vector<string> chain;
+    string path = absolutePath(filepath);
+    while (find(chain.begin(), chain.end(), path) == chain.end()) {
+        chain.push_back(path);
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            break;
+        ChunkedStoreHeader header;
+        string base_name;
+        readChunkedStoreHeader(fd, path, header, base_name);
+        close(fd);
+        if (base_name.empty())
+            break;
+
+        const string base_path = dirName(path) + "/" + base_name;
+        if (access(base_path.c_str(), F_OK) != 0)
+            break;
+        path = absolutePath(base_path);
+    }
+    return chain;
+}
+
+/**
+ * The default huge page size of the host as reported by the kernel,
+ * or zero if huge pages are not available.
+ */
+static uint64_t
+hostHugePageSize()
+{
+    ifstream meminfo("/proc/meminfo");
+    string key;
+    uint64_t size_kb;
+    while (meminfo >> key) {
+        if (key == "Hugepagesize:" && meminfo >> size_kb)
+            return size_kb * 1024;
+        meminfo.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+    return 0;
+}
+
+/**
+ * Bind a region of host memory to a single host NUMA node. We use
+ * the mbind system call directly rather than depending on libnuma,
+ * and the region must not have been touched yet for the policy to
+ * determine where the pages are allocated.
+ *
+ * @return true if the policy was applied
+ */
+static bool
+bindToNumaNode(void *addr, uint64_t len, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    // constants from linux/mempolicy.h
+    const int mpol_bind = 2;
+    const unsigned long bits_per_long = sizeof(unsigned long) * CHAR_BIT;
+    const unsigned long max_nodes = 1024;
+
+    if (node < 0 || (unsigned long)node >= max_nodes)
+        return false;
+
+    vector<unsigned long> node_mask(max_nodes / bits_per_long, 0);
+    node_mask[node / bits_per_long] |= 1UL << (node % bits_per_long);
+
+    return syscall(SYS_mbind, addr, len, mpol_bind, node_mask.data(),
+                   max_nodes + 1, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Atomically replace a file with a newly written one.
+ */
+static void
+replaceFile(const string& tmp_path, const string& path)
+{
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+        perror("rename");
+        fatal("Can't move '%s' to '%s'\n", tmp_path, path);
+    }
+}
+
 PhysicalMemory::PhysicalMemory(const string& _name,
                                const vector<AbstractMemory*>& _memories,
-                               bool mmap_using_noreserve) :
-    _name(_name), size(0), mmapUsingNoReserve(mmap_using_noreserve)
+                               bool mmap_using_noreserve,
+                               HugePageMode huge_page_mode,
+                               const vector<int>& eventq_numa_nodes,
+                               MemoryCheckpointFormat checkpoint_format,
+                               unsigned checkpoint_threads,
+                               bool checkpoint_incremental) :
+    _name(_name), size(0), mmapUsingNoReserve(mmap_using_noreserve),
+    hugePageMode(huge_page_mode), eventqNumaNodes(eventq_numa_nodes),
+    checkpointFormat(checkpoint_format),
+    checkpointThreads(checkpoint_threads),
+    checkpointIncremental(checkpoint_incremental)
 {
     if (mmap_using_noreserve)
         warn("Not reserving swap space. May cause SIGSEGV on actual usage\n");
 
+    fatal_if(checkpoint_incremental &&
+             checkpoint_format != MemoryCheckpointFormat::chunked,
+             "Incremental memory checkpoints require the chunked format\n");
+
     // add the memories from the system to the address map as
     // appropriate
     for (const auto& m : _memories) {
@@ -192,6 +514,47 @@ PhysicalMemory::createBackingStore(AddrRange range,
     // perform the actual mmap
     DPRINTF(AddrRanges, "Creating backing store for range %s with size %d\n",
             range.to_string(), range.size());
+
+    string page_type;
+    uint8_t* pmem = mapBackingStore(range, page_type);
+
+    // bind the backing store to the host NUMA node of the event
+    // queue simulating the memories, before any page is touched
+    int node = numaNode(_memories);
+    string placement = "default";
+    if (node >= 0) {
+        if (bindToNumaNode(pmem, range.size(), node)) {
+            placement = csprintf("node %d", node);
+        } else {
+            warn("Could not bind backing store for range %s to host NUMA "
+                 "node %d\n", range.to_string(), node);
+        }
+    }
+
+    // report what the host actually gave us if the user asked for
+    // anything beyond the defaults
+    if (hugePageMode != HugePageMode::none || !eventqNumaNodes.empty()) {
+        inform("Backing store for range %s uses %s pages, %s NUMA "
+               "placement\n", range.to_string(), page_type, placement);
+    }
+
+    // remember this backing store so we can checkpoint it and unmap
+    // it appropriately
+    backingStore.emplace_back(range, pmem,
+                              conf_table_reported, in_addr_map, kvm_map,
+                              placement == "default" ? -1 : node);
+
+    // point the memories to their backing store
+    for (const auto& m : _memories) {
+        DPRINTF(AddrRanges, "Mapping memory %s to backing store\n",
+                m->name());
+        m->setBackingStore(pmem);
+    }
+}
+
+uint8_t*
+PhysicalMemory::mapBackingStore(AddrRange range, string& page_type) const
+{
     int map_flags = MAP_ANON | MAP_PRIVATE;
 
     // to be able to simulate very large memories, the user can opt to
@@ -200,9 +563,37 @@ PhysicalMemory::createBackingStore(AddrRange range,
         map_flags |= MAP_NORESERVE;
     }
 
-    uint8_t* pmem = (uint8_t*) mmap(NULL, range.size(),
-                                    PROT_READ | PROT_WRITE,
-                                    map_flags, -1, 0);
+    uint8_t* pmem = (uint8_t*) MAP_FAILED;
+    page_type = "base";
+
+#if defined(MAP_HUGETLB)
+    if (hugePageMode == HugePageMode::hugetlb) {
+        // the kernel requires the length of a hugetlb mapping to be a
+        // multiple of the huge page size for it to be unmapped again
+        uint64_t huge_page_size = hostHugePageSize();
+        if (huge_page_size && range.size() % huge_page_size == 0) {
+            pmem = (uint8_t*) mmap(NULL, range.size(),
+                                   PROT_READ | PROT_WRITE,
+                                   map_flags | MAP_HUGETLB, -1, 0);
+        }
+
+        if (pmem == (uint8_t*) MAP_FAILED) {
+            warn("Could not mmap explicit huge pages for range %s, "
+                 "falling back to base pages\n", range.to_string());
+        } else {
+            page_type = csprintf("explicit %d kB huge",
+                                 huge_page_size / 1024);
+        }
+    }
+#else
+    warn_if(hugePageMode == HugePageMode::hugetlb,
+            "Explicit huge pages are not supported on this host\n");
+#endif
+
+    if (pmem == (uint8_t*) MAP_FAILED) {
+        pmem = (uint8_t*) mmap(NULL, range.size(), PROT_READ | PROT_WRITE,
+                               map_flags, -1, 0);
+    }
 
     if (pmem == (uint8_t*) MAP_FAILED) {
         perror("mmap");
@@ -210,17 +601,47 @@ PhysicalMemory::createBackingStore(AddrRange range,
               range.to_string());
     }
 
-    // remember this backing store so we can checkpoint it and unmap
-    // it appropriately
-    backingStore.emplace_back(range, pmem,
-                              conf_table_reported, in_addr_map, kvm_map);
+    if (hugePageMode == HugePageMode::transparent) {
+#if defined(MADV_HUGEPAGE)
+        if (madvise(pmem, range.size(), MADV_HUGEPAGE) == 0) {
+            page_type = "transparent huge";
+        } else {
+            warn("Could not advise transparent huge pages for range %s\n",
+                 range.to_string());
+        }
+#else
+        warn("Transparent huge pages are not supported on this host\n");
+#endif
+    }
 
-    // point the memories to their backing store
+    return pmem;
+}
+
+int
+PhysicalMemory::numaNode(const vector<AbstractMemory*>& _memories) const
+{
+    if (eventqNumaNodes.empty() || _memories.empty())
+        return -1;
+
+    // all the memories sharing a backing store (e.g. interleaved
+    // controllers) have to be simulated by the same event queue for
+    // the placement to be meaningful
+    uint32_t eventq_index = _memories.front()->params()->eventq_index;
     for (const auto& m : _memories) {
-        DPRINTF(AddrRanges, "Mapping memory %s to backing store\n",
-                m->name());
-        m->setBackingStore(pmem);
+        if (m->params()->eventq_index != eventq_index) {
+            warn("Memories sharing a backing store with %s are on "
+                 "different event queues, not binding to a NUMA node\n",
+                 m->name());
+            return -1;
+        }
+    }
+
+    if (eventq_index >= eventqNumaNodes.size()) {
+        warn("No host NUMA node given for event queue %d\n", eventq_index);
+        return -1;
     }
+
+    return eventqNumaNodes[eventq_index];
 }
 
 PhysicalMemory::~PhysicalMemory()
@@ -338,6 +759,19 @@ PhysicalMemory::serializeStore(CheckpointOut &cp, unsigned int store_id,
 
     // write memory file
     string filepath = CheckpointIn::dir() + "/" + filename.c_str();
+
+    if (checkpointFormat == MemoryCheckpointFormat::raw) {
+        string format = "raw";
+        SERIALIZE_SCALAR(format);
+        writeRawStore(filepath, range, pmem);
+        return;
+    } else if (checkpointFormat == MemoryCheckpointFormat::chunked) {
+        string format = "chunked";
+        SERIALIZE_SCALAR(format);
+        writeChunkedStore(filepath, store_id, range, pmem);
+        return;
+    }
+
     gzFile compressed_mem = gzopen(filepath.c_str(), "wb");
     if (compressed_mem == NULL)
         fatal("Can't open physical memory checkpoint file '%s'\n",
@@ -366,6 +800,217 @@ PhysicalMemory::serializeStore(CheckpointOut &cp, unsigned int store_id,
 
 }
 
+void
+PhysicalMemory::writeRawStore(const string& filepath, AddrRange range,
+                              uint8_t* pmem) const
+{
+    // truncating the file in place would pull the pages from under a
+    // restored store that still maps it, so write a new file instead
+    const string tmp_path = filepath + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n",
+              tmp_path);
+
+    // only write the pages that contain data, and leave the rest as
+    // holes, so that the file (and the memory that maps it when
+    // restoring) stays sparse
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    vector<uint8_t> zero_page(page_size, 0);
+
+    for (uint64_t offset = 0; offset < range.size(); offset += page_size) {
+        uint64_t len = min(page_size, range.size() - offset);
+        if (memcmp(pmem + offset, zero_page.data(), len) == 0)
+            continue;
+
+        if (lseek(fd, offset, SEEK_SET) != (off_t)offset ||
+            atomic_write(fd, pmem + offset, len) != (ssize_t)len) {
+            fatal("Write failed on physical memory checkpoint file '%s'\n",
+                  filepath);
+        }
+    }
+
+    // extend the file to the full size of the store, as trailing
+    // zero pages are not written
+    if (ftruncate(fd, range.size()) != 0 || close(fd) != 0)
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              tmp_path);
+
+    replaceFile(tmp_path, filepath);
+}
+
+void
+PhysicalMemory::writeChunkedStore(const string& filepath,
+                                  unsigned int store_id, AddrRange range,
+                                  uint8_t* pmem) const
+{
+    // the store is written under a temporary name, so that the file
+    // it replaces stays readable until the new one is complete
+    const string tmp_path = filepath + ".tmp";
+    const string abs_path = absolutePath(dirName(filepath)) +
+        filepath.substr(filepath.rfind('/'));
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n",
+              tmp_path);
+
+    const uint64_t chunk_size = chunkedStoreChunkSize;
+    const uint64_t num_chunks = divCeil(range.size(), chunk_size);
+
+    // for incremental checkpoints, the chunks that are unchanged
+    // since the previous checkpoint refer to the store of that
+    // checkpoint instead
+    if (lastStoreFiles.size() < backingStore.size()) {
+        lastStoreFiles.resize(backingStore.size());
+        lastStoreDigests.resize(backingStore.size());
+        lastStoreIds.resize(backingStore.size());
+    }
+    const vector<uint64_t>& base_digests = lastStoreDigests[store_id];
+    // a store cannot replace any store of the chain it would refer
+    // to, e.g. when checkpointing to the directory the simulation was
+    // restored from, as that would break the chain
+    bool replaces_base = false;
+    if (checkpointIncremental && !lastStoreFiles[store_id].empty()) {
+        const vector<string> chain =
+            chunkedStoreChain(lastStoreFiles[store_id]);
+        replaces_base =
+            find(chain.begin(), chain.end(), abs_path) != chain.end();
+    }
+    warn_if(replaces_base, "Physical memory checkpoint file '%s' replaces "
+            "one of its base stores, storing it in full\n", filepath);
+    const bool incremental = checkpointIncremental && !replaces_base &&
+        base_digests.size() == num_chunks;
+    const uint64_t base_id = incremental ? lastStoreIds[store_id] : 0;
+    vector<uint64_t> digests(checkpointIncremental ? num_chunks : 0);
+
+    string base_name;
+    if (incremental) {
+        base_name = relativePath(dirName(abs_path),
+                                 lastStoreFiles[store_id]);
+        DPRINTF(Checkpoint, "Storing changes of %s relative to %s\n",
+                filepath, base_name);
+    }
+
+    // the index is filled in by the workers as they go, and the
+    // compressed chunks are appended after it in whatever order the
+    // workers finish them
+    vector<ChunkedStoreIndexEntry> index(num_chunks,
+                                         ChunkedStoreIndexEntry{0, 0});
+    // the digests of the compressed chunks make up the identity of
+    // the store, which the stores based on it record
+    vector<uint64_t> chunk_ids(num_chunks + 1, 0);
+    chunk_ids[num_chunks] = base_id;
+    const uint64_t index_start = sizeof(ChunkedStoreHeader) +
+        base_name.size();
+    const uint64_t data_start = index_start +
+        num_chunks * sizeof(ChunkedStoreIndexEntry);
+
+    atomic<uint64_t> next_chunk(0);
+    atomic<uint64_t> file_end(data_start);
+    atomic<uint64_t> unchanged_chunks(0);
+    atomic<bool> failed(false);
+
+    runOnThreads(num_chunks, [&]() {
+        vector<Bytef> buf(compressBound(chunk_size));
+        for (uint64_t i = next_chunk++; i < num_chunks && !failed;
+             i = next_chunk++) {
+            uint64_t offset = i * chunk_size;
+            uint64_t len = min(chunk_size, range.size() - offset);
+
+            if (checkpointIncremental) {
+                digests[i] = chunkDigest(pmem + offset, len);
+                if (incremental && digests[i] == base_digests[i]) {
+                    index[i].offset = htole(chunkedStoreInBase);
+                    chunk_ids[i] = chunkedStoreInBase;
+                    ++unchanged_chunks;
+                    continue;
+                }
+            }
+
+            if (isZeroBlock(pmem + offset, len))
+                continue;
+
+            uLongf comp_len = buf.size();
+            if (compress2(buf.data(), &comp_len, pmem + offset, len,
+                          Z_BEST_SPEED) != Z_OK) {
+                failed = true;
+                break;
+            }
+
+            uint64_t file_offset = file_end.fetch_add(comp_len);
+            if (!pwriteAll(fd, buf.data(), comp_len, file_offset)) {
+                failed = true;
+                break;
+            }
+
+            index[i].offset = htole(file_offset);
+            index[i].size = htole((uint64_t)comp_len);
+            chunk_ids[i] = chunkDigest(buf.data(), comp_len);
+        }
+    });
+
+    if (failed)
+        fatal("Write failed on physical memory checkpoint file '%s'\n",
+              tmp_path);
+
+    ChunkedStoreHeader header;
+    memcpy(header.magic, chunkedStoreMagic, sizeof(header.magic));
+    header.version = htole(chunkedStoreVersion);
+    header.rangeSize = htole(range.size());
+    header.chunkSize = htole(chunk_size);
+    header.numChunks = htole(num_chunks);
+    header.baseNameSize = htole((uint64_t)base_name.size());
+    const uint64_t store_id_digest =
+        chunkDigest((const uint8_t*) chunk_ids.data(),
+                    chunk_ids.size() * sizeof(uint64_t));
+    header.storeId = htole(store_id_digest);
+    header.baseStoreId = htole(base_id);
+
+    if (!pwriteAll(fd, &header, sizeof(header), 0) ||
+        !pwriteAll(fd, base_name.data(), base_name.size(), sizeof(header)) ||
+        !pwriteAll(fd, index.data(),
+                   num_chunks * sizeof(ChunkedStoreIndexEntry),
+                   index_start)) {
+        fatal("Write failed on physical memory checkpoint file '%s'\n",
+              tmp_path);
+    }
+
+    if (close(fd) != 0)
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              tmp_path);
+
+    replaceFile(tmp_path, filepath);
+
+    if (incremental) {
+        DPRINTF(Checkpoint, "%d of %d chunks unchanged since %s\n",
+                unchanged_chunks.load(), num_chunks, base_name);
+    }
+
+    // this store is the base of the next incremental checkpoint
+    if (checkpointIncremental) {
+        lastStoreFiles[store_id] = abs_path;
+        lastStoreDigests[store_id] = move(digests);
+        lastStoreIds[store_id] = store_id_digest;
+    }
+}
+
+void
+PhysicalMemory::runOnThreads(uint64_t work_items,
+                             const function<void()>& func) const
+{
+    uint64_t num_threads = checkpointThreads ? checkpointThreads :
+        max(thread::hardware_concurrency(), 1U);
+    num_threads = max(min(num_threads, work_items), (uint64_t)1);
+
+    // the calling thread is one of the workers
+    vector<thread> workers;
+    for (uint64_t i = 1; i < num_threads; ++i)
+        workers.emplace_back(func);
+    func();
+    for (auto& w : workers)
+        w.join();
+}
+
 void
 PhysicalMemory::unserialize(CheckpointIn &cp)
 {
@@ -403,11 +1048,6 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
     UNSERIALIZE_SCALAR(filename);
     string filepath = cp.getCptDir() + "/" + filename;
 
-    // mmap memoryfile
-    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
-    if (compressed_mem == NULL)
-        fatal("Can't open physical memory checkpoint file '%s'", filename);
-
     // we've already got the actual backing store mapped
     uint8_t* pmem = backingStore[store_id].pmem;
     AddrRange range = backingStore[store_id].range;
@@ -422,6 +1062,27 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
         fatal("Memory range size has changed! Saw %lld, expected %lld\n",
               range_size, range.size());
 
+    // checkpoints without a format are gzip compressed
+    string format = "gzip";
+    UNSERIALIZE_OPT_SCALAR(format);
+
+    if (format == "raw") {
+        mapRawStore(filepath, range, pmem, backingStore[store_id].numaNode);
+        return;
+    } else if (format == "chunked") {
+        uint64_t id = readChunkedStore(filepath, range, pmem);
+        if (checkpointIncremental)
+            recordChunkDigests(filepath, store_id, range, pmem, id);
+        return;
+    } else if (format != "gzip") {
+        fatal("Unknown format '%s' for physical memory checkpoint file "
+              "'%s'\n", format, filename);
+    }
+
+    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
+    if (compressed_mem == NULL)
+        fatal("Can't open physical memory checkpoint file '%s'", filename);
+
     uint64_t curr_size = 0;
     long* temp_page = new long[chunk_size];
     long* pmem_current;
@@ -450,3 +1111,184 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
         fatal("Close failed on physical memory checkpoint file '%s'\n",
               filename);
 }
+
+void
+PhysicalMemory::mapRawStore(const string& filepath, AddrRange range,
+                            uint8_t* pmem, int node)
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n",
+              filepath);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size != range.size())
+        fatal("Physical memory checkpoint file '%s' does not match the "
+              "size of range %s\n", filepath, range.to_string());
+
+    // replace the anonymous memory with a private mapping of the
+    // file, at the same address so that the pointers already handed
+    // to the memories remain valid, writes only touch private copies
+    // of the pages
+    int map_flags = MAP_PRIVATE | MAP_FIXED;
+    if (mmapUsingNoReserve)
+        map_flags |= MAP_NORESERVE;
+
+    void *mapped = mmap(pmem, range.size(), PROT_READ | PROT_WRITE,
+                        map_flags, fd, 0);
+    if (mapped == MAP_FAILED || mapped != pmem) {
+        perror("mmap");
+        fatal("Could not mmap physical memory checkpoint file '%s'\n",
+              filepath);
+    }
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+
+    // the new mapping replaced the placement of the anonymous
+    // memory, restore it for the private copies of the pages
+    if (hugePageMode == HugePageMode::hugetlb) {
+        warn("Backing store for range %s is mapped from a raw checkpoint "
+             "and no longer uses explicit huge pages\n", range.to_string());
+    } else if (hugePageMode == HugePageMode::transparent) {
+#if defined(MADV_HUGEPAGE)
+        warn_if(madvise(pmem, range.size(), MADV_HUGEPAGE) != 0,
+                "Could not advise transparent huge pages for range %s\n",
+                range.to_string());
+#endif
+    }
+
+    if (node >= 0 && !bindToNumaNode(pmem, range.size(), node)) {
+        warn("Could not bind backing store for range %s to host NUMA "
+             "node %d\n", range.to_string(), node);
+    }
+}
+
+uint64_t
+PhysicalMemory::readChunkedStore(const string& filepath, AddrRange range,
+                                 uint8_t* pmem,
+                                 const vector<bool>* needed,
+                                 uint64_t expected_id) const
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n",
+              filepath);
+
+    ChunkedStoreHeader header;
+    string base_name;
+    const uint64_t index_start =
+        readChunkedStoreHeader(fd, filepath, header, base_name);
+
+    // a base store that was replaced after the store based on it was
+    // written no longer holds the unchanged chunks
+    const uint64_t store_id = letoh(header.storeId);
+    fatal_if(expected_id && store_id != expected_id, "Physical memory "
+             "checkpoint file '%s' was replaced after the checkpoints "
+             "based on it were taken\n", filepath);
+
+    const uint64_t chunk_size = letoh(header.chunkSize);
+    const uint64_t num_chunks = letoh(header.numChunks);
+    if (letoh(header.rangeSize) != range.size() || chunk_size == 0 ||
+        num_chunks != divCeil(range.size(), chunk_size)) {
+        fatal("Physical memory checkpoint file '%s' does not match the "
+              "size of range %s\n", filepath, range.to_string());
+    }
+
+    vector<ChunkedStoreIndexEntry> index(num_chunks);
+    if (!preadAll(fd, index.data(),
+                  num_chunks * sizeof(ChunkedStoreIndexEntry),
+                  index_start)) {
+        fatal("Read failed on physical memory checkpoint file '%s'\n",
+              filepath);
+    }
+
+    // chunks that are unchanged since the base store of an
+    // incremental checkpoint are read from the base store afterwards
+    vector<bool> base_needed(num_chunks, false);
+    bool any_base_needed = false;
+    for (uint64_t i = 0; i < num_chunks; ++i) {
+        if ((!needed || (*needed)[i]) &&
+            letoh(index[i].offset) == chunkedStoreInBase) {
+            base_needed[i] = true;
+            any_base_needed = true;
+        }
+    }
+
+    atomic<uint64_t> next_chunk(0);
+    atomic<bool> failed(false);
+
+    runOnThreads(num_chunks, [&]() {
+        vector<Bytef> buf;
+        for (uint64_t i = next_chunk++; i < num_chunks && !failed;
+             i = next_chunk++) {
+            // chunks of zeros are not stored, and the freshly mapped
+            // backing store is already zero, so do not touch it
+            uint64_t comp_len = letoh(index[i].size);
+            if (comp_len == 0 || (needed && !(*needed)[i]))
+                continue;
+
+            buf.resize(comp_len);
+            if (!preadAll(fd, buf.data(), comp_len,
+                          letoh(index[i].offset))) {
+                failed = true;
+                break;
+            }
+
+            uint64_t offset = i * chunk_size;
+            uLongf len = min(chunk_size, range.size() - offset);
+            uLongf expected_len = len;
+            if (uncompress(pmem + offset, &len, buf.data(),
+                           comp_len) != Z_OK || len != expected_len) {
+                failed = true;
+                break;
+            }
+        }
+    });
+
+    if (failed)
+        fatal("Read failed on physical memory checkpoint file '%s'\n",
+              filepath);
+
+    close(fd);
+
+    if (any_base_needed) {
+        fatal_if(base_name.empty(), "Physical memory checkpoint file '%s' "
+                 "refers to a base store but does not name it\n", filepath);
+        string base_path = dirName(filepath) + "/" + base_name;
+        DPRINTF(Checkpoint, "Reading unchanged chunks of %s from %s\n",
+                filepath, base_path);
+        readChunkedStore(base_path, range, pmem, &base_needed,
+                         letoh(header.baseStoreId));
+    }
+
+    return store_id;
+}
+
+void
+PhysicalMemory::recordChunkDigests(const string& filepath,
+                                   unsigned int store_id, AddrRange range,
+                                   uint8_t* pmem, uint64_t id) const
+{
+    const uint64_t chunk_size = chunkedStoreChunkSize;
+    const uint64_t num_chunks = divCeil(range.size(), chunk_size);
+    vector<uint64_t> digests(num_chunks);
+
+    atomic<uint64_t> next_chunk(0);
+    runOnThreads(num_chunks, [&]() {
+        for (uint64_t i = next_chunk++; i < num_chunks; i = next_chunk++) {
+            uint64_t offset = i * chunk_size;
+            digests[i] = chunkDigest(pmem + offset,
+                                     min(chunk_size, range.size() - offset));
+        }
+    });
+
+    if (lastStoreFiles.size() < backingStore.size()) {
+        lastStoreFiles.resize(backingStore.size());
+        lastStoreDigests.resize(backingStore.size());
+        lastStoreIds.resize(backingStore.size());
+    }
+    lastStoreFiles[store_id] = absolutePath(filepath);
+    lastStoreDigests[store_id] = move(digests);
+    lastStoreIds[store_id] = id;
+}
@@ -38,7 +38,11 @@
 #ifndef __MEM_PHYSICAL_HH__
 #define __MEM_PHYSICAL_HH__
 
+#include <functional>
+
 #include "base/addr_range_map.hh"
+#include "enums/HugePageMode.hh"
+#include "enums/MemoryCheckpointFormat.hh"
 #include "mem/packet.hh"
 
 /**
@@ -58,9 +62,10 @@ class BackingStoreEntry
      * pointers, because PhysicalMemory is responsible for that.
      */
     BackingStoreEntry(AddrRange range, uint8_t* pmem,
-                      bool conf_table_reported, bool in_addr_map, bool kvm_map)
+                      bool conf_table_reported, bool in_addr_map, bool kvm_map,
+                      int numa_node = -1)
         : range(range), pmem(pmem), confTableReported(conf_table_reported),
-          inAddrMap(in_addr_map), kvmMap(kvm_map)
+          inAddrMap(in_addr_map), kvmMap(kvm_map), numaNode(numa_node)
         {}
 
     /**
@@ -89,6 +94,11 @@ class BackingStoreEntry
       * acceleration.
       */
      bool kvmMap;
+
+     /**
+      * Host NUMA node the memory is bound to, or -1 if it is not bound
+      */
+     int numaNode;
 };
 
 /**
@@ -127,6 +137,28 @@ class PhysicalMemory : public Serializable
     // Let the user choose if we reserve swap space when calling mmap
     const bool mmapUsingNoReserve;
 
+    // Let the user choose if the backing store uses host huge pages
+    const HugePageMode hugePageMode;
+
+    // Host NUMA node to bind the backing store to, per event queue
+    const std::vector<int> eventqNumaNodes;
+
+    // Format used when writing the backing store to a checkpoint
+    const MemoryCheckpointFormat checkpointFormat;
+
+    // Number of host threads used for chunked checkpoints
+    const unsigned checkpointThreads;
+
+    // Only store the chunks that changed since the previous checkpoint
+    const bool checkpointIncremental;
+
+    // The chunked store file of the last checkpoint taken or restored
+    // for each backing store, the digests of its chunks and its
+    // identity, which form the base of the next incremental checkpoint
+    mutable std::vector<std::string> lastStoreFiles;
+    mutable std::vector<std::vector<uint64_t>> lastStoreDigests;
+    mutable std::vector<uint64_t> lastStoreIds;
+
     // The physical memory used to provide the memory in the simulated
     // system
     std::vector<BackingStoreEntry> backingStore;
@@ -151,6 +183,26 @@ class PhysicalMemory : public Serializable
                             bool conf_table_reported,
                             bool in_addr_map, bool kvm_map);
 
+    /**
+     * Map anonymous memory for a backing store, honouring the huge
+     * page mode. Explicit huge pages fall back to normal pages if
+     * the host cannot provide them.
+     *
+     * @param range The address range covered
+     * @param page_type Set to a description of the pages obtained
+     * @return The host pointer to the mapped memory
+     */
+    uint8_t* mapBackingStore(AddrRange range, std::string& page_type) const;
+
+    /**
+     * Determine the host NUMA node a backing store should be bound
+     * to, based on the event queue of the memories it covers.
+     *
+     * @param memories The memories this range maps to
+     * @return The host NUMA node, or -1 if the store is not bound
+     */
+    int numaNode(const std::vector<AbstractMemory*>& _memories) const;
+
   public:
 
     /**
@@ -158,7 +210,13 @@ class PhysicalMemory : public Serializable
      */
     PhysicalMemory(const std::string& _name,
                    const std::vector<AbstractMemory*>& _memories,
-                   bool mmap_using_noreserve);
+                   bool mmap_using_noreserve,
+                   HugePageMode huge_page_mode = HugePageMode::none,
+                   const std::vector<int>& eventq_numa_nodes = {},
+                   MemoryCheckpointFormat checkpoint_format =
+                   MemoryCheckpointFormat::gzip,
+                   unsigned checkpoint_threads = 0,
+                   bool checkpoint_incremental = false);
 
     /**
      * Unmap all the backing store we have used.
@@ -251,6 +309,36 @@ class PhysicalMemory : public Serializable
     void serializeStore(CheckpointOut &cp, unsigned int store_id,
                         AddrRange range, uint8_t* pmem) const;
 
+    /**
+     * Write a backing store uncompressed to a file. Pages that only
+     * contain zeros are left as holes in the file. The file is
+     * written under a temporary name and renamed into place, as the
+     * store it replaces may still be mapped by mapRawStore().
+     *
+     * @param filepath The path of the file to write
+     * @param range The address range of this backing store
+     * @param pmem The host pointer to this backing store
+     */
+    void writeRawStore(const std::string& filepath, AddrRange range,
+                       uint8_t* pmem) const;
+
+    /**
+     * Write a backing store to a file as independently compressed
+     * chunks, using a pool of host threads. Chunks that only contain
+     * zeros are not stored at all. For incremental checkpoints, the
+     * chunks that did not change since the previous checkpoint refer
+     * to the store of that checkpoint instead, unless this store
+     * replaces that file, in which case it is written in full.
+     *
+     * @param filepath The path of the file to write
+     * @param store_id Unique identifier of this backing store
+     * @param range The address range of this backing store
+     * @param pmem The host pointer to this backing store
+     */
+    void writeChunkedStore(const std::string& filepath,
+                           unsigned int store_id, AddrRange range,
+                           uint8_t* pmem) const;
+
     /**
      * Unserialize the memories in the system. As with the
      * serialization, this action is independent of how the address
@@ -263,6 +351,64 @@ class PhysicalMemory : public Serializable
      */
     void unserializeStore(CheckpointIn &cp);
 
+    /**
+     * Restore a backing store from an uncompressed file by mapping
+     * the file copy-on-write in place of the anonymous memory. The
+     * pages are faulted in lazily, and the file is never modified.
+     * The transparent huge page advice and NUMA binding of the
+     * anonymous memory are applied again to the new mapping.
+     *
+     * @param filepath The path of the file to map
+     * @param range The address range of this backing store
+     * @param pmem The host pointer to this backing store
+     * @param node The host NUMA node to bind to, or -1
+     */
+    void mapRawStore(const std::string& filepath, AddrRange range,
+                     uint8_t* pmem, int node);
+
+    /**
+     * Restore a backing store from a chunked file, decompressing the
+     * chunks in parallel using a pool of host threads. The chunks of
+     * an incremental checkpoint that are unchanged are read from the
+     * chain of base stores, each of which must still be the store
+     * that was the base when the checkpoint was taken.
+     *
+     * @param filepath The path of the file to read
+     * @param range The address range of this backing store
+     * @param pmem The host pointer to this backing store
+     * @param needed The chunks to read, or nullptr to read all
+     * @param expected_id The identity the store must have, 0 if unknown
+     * @return The identity of the store, 0 if it has none
+     */
+    uint64_t readChunkedStore(const std::string& filepath, AddrRange range,
+                              uint8_t* pmem,
+                              const std::vector<bool>* needed = nullptr,
+                              uint64_t expected_id = 0) const;
+
+    /**
+     * Remember a restored chunked store and the digests of its chunks
+     * as the base of the next incremental checkpoint.
+     *
+     * @param filepath The path of the restored file
+     * @param store_id Unique identifier of this backing store
+     * @param range The address range of this backing store
+     * @param pmem The host pointer to this backing store
+     * @param id The identity of the restored store
+     */
+    void recordChunkDigests(const std::string& filepath,
+                            unsigned int store_id, AddrRange range,
+                            uint8_t* pmem, uint64_t id) const;
+
+    /**
+     * Run a function on a number of host threads, including the
+     * calling thread, and wait for all of them to finish.
+     *
+     * @param work_items Upper bound on the number of threads needed
+     * @param func The function to run on each thread
+     */
+    void runOnThreads(uint64_t work_items,
+                      const std::function<void()>& func) const;
+
 };
 
 #endif //__MEM_PHYSICAL_HH__
@@ -45,3 +45,8 @@ class BaseMemProbe(SimObject):
     manager = VectorParam.SimObject(Parent.any,
                                     "Probe manager(s) to instrument")
     probe_name = Param.String("PktRequest", "Memory request probe to use")
+
+    # Probe points notifying packets rather than packet information,
+    # such as the Hit and Miss probe points of the caches
+    packet_probe_names = VectorParam.String([], "Packet probes to use in "
+                                            "addition to the request probe")
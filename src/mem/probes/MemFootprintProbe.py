@@ -45,3 +45,10 @@ class MemFootprintProbe(BaseMemProbe):
     system = Param.System(Parent.any,
                           "System pointer to get cache line and mem size")
     page_size = Param.Unsigned(4096, "Page size for page-level footprint")
+
+    # periodically write the footprints to a file, e.g. to plot the
+    # footprint over time
+    footprint_period = Param.Latency('0', "Period of the footprint output "
+                                     "(0 to disable)")
+    footprint_file = Param.String("", "Footprint output file name "
+                                  "(defaults to <name>.footprint.csv)")
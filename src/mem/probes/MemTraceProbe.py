@@ -44,6 +44,11 @@ class MemTraceProbe(BaseMemProbe):
     # Boolean to compress the trace or not.
     trace_compress = Param.Bool(True, "Enable trace compression")
 
+    # Write the trace in the compact binary format of
+    # src/mem/packet_trace.hh rather than as protobuf messages. Binary
+    # traces are compressed one block at a time.
+    binary_trace = Param.Bool(False, "Use the binary packet trace format")
+
     # For requests with a valid PC, include the PC in the trace
     with_pc = Param.Bool(False, "Include PC info in the trace")
 
@@ -0,0 +1,55 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from m5.params import *
+from m5.proxy import *
+from m5.objects.BaseMemProbe import BaseMemProbe
+
+# Estimates the miss ratio of LRU caches of a range of sizes and
+# associativities in a single simulation, by simulating a sample of the
+# sets of each cache. The probe can be attached to the requests probe
+# point of a communication monitor or of a memory, or to a cache, whose
+# Hit and Miss probe points together see all the accesses to the cache,
+# e.g. to evaluate the sizes of a last level cache:
+#
+#   system.l2.mrc = MissRatioCurveProbe(manager=system.l2)
+class MissRatioCurveProbe(BaseMemProbe):
+    type = 'MissRatioCurveProbe'
+    cxx_header = "mem/probes/miss_ratio_curve.hh"
+
+    packet_probe_names = ['Hit', 'Miss']
+
+    line_size = Param.Unsigned(Parent.cache_line_size,
+                               "Cache line size in bytes")
+
+    sizes = VectorParam.MemorySize(['256kB', '512kB', '1MB', '2MB', '4MB',
+                                    '8MB', '16MB'], "Cache sizes")
+    assocs = VectorParam.Unsigned([1, 2, 4, 8, 16], "Cache associativities")
+
+    # the caches with the same number of sets share their sampled sets,
+    # so the number of sets sampled bounds the cost of the probe
+    sampled_sets = Param.Unsigned(64, "Number of sets sampled per number "
+                                  "of sets (0 to simulate all the sets)")
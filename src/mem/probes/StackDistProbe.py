@@ -37,6 +37,11 @@ from m5.params import *
 from m5.proxy import *
 from m5.objects.BaseMemProbe import BaseMemProbe
 
+# The stack distance calculators: the exact tree-based calculator, or
+# an approximate calculator with bounded memory that optionally samples
+# the addresses
+class StackDistCalcType(Enum): vals = ['tree', 'sampled']
+
 class StackDistProbe(BaseMemProbe):
     type = 'StackDistProbe'
     cxx_header = "mem/probes/stack_dist.hh"
@@ -49,6 +54,15 @@ class StackDistProbe(BaseMemProbe):
                                "Cache line size in bytes (must be larger or "
                                "equal to the system's line size)")
 
+    calc_type = Param.StackDistCalcType('tree', "Stack distance calculator")
+
+    # fraction of the cache lines tracked by the sampled calculator, and
+    # maximum number of tracked lines, beyond which the sampling rate is
+    # lowered to keep the memory usage bounded
+    sample_rate = Param.Float(1.0, "Fraction of the cache lines sampled")
+    max_sampled_lines = Param.Unsigned(0, "Maximum number of sampled "
+                                       "cache lines (0 for no maximum)")
+
     # enable verification stack
     verify = Param.Bool(False, "Verify behaviuor with reference implementation")
 
@@ -59,3 +73,7 @@ class StackDistProbe(BaseMemProbe):
     # logarithmic histogram bins and enable/disable
     log_hist_bins = Param.Unsigned('32', "Bins in logarithmic histograms")
     disable_log_hists = Param.Bool(False, "Disable logarithmic histograms")
+
+    # miss ratio of fully associative LRU caches of one line and of every
+    # power of two lines up to the number of logarithmic histogram bins
+    miss_ratio_curve = Param.Bool(False, "Estimate the miss ratio curve")
@@ -55,5 +55,9 @@ BaseMemProbe::regProbeListeners()
     for (int i = 0; i < p->manager.size(); i++) {
         ProbeManager *const mgr(p->manager[i]->getProbeManager());
         listeners[i].reset(new PacketListener(*this, mgr, p->probe_name));
+        for (const auto &name : p->packet_probe_names) {
+            packetListeners.emplace_back(
+                new PacketPtrListener(*this, mgr, name));
+        }
     }
 }
@@ -57,6 +57,10 @@ struct BaseMemProbeParams;
  * from multiple components using the same probe. For example, a stack
  * distance probe could be hooked up to multiple memories in a
  * multi-channel configuration.
+ *
+ * Probe points notifying packets rather than packet information, such
+ * as the Hit and Miss probe points of the caches, can be instrumented
+ * in addition.
  */
 class BaseMemProbe : public SimObject
 {
@@ -88,7 +92,25 @@ class BaseMemProbe : public SimObject
         BaseMemProbe &parent;
     };
 
+    class PacketPtrListener : public ProbeListenerArgBase<PacketPtr>
+    {
+      public:
+        PacketPtrListener(BaseMemProbe &_parent,
+                          ProbeManager *pm, const std::string &name)
+            : ProbeListenerArgBase(pm, name),
+              parent(_parent) {}
+
+        void notify(const PacketPtr &pkt) override {
+            parent.handleRequest(ProbePoints::PacketInfo(pkt));
+        }
+
+      protected:
+        BaseMemProbe &parent;
+    };
+
     std::vector<std::unique_ptr<PacketListener>> listeners;
+
+    std::vector<std::unique_ptr<PacketPtrListener>> packetListeners;
 };
 
 #endif //  __MEM_PROBES_BASE_HH__
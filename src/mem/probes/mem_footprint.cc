@@ -38,25 +38,54 @@
 
 #include "mem/probes/mem_footprint.hh"
 
+#include "base/bitfield.hh"
 #include "base/intmath.hh"
 #include "params/MemFootprintProbe.hh"
 
+uint64_t
+MemFootprintProbe::AddrBitmap::count() const
+{
+    uint64_t units = 0;
+    for (const auto &region : regions) {
+        for (uint64_t word : region.second)
+            units += popCount(word);
+    }
+    return units;
+}
+
+void
+MemFootprintProbe::AddrBitmap::clear()
+{
+    regions.clear();
+    lastRegion = MaxAddr;
+    lastWords = nullptr;
+}
+
 MemFootprintProbe::MemFootprintProbe(MemFootprintProbeParams *p)
     : BaseMemProbe(p),
       cacheLineSizeLg2(floorLog2(p->system->cacheLineSize())),
       pageSizeLg2(floorLog2(p->page_size)),
-      totalCacheLinesInMem(p->system->memSize() / p->system->cacheLineSize()),
-      totalPagesInMem(p->system->memSize() / p->page_size),
-      cacheLines(),
-      cacheLinesAll(),
-      pages(),
-      pagesAll(),
-      system(p->system)
+      cacheLines(cacheLineSizeLg2),
+      cacheLinesAll(cacheLineSizeLg2),
+      pages(pageSizeLg2),
+      pagesAll(pageSizeLg2),
+      system(p->system),
+      footprintPeriod(p->footprint_period),
+      footprintFile(nullptr),
+      footprintEvent([this]{ dumpFootprint(); }, name())
 {
     fatal_if(!isPowerOf2(system->cacheLineSize()),
              "MemFootprintProbe expects cache line size is power of 2.");
     fatal_if(!isPowerOf2(p->page_size),
              "MemFootprintProbe expects page size parameter is power of 2");
+
+    if (footprintPeriod) {
+        footprintFile = simout.create(p->footprint_file != "" ?
+                                      p->footprint_file :
+                                      name() + ".footprint.csv");
+        ccprintf(*footprintFile->stream(), "tick,cacheline,cacheline_total,"
+                 "page,page_total\n");
+    }
 }
 
 void
@@ -66,17 +95,21 @@ MemFootprintProbe::regStats()
 
     using namespace Stats;
     // clang-format off
-    fpCacheLine.name(name() + ".cacheline")
+    fpCacheLine.method(this, &MemFootprintProbe::cacheLineFootprint)
+        .name(name() + ".cacheline")
         .desc("Memory footprint at cache line granularity")
         .flags(nozero | nonan);
-    fpCacheLineTotal.name(name() + ".cacheline_total")
+    fpCacheLineTotal.method(this, &MemFootprintProbe::cacheLineFootprintTotal)
+        .name(name() + ".cacheline_total")
         .desc("Total memory footprint at cache line granularity since "
               "simulation begin")
         .flags(nozero | nonan);
-    fpPage.name(name() + ".page")
+    fpPage.method(this, &MemFootprintProbe::pageFootprint)
+        .name(name() + ".page")
         .desc("Memory footprint at page granularity")
         .flags(nozero | nonan);
-    fpPageTotal.name(name() + ".page_total")
+    fpPageTotal.method(this, &MemFootprintProbe::pageFootprintTotal)
+        .name(name() + ".page_total")
         .desc("Total memory footprint at page granularity since simulation "
               "begin")
         .flags(nozero | nonan);
@@ -88,10 +121,34 @@ MemFootprintProbe::regStats()
 }
 
 void
-MemFootprintProbe::insertAddr(Addr addr, AddrSet *set, uint64_t limit)
+MemFootprintProbe::startup()
+{
+    if (footprintPeriod)
+        schedule(footprintEvent, curTick() + footprintPeriod);
+}
+
+uint64_t
+MemFootprintProbe::cacheLineFootprint() const
 {
-    set->insert(addr);
-    assert(set->size() <= limit);
+    return cacheLines.count() << cacheLineSizeLg2;
+}
+
+uint64_t
+MemFootprintProbe::cacheLineFootprintTotal() const
+{
+    return cacheLinesAll.count() << cacheLineSizeLg2;
+}
+
+uint64_t
+MemFootprintProbe::pageFootprint() const
+{
+    return pages.count() << pageSizeLg2;
+}
+
+uint64_t
+MemFootprintProbe::pageFootprintTotal() const
+{
+    return pagesAll.count() << pageSizeLg2;
 }
 
 void
@@ -100,20 +157,21 @@ MemFootprintProbe::handleRequest(const ProbePoints::PacketInfo &pi)
     if (!pi.cmd.isRequest() || !system->isMemAddr(pi.addr))
         return;
 
-    const Addr cl_addr = (pi.addr >> cacheLineSizeLg2) << cacheLineSizeLg2;
-    const Addr page_addr = (pi.addr >> pageSizeLg2) << pageSizeLg2;
-    insertAddr(cl_addr, &cacheLines, totalCacheLinesInMem);
-    insertAddr(cl_addr, &cacheLinesAll, totalCacheLinesInMem);
-    insertAddr(page_addr, &pages, totalPagesInMem);
-    insertAddr(page_addr, &pagesAll, totalPagesInMem);
+    cacheLines.insert(pi.addr);
+    cacheLinesAll.insert(pi.addr);
+    pages.insert(pi.addr);
+    pagesAll.insert(pi.addr);
+}
 
-    assert(cacheLines.size() <= cacheLinesAll.size());
-    assert(pages.size() <= pagesAll.size());
+void
+MemFootprintProbe::dumpFootprint()
+{
+    std::ostream &os = *footprintFile->stream();
+    ccprintf(os, "%d,%d,%d,%d,%d\n", curTick(), cacheLineFootprint(),
+             cacheLineFootprintTotal(), pageFootprint(), pageFootprintTotal());
+    os.flush();
 
-    fpCacheLine = cacheLines.size() << cacheLineSizeLg2;
-    fpCacheLineTotal = cacheLinesAll.size() << cacheLineSizeLg2;
-    fpPage = pages.size() << pageSizeLg2;
-    fpPageTotal = pagesAll.size() << pageSizeLg2;
+    schedule(footprintEvent, curTick() + footprintPeriod);
 }
 
 void
@@ -39,11 +39,15 @@
 #ifndef __MEM_PROBES_MEM_FOOTPRINT_HH__
 #define __MEM_PROBES_MEM_FOOTPRINT_HH__
 
-#include <unordered_set>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 #include "base/callback.hh"
+#include "base/output.hh"
 #include "mem/packet.hh"
 #include "mem/probes/base.hh"
+#include "sim/eventq.hh"
 #include "sim/stats.hh"
 #include "sim/system.hh"
 
@@ -54,42 +58,110 @@ struct MemFootprintProbeParams;
 class MemFootprintProbe : public BaseMemProbe
 {
   public:
-    typedef std::unordered_set<Addr> AddrSet;
+    /**
+     * A set of addresses at a fixed granularity, as a sparse two-level
+     * bitmap: the address space is split in regions, and the bitmap
+     * of a region is only allocated once an address in it is
+     * inserted. Inserting an address sets a single bit, and the size
+     * of the set is only computed, by counting the set bits, when it
+     * is reported.
+     */
+    class AddrBitmap
+    {
+      public:
+        AddrBitmap(uint8_t granularity_lg2)
+            : granularityLg2(granularity_lg2),
+              lastRegion(MaxAddr), lastWords(nullptr)
+        { }
+
+        /** Insert the unit containing an address. */
+        void
+        insert(Addr addr)
+        {
+            const Addr unit = addr >> granularityLg2;
+            const Addr region = unit >> RegionUnitsLg2;
+            // Consecutive accesses are most often to the same region
+            if (region != lastRegion) {
+                std::vector<uint64_t> &words = regions[region];
+                if (words.empty())
+                    words.resize(RegionWords, 0);
+                lastRegion = region;
+                lastWords = words.data();
+            }
+            const Addr bit = unit & ((1ULL << RegionUnitsLg2) - 1);
+            lastWords[bit / 64] |= 1ULL << (bit % 64);
+        }
+
+        /** The number of units in the set. */
+        uint64_t count() const;
+
+        /** Remove all the addresses, releasing the bitmaps. */
+        void clear();
+
+      private:
+        /** Number of units of a region (log2). */
+        static const unsigned RegionUnitsLg2 = 15;
+
+        /** Number of words of the bitmap of a region. */
+        static const unsigned RegionWords = (1 << RegionUnitsLg2) / 64;
+
+        const uint8_t granularityLg2;
+
+        /** The bitmap of every region with an address in the set. */
+        std::unordered_map<Addr, std::vector<uint64_t>> regions;
+
+        /** The region of the last address inserted, and its bitmap. */
+        Addr lastRegion;
+        uint64_t *lastWords;
+    };
 
     MemFootprintProbe(MemFootprintProbeParams *p);
     void regStats() override;
+    void startup() override;
     // Fix footprint tracking state on stat reset
     void statReset();
 
+    /// Footprints in bytes, as reported in the stats
+    uint64_t cacheLineFootprint() const;
+    uint64_t cacheLineFootprintTotal() const;
+    uint64_t pageFootprint() const;
+    uint64_t pageFootprintTotal() const;
+
   protected:
     /// Cache Line size for footprint measurement (log2)
     const uint8_t cacheLineSizeLg2;
     /// Page size for footprint measurement (log2)
     const uint8_t pageSizeLg2;
-    const uint64_t totalCacheLinesInMem;
-    const uint64_t totalPagesInMem;
 
-    void insertAddr(Addr addr, AddrSet *set, uint64_t limit);
     void handleRequest(const ProbePoints::PacketInfo &pkt_info) override;
 
+    /// Write the footprints to the footprint file
+    void dumpFootprint();
+
     /// Footprint at cache line size granularity
-    Stats::Scalar fpCacheLine;
+    Stats::Value fpCacheLine;
     /// Footprint at cache line size granularity, since simulation begin
-    Stats::Scalar fpCacheLineTotal;
+    Stats::Value fpCacheLineTotal;
     /// Footprint at page granularity
-    Stats::Scalar fpPage;
+    Stats::Value fpPage;
     /// Footprint at page granularity, since simulation begin
-    Stats::Scalar fpPageTotal;
-
-    // Addr set to track unique cache lines accessed
-    AddrSet cacheLines;
-    // Addr set to track unique cache lines accessed since simulation begin
-    AddrSet cacheLinesAll;
-    // Addr set to track unique pages accessed
-    AddrSet pages;
-    // Addr set to track unique pages accessed since simulation begin
-    AddrSet pagesAll;
+    Stats::Value fpPageTotal;
+
+    // Bitmap to track unique cache lines accessed
+    AddrBitmap cacheLines;
+    // Bitmap to track unique cache lines accessed since simulation begin
+    AddrBitmap cacheLinesAll;
+    // Bitmap to track unique pages accessed
+    AddrBitmap pages;
+    // Bitmap to track unique pages accessed since simulation begin
+    AddrBitmap pagesAll;
     System *system;
+
+    /// Period of the footprint output, 0 if disabled
+    const Tick footprintPeriod;
+    /// File the footprints are periodically written to
+    OutputStream *footprintFile;
+    EventFunctionWrapper footprintEvent;
 };
 
 #endif  //__MEM_PROBES_MEM_FOOTPRINT_HH__
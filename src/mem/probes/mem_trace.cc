@@ -43,14 +43,29 @@
 #include "proto/packet.pb.h"
 #include "sim/system.hh"
 
+MemTraceProbe::MemTraceStats::MemTraceStats(MemTraceProbe &probe)
+    : Stats::Group(&probe),
+      ADD_STAT(tracedPackets, "Number of packets written to the trace"),
+      ADD_STAT(traceStalls, "Number of packets whose writing waited for "
+               "the trace output")
+{
+}
+
 MemTraceProbe::MemTraceProbe(MemTraceProbeParams *p)
     : BaseMemProbe(p),
       traceStream(nullptr),
+      binaryCompress(p->trace_compress),
       system(p->system),
+      stats(*this),
       withPC(p->with_pc)
 {
     std::string filename;
-    if (p->trace_file != "") {
+    if (p->binary_trace) {
+        // Binary traces are compressed internally, so they do not get
+        // a .gz suffix
+        binaryFilename = simout.resolve(p->trace_file != "" ?
+                                        p->trace_file : name() + ".bpt");
+    } else if (p->trace_file != "") {
         // If the trace file is not specified as an absolute path,
         // append the current simulation output directory
         filename = simout.resolve(p->trace_file);
@@ -69,7 +84,8 @@ MemTraceProbe::MemTraceProbe(MemTraceProbeParams *p)
                                   (p->trace_compress ? ".gz" : ""));
     }
 
-    traceStream = new ProtoOutputStream(filename);
+    if (!p->binary_trace)
+        traceStream = new ProtoOutputStream(filename);
 
     // Register a callback to compensate for the destructor not
     // being called. The callback forces the stream to flush and
@@ -81,6 +97,17 @@ MemTraceProbe::MemTraceProbe(MemTraceProbeParams *p)
 void
 MemTraceProbe::startup()
 {
+    if (!binaryFilename.empty()) {
+        std::map<uint16_t, std::string> masters;
+        for (int i = 0; i < system->maxMasters(); i++)
+            masters[i] = system->getMasterName(i);
+
+        binaryTrace.reset(new PacketTrace::Writer(
+            binaryFilename, SimClock::Frequency, name(), masters,
+            binaryCompress));
+        return;
+    }
+
     // Create a protobuf message for the header and write it to
     // the stream
     ProtoMessage::PacketHeader header_msg;
@@ -101,11 +128,39 @@ MemTraceProbe::closeStreams()
 {
     if (traceStream != NULL)
         delete traceStream;
+    traceStream = NULL;
+
+    if (binaryTrace)
+        binaryTrace->close();
+}
+
+DrainState
+MemTraceProbe::drain()
+{
+    if (traceStream != NULL)
+        traceStream->flush();
+    if (binaryTrace)
+        binaryTrace->flush();
+    return DrainState::Drained;
 }
 
 void
 MemTraceProbe::handleRequest(const ProbePoints::PacketInfo &pkt_info)
 {
+    if (binaryTrace) {
+        PacketTrace::Packet pkt;
+        pkt.tick = curTick();
+        pkt.addr = pkt_info.addr;
+        pkt.pc = withPC ? pkt_info.pc : 0;
+        pkt.flags = pkt_info.flags;
+        pkt.size = pkt_info.size;
+        pkt.cmd = pkt_info.cmd.toInt();
+        pkt.master = pkt_info.master;
+        binaryTrace->write(pkt);
+        ++stats.tracedPackets;
+        return;
+    }
+
     ProtoMessage::Packet pkt_msg;
 
     pkt_msg.set_tick(curTick());
@@ -117,7 +172,10 @@ MemTraceProbe::handleRequest(const ProbePoints::PacketInfo &pkt_info)
         pkt_msg.set_pc(pkt_info.pc);
     pkt_msg.set_pkt_id(pkt_info.master);
 
+    const uint64_t stalls = traceStream->stalls();
     traceStream->write(pkt_msg);
+    ++stats.tracedPackets;
+    stats.traceStalls += traceStream->stalls() - stalls;
 }
 
 
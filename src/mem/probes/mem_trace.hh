@@ -38,7 +38,12 @@
 #ifndef __MEM_PROBES_MEM_TRACE_HH__
 #define __MEM_PROBES_MEM_TRACE_HH__
 
+#include <memory>
+#include <string>
+
+#include "base/statistics.hh"
 #include "mem/packet.hh"
+#include "mem/packet_trace.hh"
 #include "mem/probes/base.hh"
 #include "proto/protoio.hh"
 
@@ -61,13 +66,39 @@ class MemTraceProbe : public BaseMemProbe
 
     void startup() override;
 
+    /** Flush the trace so that it is complete when checkpointing. */
+    DrainState drain() override;
+
   protected:
 
     /** Trace output stream */
     ProtoOutputStream *traceStream;
 
+    /** Binary trace, created at startup as it needs the master names */
+    std::unique_ptr<PacketTrace::Writer> binaryTrace;
+
+    /** Name of the binary trace file */
+    std::string binaryFilename;
+
+    /** Whether to compress the binary trace */
+    const bool binaryCompress;
+
     System *system;
 
+    struct MemTraceStats : public Stats::Group
+    {
+        MemTraceStats(MemTraceProbe &probe);
+
+        /** Number of packets written to the trace */
+        Stats::Scalar tracedPackets;
+
+        /**
+         * Number of packets whose writing waited for the compression
+         * and the I/O of the previous ones
+         */
+        Stats::Scalar traceStalls;
+    } stats;
+
   private:
 
     /** Include the Program Counter in the memory trace */
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/probes/miss_ratio_curve.hh"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+#include "base/cprintf.hh"
+#include "base/intmath.hh"
+#include "params/MissRatioCurveProbe.hh"
+
+/** Format a cache size as in the configuration, e.g. 512kB. */
+static std::string
+sizeName(uint64_t size)
+{
+    static const char *units[] = { "B", "kB", "MB", "GB", "TB" };
+    int unit = 0;
+    while (unit < 4 && size % 1024 == 0 && size >= 1024) {
+        size /= 1024;
+        ++unit;
+    }
+    return csprintf("%d%s", size, units[unit]);
+}
+
+MissRatioCurveProbe::MissRatioCurveProbe(MissRatioCurveProbeParams *p)
+    : BaseMemProbe(p),
+      lineSizeLg2(floorLog2(p->line_size)),
+      sampledSets(p->sampled_sets)
+{
+    fatal_if(!isPowerOf2(p->line_size),
+             "The line size of %s must be a power of 2.\n", name());
+
+    // Group the caches by number of sets, in order of increasing size
+    // then associativity for the stats
+    std::map<uint64_t, unsigned> group_of_sets;
+    for (uint64_t size : p->sizes) {
+        for (unsigned assoc : p->assocs) {
+            fatal_if(assoc == 0 || size % ((uint64_t)p->line_size * assoc),
+                     "%s: a cache of %s cannot be %d-way set associative "
+                     "with %dB lines.\n", name(), sizeName(size), assoc,
+                     p->line_size);
+            const uint64_t num_sets = size / p->line_size / assoc;
+
+            auto it = group_of_sets.find(num_sets);
+            if (it == group_of_sets.end()) {
+                it = group_of_sets.emplace(num_sets, groups.size()).first;
+                groups.emplace_back(num_sets);
+            }
+            SetGroup &group = groups[it->second];
+            group.maxAssoc = std::max(group.maxAssoc, assoc);
+            group.caches.emplace_back(assoc, cacheNames.size());
+            cacheNames.push_back(csprintf("%s_%dway", sizeName(size), assoc));
+        }
+    }
+}
+
+void
+MissRatioCurveProbe::regStats()
+{
+    BaseMemProbe::regStats();
+
+    using namespace Stats;
+
+    requests
+        .init(cacheNames.size())
+        .name(name() + ".requests")
+        .desc("Number of requests to the sampled sets of every cache");
+
+    misses
+        .init(cacheNames.size())
+        .name(name() + ".misses")
+        .desc("Number of misses in the sampled sets of every cache");
+
+    missRatio
+        .name(name() + ".missRatio")
+        .desc("Miss ratio of every cache");
+    missRatio = misses / requests;
+
+    for (int i = 0; i < cacheNames.size(); ++i) {
+        requests.subname(i, cacheNames[i]);
+        misses.subname(i, cacheNames[i]);
+        missRatio.subname(i, cacheNames[i]);
+    }
+}
+
+bool
+MissRatioCurveProbe::isSampled(uint64_t set, uint64_t num_sets) const
+{
+    if (sampledSets == 0 || num_sets <= sampledSets)
+        return true;
+
+    // Hash the set index so that the sampled sets are spread over the
+    // cache rather than at a fixed stride, which could resonate with
+    // the strides of the accesses
+    set ^= set >> 33;
+    set *= 0xff51afd7ed558ccdULL;
+    set ^= set >> 33;
+    return set % num_sets < sampledSets;
+}
+
+void
+MissRatioCurveProbe::handleRequest(const ProbePoints::PacketInfo &pkt_info)
+{
+    // only capturing read and write requests (which allocate in the
+    // cache)
+    if (!pkt_info.cmd.isRead() && !pkt_info.cmd.isWrite())
+        return;
+
+    const Addr line_addr = pkt_info.addr >> lineSizeLg2;
+    for (auto &group : groups) {
+        const uint64_t set = line_addr % group.numSets;
+        if (!isSampled(set, group.numSets))
+            continue;
+
+        // Find the depth of the line in the LRU stack of its set and
+        // move it to the top, evicting the bottom line on a miss
+        std::vector<Addr> &stack = group.stacks[set];
+        auto it = std::find(stack.begin(), stack.end(), line_addr);
+        unsigned depth = it - stack.begin();
+        if (it == stack.end()) {
+            depth = std::numeric_limits<unsigned>::max();
+            if (stack.size() < group.maxAssoc)
+                stack.push_back(line_addr);
+            else
+                stack.back() = line_addr;
+            it = stack.end() - 1;
+        }
+        std::rotate(stack.begin(), it, it + 1);
+
+        for (const auto &cache : group.caches) {
+            ++requests[cache.second];
+            if (depth >= cache.first)
+                ++misses[cache.second];
+        }
+    }
+}
+
+MissRatioCurveProbe *
+MissRatioCurveProbeParams::create()
+{
+    return new MissRatioCurveProbe(this);
+}
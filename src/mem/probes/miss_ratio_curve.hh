@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_PROBES_MISS_RATIO_CURVE_HH__
+#define __MEM_PROBES_MISS_RATIO_CURVE_HH__
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "mem/probes/base.hh"
+#include "sim/stats.hh"
+
+struct MissRatioCurveProbeParams;
+
+/**
+ * Probe estimating the miss ratio of LRU caches of a range of sizes
+ * and associativities in a single simulation.
+ *
+ * The caches with the same number of sets are simulated together:
+ * an LRU stack as deep as the largest of their associativities is
+ * kept for each set, and a request hits in the caches whose
+ * associativity is larger than its depth in the stack of its
+ * set. Only a sample of the sets of each number of sets is
+ * simulated, chosen by hashing the set index, which bounds the
+ * memory and time used by the probe irrespective of the cache sizes.
+ */
+class MissRatioCurveProbe : public BaseMemProbe
+{
+  public:
+    MissRatioCurveProbe(MissRatioCurveProbeParams *params);
+
+    void regStats() override;
+
+  protected:
+    void handleRequest(const ProbePoints::PacketInfo &pkt_info) override;
+
+  private:
+    /** The caches with a given number of sets. */
+    struct SetGroup
+    {
+        SetGroup(uint64_t num_sets)
+            : numSets(num_sets), maxAssoc(0)
+        { }
+
+        const uint64_t numSets;
+
+        /** Depth of the LRU stacks, the largest associativity. */
+        unsigned maxAssoc;
+
+        /** Associativity and index in the stats of every cache. */
+        std::vector<std::pair<unsigned, unsigned>> caches;
+
+        /**
+         * LRU stacks of the line addresses of the sampled sets, most
+         * recently used first.
+         */
+        std::unordered_map<uint64_t, std::vector<Addr>> stacks;
+    };
+
+    /** Determine whether a set of a cache is sampled. */
+    bool isSampled(uint64_t set, uint64_t num_sets) const;
+
+    /** Cache line size in bytes (log2) */
+    const unsigned lineSizeLg2;
+
+    /** Number of sets sampled per number of sets, 0 for all. */
+    const uint64_t sampledSets;
+
+    std::vector<SetGroup> groups;
+
+    /** Name of every cache in the stats. */
+    std::vector<std::string> cacheNames;
+
+    /** Requests to the sampled sets of every cache. */
+    Stats::Vector requests;
+
+    /** Requests missing in the sampled sets of every cache. */
+    Stats::Vector misses;
+
+    /** Miss ratio of every cache. */
+    Stats::Formula missRatio;
+};
+
+#endif //__MEM_PROBES_MISS_RATIO_CURVE_HH__
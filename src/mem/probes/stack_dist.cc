@@ -37,6 +37,7 @@
 
 #include "mem/probes/stack_dist.hh"
 
+#include "base/cprintf.hh"
 #include "params/StackDistProbe.hh"
 #include "sim/system.hh"
 
@@ -45,11 +46,22 @@ StackDistProbe::StackDistProbe(StackDistProbeParams *p)
       lineSize(p->line_size),
       disableLinearHists(p->disable_linear_hists),
       disableLogHists(p->disable_log_hists),
-      calc(p->verify)
+      missRatioCurve(p->miss_ratio_curve),
+      calcType(p->calc_type),
+      verify(p->verify),
+      calc(p->verify && calcType == Enums::tree),
+      sampledCalc(p->sample_rate, p->max_sampled_lines)
 {
     fatal_if(p->system->cacheLineSize() > p->line_size,
              "The stack distance probe must use a cache line size that is "
              "larger or equal to the system's cahce line size.");
+    fatal_if(calcType == Enums::tree &&
+             (p->sample_rate != 1.0 || p->max_sampled_lines != 0),
+             "Only the sampled stack distance calculator samples lines.\n");
+    fatal_if(verify && calcType == Enums::sampled &&
+             (p->sample_rate != 1.0 || p->max_sampled_lines != 0),
+             "The sampled stack distance calculator can only be verified "
+             "when not sampling.\n");
 }
 
 void
@@ -91,6 +103,36 @@ StackDistProbe::regStats()
         .name(name() + ".infinity")
         .desc("Number of requests with infinite stack distance")
         .flags(nozero);
+
+    if (missRatioCurve) {
+        mrcMisses
+            .init(p->log_hist_bins)
+            .name(name() + ".mrcMisses")
+            .desc("Number of requests missing in fully associative LRU "
+                  "caches of 2^i lines");
+
+        mrcRequests
+            .name(name() + ".mrcRequests")
+            .desc("Number of requests contributing to the miss ratio curve");
+
+        mrc
+            .name(name() + ".mrc")
+            .desc("Miss ratio of fully associative LRU caches of 2^i lines");
+        mrc = mrcMisses / mrcRequests;
+
+        for (int i = 0; i < p->log_hist_bins; ++i) {
+            const std::string size = csprintf("%dB", (uint64_t)lineSize << i);
+            mrcMisses.subname(i, size);
+            mrc.subname(i, size);
+        }
+    }
+
+    if (calcType == Enums::sampled) {
+        sampleRate
+            .method(&sampledCalc, &SampledStackDistCalc::sampleRate)
+            .name(name() + ".sampleRate")
+            .desc("Fraction of the cache lines sampled");
+    }
 }
 
 void
@@ -104,8 +146,32 @@ StackDistProbe::handleRequest(const ProbePoints::PacketInfo &pkt_info)
     // Align the address to a cache line size
     const Addr aligned_addr(roundDown(pkt_info.addr, lineSize));
 
-    // Calculate the stack distance
-    const uint64_t sd(calc.calcStackDistAndUpdate(aligned_addr).first);
+    // Calculate the stack distance, which the sampled calculator
+    // only does for some of the lines
+    uint64_t sd;
+    if (calcType == Enums::sampled) {
+        sd = sampledCalc.calcStackDistAndUpdate(aligned_addr);
+        if (sd == SampledStackDistCalc::Unsampled)
+            return;
+        if (verify) {
+            const uint64_t ref_sd(
+                calc.calcStackDistAndUpdate(aligned_addr).first);
+            panic_if(sd != ref_sd, "Stack distance of %#x is %d instead "
+                     "of %d.\n", aligned_addr, sd, ref_sd);
+        }
+    } else {
+        sd = calc.calcStackDistAndUpdate(aligned_addr).first;
+    }
+
+    // A request misses in the caches holding at most sd lines
+    if (missRatioCurve) {
+        ++mrcRequests;
+        const int max_size = sd == StackDistCalc::Infinity ?
+            mrcMisses.size() : (sd == 0 ? 0 : floorLog2(sd) + 1);
+        for (int i = 0; i < std::min<int>(max_size, mrcMisses.size()); ++i)
+            ++mrcMisses[i];
+    }
+
     if (sd == StackDistCalc::Infinity) {
         infiniteSD++;
         return;
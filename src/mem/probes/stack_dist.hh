@@ -38,8 +38,10 @@
 #ifndef __MEM_PROBES_STACK_DIST_HH__
 #define __MEM_PROBES_STACK_DIST_HH__
 
+#include "enums/StackDistCalcType.hh"
 #include "mem/packet.hh"
 #include "mem/probes/base.hh"
+#include "mem/sampled_stack_dist_calc.hh"
 #include "mem/stack_dist_calc.hh"
 #include "sim/stats.hh"
 
@@ -65,6 +67,15 @@ class StackDistProbe : public BaseMemProbe
     // Disable the logarithmic histograms
     const bool disableLogHists;
 
+    // Estimate the miss ratio curve
+    const bool missRatioCurve;
+
+    // Stack distance calculator to use
+    const Enums::StackDistCalcType calcType;
+
+    // Verify the stack distances with the reference implementation
+    const bool verify;
+
   protected:
     // Reads linear histogram
     Stats::Histogram readLinearHist;
@@ -81,8 +92,22 @@ class StackDistProbe : public BaseMemProbe
     // Writes logarithmic histogram
     Stats::Scalar infiniteSD;
 
+    // Requests missing in fully associative LRU caches of 2^i lines
+    Stats::Vector mrcMisses;
+
+    // Requests contributing to the miss ratio curve
+    Stats::Scalar mrcRequests;
+
+    // Miss ratio of fully associative LRU caches of 2^i lines
+    Stats::Formula mrc;
+
+    // Sampling rate of the sampled calculator
+    Stats::Value sampleRate;
+
   protected:
     StackDistCalc calc;
+
+    SampledStackDistCalc sampledCalc;
 };
 
 
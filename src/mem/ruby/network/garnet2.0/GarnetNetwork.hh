@@ -234,11 +234,12 @@ class GarnetNetwork : public Network
     int m_routing_algorithm;
     bool m_enable_fault_model;
 
-    // Statistical variables
-    Stats::Vector m_packets_received;
-    Stats::Vector m_packets_injected;
-    Stats::Vector m_packet_network_latency;
-    Stats::Vector m_packet_queueing_latency;
+    // Statistical variables. The packet and flit counts are updated by
+    // every network interface, so they are sharded.
+    Stats::ShardedVector m_packets_received;
+    Stats::ShardedVector m_packets_injected;
+    Stats::ShardedVector m_packet_network_latency;
+    Stats::ShardedVector m_packet_queueing_latency;
 
     Stats::Formula m_avg_packet_vnet_latency;
     Stats::Formula m_avg_packet_vqueue_latency;
@@ -246,10 +247,10 @@ class GarnetNetwork : public Network
     Stats::Formula m_avg_packet_queueing_latency;
     Stats::Formula m_avg_packet_latency;
 
-    Stats::Vector m_flits_received;
-    Stats::Vector m_flits_injected;
-    Stats::Vector m_flit_network_latency;
-    Stats::Vector m_flit_queueing_latency;
+    Stats::ShardedVector m_flits_received;
+    Stats::ShardedVector m_flits_injected;
+    Stats::ShardedVector m_flit_network_latency;
+    Stats::ShardedVector m_flit_queueing_latency;
 
     Stats::Formula m_avg_flit_vnet_latency;
     Stats::Formula m_avg_flit_vqueue_latency;
@@ -263,7 +264,7 @@ class GarnetNetwork : public Network
     Stats::Scalar m_average_link_utilization;
     Stats::Vector m_average_vc_load;
 
-    Stats::Scalar  m_total_hops;
+    Stats::ShardedScalar m_total_hops;
     Stats::Formula m_avg_hops;
 
   private:
@@ -127,6 +127,20 @@ class AbstractController : public ClockedObject, public Consumer
     virtual void enqueuePrefetch(const Addr &, const RubyRequestType&)
     { fatal("Prefetches not implemented!");}
 
+    //! Whether the controller can install the state of the blocks
+    //! recorded in a checkpoint directly, instead of replaying requests
+    //! through the protocol (see installWarmupBlock()).
+    virtual bool supportsWarmupInstall() { return false; }
+
+    //! Function for installing the state of a block recorded in a
+    //! checkpoint. It is first called on the owner, the controller
+    //! whose cache held the block, which returns whether it installed
+    //! it. If it did, it is then called on the other controllers, e.g.
+    //! directories, which update their own state to match.
+    virtual bool installWarmupBlock(const Addr &, const RubyRequestType&,
+                                    const MachineID &, const DataBlock &)
+    { fatal("Direct cache warmup not implemented!"); }
+
     //! Function for collating statistics from all the controllers of this
     //! particular type. This function should only be called from the
     //! version 0 of this controller type.
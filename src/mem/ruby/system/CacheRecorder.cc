@@ -30,6 +30,7 @@
 #include "mem/ruby/system/CacheRecorder.hh"
 
 #include "debug/RubyCacheTrace.hh"
+#include "mem/ruby/slicc_interface/AbstractController.hh"
 #include "mem/ruby/system/RubySystem.hh"
 #include "mem/ruby/system/Sequencer.hh"
 
@@ -148,6 +149,53 @@ CacheRecorder::enqueueNextFetchRequest()
     }
 }
 
+void
+CacheRecorder::installRecords(const std::vector<AbstractController*>& cntrls)
+{
+    uint64_t record_size = sizeof(TraceRecord) + m_block_size_bytes;
+    uint64_t num_records = m_uncompressed_trace_size / record_size;
+
+    // The records are sorted from the most to the least recently
+    // accessed, so they are installed in reverse order to leave the
+    // most recently accessed blocks as such in the caches.
+    for (uint64_t i = num_records; i > 0; i--) {
+        TraceRecord* traceRecord = (TraceRecord*) (m_uncompressed_trace +
+                                                   (i - 1) * record_size);
+
+        DPRINTF(RubyCacheTrace, "Installing %s\n", *traceRecord);
+
+        assert(traceRecord->m_cntrl_id < cntrls.size());
+        AbstractController *owner_cntrl = cntrls[traceRecord->m_cntrl_id];
+        MachineID owner = owner_cntrl->getMachineID();
+
+        for (int rec_bytes_read = 0; rec_bytes_read < m_block_size_bytes;
+                rec_bytes_read += RubySystem::getBlockSizeBytes()) {
+            Addr addr = traceRecord->m_data_address + rec_bytes_read;
+            DataBlock data;
+            data.setData(traceRecord->m_data + rec_bytes_read, 0,
+                         RubySystem::getBlockSizeBytes());
+
+            // The other controllers are only updated if the owner
+            // could install the block, to keep the protocol state
+            // consistent.
+            if (!owner_cntrl->installWarmupBlock(addr, traceRecord->m_type,
+                                                 owner, data)) {
+                continue;
+            }
+            for (auto cntrl : cntrls) {
+                if (cntrl != owner_cntrl) {
+                    cntrl->installWarmupBlock(addr, traceRecord->m_type,
+                                              owner, data);
+                }
+            }
+        }
+    }
+
+    m_bytes_read = num_records * record_size;
+    m_records_read = num_records;
+    DPRINTF(RubyCacheTrace, "Installed all %d records\n", m_records_read);
+}
+
 void
 CacheRecorder::addRecord(int cntrl, Addr data_addr, Addr pc_addr,
                          RubyRequestType type, Tick time, DataBlock& data)
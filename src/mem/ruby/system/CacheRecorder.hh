@@ -43,6 +43,7 @@
 #include "mem/ruby/common/TypeDefines.hh"
 #include "mem/ruby/protocol/RubyRequestType.hh"
 
+class AbstractController;
 class Sequencer;
 
 /*!
@@ -97,6 +98,15 @@ class CacheRecorder
      */
     void enqueueNextFetchRequest();
 
+    /*!
+     * Function for warming up the caches without simulating. It goes
+     * through the recorded contents of the caches, as available in the
+     * checkpoint, and installs them in the controllers directly. This
+     * requires all the controllers to support it, see
+     * AbstractController::installWarmupBlock().
+     */
+    void installRecords(const std::vector<AbstractController*>& cntrls);
+
   private:
     // Private copy constructor and assignment operator
     CacheRecorder(const CacheRecorder& obj);
@@ -72,7 +72,7 @@ bool RubySystem::m_cooldown_enabled = false;
 
 RubySystem::RubySystem(const Params *p)
     : ClockedObject(p), m_access_backing_store(p->access_backing_store),
-      m_cache_recorder(NULL)
+      m_direct_warmup(p->direct_warmup), m_cache_recorder(NULL)
 {
     m_randomization = p->randomization;
 
@@ -362,7 +362,19 @@ RubySystem::startup()
     // Ruby finishes restoring the state is less than the time when the
     // state was checkpointed.
 
-    if (m_warmup_enabled) {
+    if (m_warmup_enabled && canInstallWarmup()) {
+        // The protocol can install the recorded state directly, which
+        // doesn't need any simulation.
+        DPRINTF(RubyCacheTrace, "Installing ruby cache state\n");
+        m_cache_recorder->installRecords(m_abs_cntrl_vec);
+
+        delete m_cache_recorder;
+        m_cache_recorder = NULL;
+        m_systems_to_warmup--;
+        if (m_systems_to_warmup == 0) {
+            m_warmup_enabled = false;
+        }
+    } else if (m_warmup_enabled) {
         DPRINTF(RubyCacheTrace, "Starting ruby cache warmup\n");
         // save the current tick value
         Tick curtick_original = curTick();
@@ -393,6 +405,19 @@ RubySystem::startup()
     resetStats();
 }
 
+bool
+RubySystem::canInstallWarmup()
+{
+    if (!m_direct_warmup)
+        return false;
+
+    for (auto cntrl : m_abs_cntrl_vec) {
+        if (!cntrl->supportsWarmupInstall())
+            return false;
+    }
+    return true;
+}
+
 void
 RubySystem::processRubyEvent()
 {
@@ -117,6 +117,13 @@ class RubySystem : public ClockedObject
                                      uint64_t uncompressed_trace_size);
 
     void processRubyEvent();
+
+    /**
+     * Whether the cache contents recorded in a checkpoint can be
+     * installed directly, see CacheRecorder::installRecords().
+     */
+    bool canInstallWarmup();
+
   private:
     // configuration parameters
     static bool m_randomization;
@@ -129,6 +136,7 @@ class RubySystem : public ClockedObject
     static bool m_cooldown_enabled;
     SimpleMemory *m_phys_mem;
     const bool m_access_backing_store;
+    const bool m_direct_warmup;
 
     Network* m_network;
     std::vector<AbstractController *> m_abs_cntrl_vec;
@@ -45,6 +45,11 @@ class RubySystem(ClockedObject):
     access_backing_store = Param.Bool(False, "Use phys_mem as the functional \
         store and only use ruby for timing.")
 
+    direct_warmup = Param.Bool(True, "Install the cache contents recorded \
+        in checkpoints directly when the protocol supports it (MI_example, \
+        MESI_Two_Level), instead of replaying the accesses through the \
+        protocol.")
+
     # Profiler related configuration variables
     hot_lines = Param.Bool(False, "")
     all_instructions = Param.Bool(False, "")
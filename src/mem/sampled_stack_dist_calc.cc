@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/sampled_stack_dist_calc.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "base/logging.hh"
+
+constexpr uint64_t SampledStackDistCalc::Infinity;
+constexpr uint64_t SampledStackDistCalc::Unsampled;
+constexpr uint64_t SampledStackDistCalc::HashRange;
+
+/** Initial number of times in the tree. */
+static const uint64_t initialTimes = 1 << 12;
+
+SampledStackDistCalc::SampledStackDistCalc(double sample_rate,
+                                           uint64_t max_addrs)
+    : threshold(std::llround(sample_rate * HashRange)),
+      maxAddrs(max_addrs), curTime(0),
+      timeAddrs(initialTimes), tree(initialTimes + 1, 0)
+{
+    fatal_if(sample_rate <= 0 || sample_rate > 1,
+             "The sampling rate must be in (0, 1], got %f.\n", sample_rate);
+    threshold = std::max<uint64_t>(threshold, 1);
+}
+
+uint64_t
+SampledStackDistCalc::hash(Addr addr)
+{
+    // The finaliser of MurmurHash3, which spreads the line addresses
+    // uniformly over the hash range
+    addr ^= addr >> 33;
+    addr *= 0xff51afd7ed558ccdULL;
+    addr ^= addr >> 33;
+    addr *= 0xc4ceb9fe1a85ec53ULL;
+    addr ^= addr >> 33;
+    return addr & (HashRange - 1);
+}
+
+void
+SampledStackDistCalc::add(uint64_t time, int64_t value)
+{
+    for (uint64_t i = time + 1; i < tree.size(); i += i & -i)
+        tree[i] += value;
+}
+
+uint64_t
+SampledStackDistCalc::countUpTo(uint64_t time) const
+{
+    uint64_t count = 0;
+    for (uint64_t i = time + 1; i > 0; i -= i & -i)
+        count += tree[i];
+    return count;
+}
+
+void
+SampledStackDistCalc::compact()
+{
+    // Keep the tree at most half full after compaction so that the
+    // cost of compacting is amortised over as many accesses
+    uint64_t num_times = timeAddrs.size();
+    while (stamps.size() * 2 > num_times)
+        num_times *= 2;
+
+    // The addresses of the times that were overwritten since are
+    // stale, and are skipped
+    std::vector<Addr> time_addrs(num_times);
+    uint64_t live = 0;
+    for (uint64_t time = 0; time < curTime; ++time) {
+        auto it = stamps.find(timeAddrs[time]);
+        if (it != stamps.end() && it->second == time) {
+            it->second = live;
+            time_addrs[live++] = it->first;
+        }
+    }
+    assert(live == stamps.size());
+    timeAddrs.swap(time_addrs);
+    curTime = live;
+
+    // Build the tree in linear time, every live time counting one
+    tree.assign(num_times + 1, 0);
+    for (uint64_t i = 1; i <= num_times; ++i) {
+        if (i <= live)
+            tree[i] += 1;
+        const uint64_t parent = i + (i & -i);
+        if (parent <= num_times)
+            tree[parent] += tree[i];
+    }
+}
+
+void
+SampledStackDistCalc::lowerThreshold()
+{
+    while (stamps.size() > maxAddrs) {
+        // Drop the address with the largest hash, and all the others
+        // with the same hash, as they are no longer sampled
+        threshold = hashes.top().first;
+        while (!hashes.empty() && hashes.top().first >= threshold) {
+            auto it = stamps.find(hashes.top().second);
+            if (it != stamps.end()) {
+                add(it->second, -1);
+                stamps.erase(it);
+            }
+            hashes.pop();
+        }
+    }
+}
+
+uint64_t
+SampledStackDistCalc::calcStackDistAndUpdate(const Addr r_address,
+                                             bool add_new_node)
+{
+    const uint64_t addr_hash = hash(r_address);
+    if (addr_hash >= threshold)
+        return Unsampled;
+
+    if (curTime == timeAddrs.size())
+        compact();
+
+    uint64_t stack_dist = Infinity;
+    auto it = stamps.find(r_address);
+    if (it != stamps.end()) {
+        // All the addresses stamped after this one were accessed
+        // since, and are scaled to account for the sampling
+        const uint64_t time = it->second;
+        const uint64_t after = stamps.size() - countUpTo(time);
+        stack_dist = std::llround(after * (double)HashRange / threshold);
+        add(time, -1);
+        if (!add_new_node) {
+            stamps.erase(it);
+            return stack_dist;
+        }
+    } else if (!add_new_node) {
+        return stack_dist;
+    } else {
+        it = stamps.emplace(r_address, 0).first;
+        if (maxAddrs)
+            hashes.emplace(addr_hash, r_address);
+    }
+
+    it->second = curTime;
+    timeAddrs[curTime] = r_address;
+    add(curTime, 1);
+    ++curTime;
+
+    if (maxAddrs && stamps.size() > maxAddrs)
+        lowerThreshold();
+
+    return stack_dist;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_SAMPLED_STACK_DIST_CALC_HH__
+#define __MEM_SAMPLED_STACK_DIST_CALC_HH__
+
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * An approximate stack distance calculator with bounded memory, as
+ * an alternative to the exact StackDistCalc for long traces.
+ *
+ * Every tracked address is stamped with the time of its last access,
+ * and a Fenwick tree (binary indexed tree) counts the addresses last
+ * accessed at each time. The stack distance of an address is then
+ * the number of addresses stamped after it, which is a single prefix
+ * sum. The times are recycled: when the counter reaches the size of
+ * the tree, the live stamps are renumbered in order and the tree is
+ * rebuilt, growing it if more than half of it is live. Each access
+ * therefore takes O(log n) time, and only the first access to an
+ * address allocates, for its stamp.
+ *
+ * The addresses can in addition be spatially sampled as done by
+ * SHARDS (Waldspurger et al., FAST'15): only the addresses whose hash
+ * is below a threshold are tracked, and their stack distances are
+ * scaled by the inverse of the sampling rate. If the number of
+ * tracked addresses is bounded, the addresses with the largest hashes
+ * are dropped when the bound is exceeded and the threshold, and thus
+ * the sampling rate, is lowered accordingly.
+ */
+class SampledStackDistCalc
+{
+  public:
+    /**
+     * @param sample_rate Initial fraction of the addresses tracked
+     * @param max_addrs Maximum number of tracked addresses, 0 for
+     *        no maximum
+     */
+    SampledStackDistCalc(double sample_rate = 1.0, uint64_t max_addrs = 0);
+
+    /** The stack distance of an address accessed for the first time. */
+    static constexpr uint64_t Infinity = std::numeric_limits<uint64_t>::max();
+
+    /** The stack distance of an address that is not sampled. */
+    static constexpr uint64_t Unsampled = Infinity - 1;
+
+    /**
+     * Process the given address:
+     *  - Lookup the stack distance of the given address
+     *  - remove it from the stack if found
+     *  - put it at the top of the stack (if add_new_node is set)
+     *
+     * @param r_address The current address to process
+     * @param add_new_node If true, the address is put at the top
+     * @return The stack distance of the address scaled by the
+     *         sampling rate, Infinity if not found, or Unsampled if
+     *         the address is not sampled.
+     */
+    uint64_t calcStackDistAndUpdate(const Addr r_address,
+                                    bool add_new_node = true);
+
+    /** The current fraction of the addresses that are tracked. */
+    double sampleRate() const { return (double)threshold / HashRange; }
+
+    /** The number of addresses currently tracked. */
+    uint64_t numAddrs() const { return stamps.size(); }
+
+  private:
+    /** Range of the hashes compared to the sampling threshold. */
+    static constexpr uint64_t HashRange = 1ULL << 24;
+
+    /** Hash of an address, in [0, HashRange). */
+    static uint64_t hash(Addr addr);
+
+    /** Add a value to the count of a time in the tree. */
+    void add(uint64_t time, int64_t value);
+
+    /** Number of tracked addresses stamped at or before a time. */
+    uint64_t countUpTo(uint64_t time) const;
+
+    /** Renumber the live times, growing the tree if needed. */
+    void compact();
+
+    /** Drop the tracked addresses that are no longer sampled. */
+    void lowerThreshold();
+
+    /** Addresses are sampled if their hash is below the threshold. */
+    uint64_t threshold;
+
+    /** Maximum number of tracked addresses, 0 for no maximum. */
+    const uint64_t maxAddrs;
+
+    /** Time of the next access, i.e. the next free time in the tree. */
+    uint64_t curTime;
+
+    /** Time of the last access to every tracked address. */
+    std::unordered_map<Addr, uint64_t> stamps;
+
+    /** The address accessed at every time, possibly stale. */
+    std::vector<Addr> timeAddrs;
+
+    /** Fenwick tree counting the tracked addresses by time. */
+    std::vector<uint32_t> tree;
+
+    /**
+     * Hashes of the tracked addresses, the largest first, to find
+     * the addresses to drop when the threshold is lowered. Only kept
+     * if the number of tracked addresses is bounded.
+     */
+    std::priority_queue<std::pair<uint64_t, Addr>> hashes;
+};
+
+#endif //__MEM_SAMPLED_STACK_DIST_CALC_HH__
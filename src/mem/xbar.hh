@@ -391,11 +391,13 @@ class BaseXBar : public ClockedObject
      * size are two-dimensional vectors that are indexed by the
      * slave port and master port id (thus the neighbouring master and
      * neighbouring slave), summing up both directions (request and
-     * response).
+     * response). They are sharded, as the crossbar is accessed by
+     * the objects on either side of it, which may be on other event
+     * queues.
      */
-    Stats::Vector transDist;
-    Stats::Vector2d pktCount;
-    Stats::Vector2d pktSize;
+    Stats::ShardedVector transDist;
+    Stats::ShardedVector2d pktCount;
+    Stats::ShardedVector2d pktSize;
 
   public:
 
@@ -37,22 +37,52 @@
 
 #include "proto/protoio.hh"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
 #include "base/logging.hh"
 
 using namespace std;
 using namespace google::protobuf;
 
+namespace
+{
+
+/** All the output streams, to flush them. */
+vector<ProtoOutputStream *> &
+protoOutputStreams()
+{
+    static vector<ProtoOutputStream *> streams;
+    return streams;
+}
+
+/** All the read-ahead streams, to stop them. */
+vector<BaseProtoReadAheadStream *> &
+protoReadAheadStreams()
+{
+    static vector<BaseProtoReadAheadStream *> streams;
+    return streams;
+}
+
+} // anonymous namespace
+
 ProtoOutputStream::ProtoOutputStream(const string& filename) :
-    fileStream(filename.c_str(), ios::out | ios::binary | ios::trunc),
-    wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL)
+    fd(open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664)),
+    wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL),
+    backBufferFull(false), stopping(false), numStalls(0), writer(NULL),
+    ownerPid(getpid())
 {
-    if (!fileStream.good())
+    if (fd < 0)
         panic("Could not open %s for writing\n", filename);
 
     // Wrap the output file in a zero copy stream, that in turn is
     // wrapped in a gzip stream if the filename ends with .gz. The
-    // latter stream is in turn wrapped in a coded stream
-    wrappedFileStream = new io::OstreamOutputStream(&fileStream);
+    // latter stream is in turn wrapped in a coded stream. Unlike an
+    // STL stream, the file stream can be flushed all the way to the
+    // file before forking.
+    wrappedFileStream = new io::FileOutputStream(fd);
     if (filename.find_last_of('.') != string::npos &&
         filename.substr(filename.find_last_of('.') + 1) == "gz") {
         gzipStream = new io::GzipOutputStream(wrappedFileStream);
@@ -67,40 +97,158 @@ ProtoOutputStream::ProtoOutputStream(const string& filename) :
 
     // Note that each type of stream (packet, instruction etc) should
     // add its own header and perform the appropriate checks
+
+    frontBuffer.reserve(bufferSize);
+    backBuffer.reserve(bufferSize);
+    protoOutputStreams().push_back(this);
 }
 
 ProtoOutputStream::~ProtoOutputStream()
 {
+    auto &streams = protoOutputStreams();
+    streams.erase(std::remove(streams.begin(), streams.end(), this),
+                  streams.end());
+
+    if (ownerPid != getpid()) {
+        // The process that created the stream still owns the file,
+        // and the compression state that would be written out when
+        // closing it, so only release our copy of the descriptor
+        close(fd);
+        return;
+    }
+
+    flush();
+    stopWriter();
+
     // As the compression is optional, see if the stream exists
     if (gzipStream != NULL)
         delete gzipStream;
+    wrappedFileStream->Close();
     delete wrappedFileStream;
-    fileStream.close();
 }
 
 void
 ProtoOutputStream::write(const Message& msg)
 {
-    // Due to the byte limit of the coded stream we create it for
-    // every single mesage (based on forum discussions around the size
-    // limitation)
-    io::CodedOutputStream codedStream(zeroCopyStream);
+    if (ownerPid != getpid()) {
+        warn_once("Traces are not written by forked processes\n");
+        return;
+    }
 
-    // Write the size of the message to the stream
+    // Serialize the message, prepended with its size, at the end of
+    // the buffer
 #   if GOOGLE_PROTOBUF_VERSION < 3001000
         auto msg_size = msg.ByteSize();
 #   else
         auto msg_size = msg.ByteSizeLong();
 #   endif
-    codedStream.WriteVarint32(msg_size);
+    const size_t offset = frontBuffer.size();
+    const size_t size_size = io::CodedOutputStream::VarintSize32(msg_size);
+    frontBuffer.resize(offset + size_size + msg_size);
+    uint8_t *target = reinterpret_cast<uint8_t *>(&frontBuffer[offset]);
+    target = io::CodedOutputStream::WriteVarint32ToArray(msg_size, target);
+    msg.SerializeWithCachedSizesToArray(target);
+
+    if (frontBuffer.size() >= bufferSize)
+        handOver();
+}
+
+void
+ProtoOutputStream::flush()
+{
+    if (ownerPid != getpid())
+        return;
+
+    if (!frontBuffer.empty())
+        handOver();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return !backBufferFull; });
+
+    // The writer is idle, so push the pending data out of the
+    // compression stream and the file stream buffer to the file
+    if (gzipStream != NULL)
+        gzipStream->Flush();
+    wrappedFileStream->Flush();
+}
+
+void
+ProtoOutputStream::flushAll()
+{
+    // The writer threads are stopped as well, so that a forked
+    // process does not inherit any thread state or lock held by them,
+    // and are started again when needed
+    for (auto *stream : protoOutputStreams()) {
+        stream->flush();
+        stream->stopWriter();
+    }
+}
 
-    // Write the message itself to the stream
-    msg.SerializeWithCachedSizes(&codedStream);
+void
+ProtoOutputStream::handOver()
+{
+    if (writer == NULL)
+        writer = new std::thread(&ProtoOutputStream::writerLoop, this);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (backBufferFull) {
+            ++numStalls;
+            cond.wait(lock, [this] { return !backBufferFull; });
+        }
+        frontBuffer.swap(backBuffer);
+        backBufferFull = true;
+    }
+    cond.notify_all();
+
+    // The buffer we got back has been written already, but keep its
+    // memory
+    frontBuffer.clear();
+}
+
+void
+ProtoOutputStream::stopWriter()
+{
+    if (writer == NULL)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cond.notify_all();
+    writer->join();
+    delete writer;
+    writer = NULL;
+    stopping = false;
+}
+
+void
+ProtoOutputStream::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cond.wait(lock, [this] { return stopping || backBufferFull; });
+        if (!backBufferFull)
+            return;
+
+        // The back buffer is not touched by anyone else until it is
+        // marked as written
+        lock.unlock();
+        {
+            io::CodedOutputStream codedStream(zeroCopyStream);
+            codedStream.WriteRaw(backBuffer.data(), backBuffer.size());
+        }
+        lock.lock();
+
+        backBufferFull = false;
+        cond.notify_all();
+    }
 }
 
 ProtoInputStream::ProtoInputStream(const string& filename) :
     fileStream(filename.c_str(), ios::in | ios::binary), fileName(filename),
-    useGzip(false),
+    useGzip(false), savedPosition(0),
     wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL)
 {
     if (!fileStream.good())
@@ -176,6 +324,25 @@ ProtoInputStream::reset()
     createStreams();
 }
 
+void
+ProtoInputStream::savePosition()
+{
+    savedPosition = fileStream.tellg();
+}
+
+void
+ProtoInputStream::reopen()
+{
+    // The buffered data and the decompression state are kept, and
+    // only the file is opened again, at the position it was read up
+    // to before forking
+    fileStream.close();
+    fileStream.open(fileName.c_str(), ios::in | ios::binary);
+    if (!fileStream.good())
+        panic("Could not open %s for reading\n", fileName);
+    fileStream.seekg(savedPosition);
+}
+
 bool
 ProtoInputStream::read(Message& msg)
 {
@@ -202,3 +369,22 @@ ProtoInputStream::read(Message& msg)
 
     return false;
 }
+
+BaseProtoReadAheadStream::BaseProtoReadAheadStream()
+{
+    protoReadAheadStreams().push_back(this);
+}
+
+BaseProtoReadAheadStream::~BaseProtoReadAheadStream()
+{
+    auto &streams = protoReadAheadStreams();
+    streams.erase(std::remove(streams.begin(), streams.end(), this),
+                  streams.end());
+}
+
+void
+BaseProtoReadAheadStream::stopAll()
+{
+    for (auto *stream : protoReadAheadStreams())
+        stream->stopForFork();
+}
@@ -48,8 +48,20 @@
 #include <google/protobuf/io/gzip_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/message.h>
+#include <sys/types.h>
+#include <unistd.h>
 
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "base/logging.hh"
+#include <vector>
 
 /**
  * A ProtoStream provides the shared functionality of the input and
@@ -86,6 +98,18 @@ class ProtoStream
  * basis to avoid having to deal with huge data structures. The latter
  * is made possible by encoding the length of each message in the
  * stream.
+ *
+ * Only the serialization of the messages is done when they are
+ * written. The serialized messages are collected in a buffer, which
+ * is handed over to a writer thread once full, and the writer thread
+ * does the compression and the file I/O while simulation
+ * continues. There are two buffers, and if the writer is still busy
+ * with the previous buffer when the next one is full, the write waits
+ * for it, which bounds the memory used.
+ *
+ * The file belongs to the process that created the stream. All the
+ * streams have to be flushed with flushAll() before forking, and a
+ * forked process does not write to the stream at all.
  */
 class ProtoOutputStream : public ProtoStream
 {
@@ -114,13 +138,49 @@ class ProtoOutputStream : public ProtoStream
      */
     void write(const google::protobuf::Message& msg);
 
+    /**
+     * Wait until all the messages written so far have been compressed
+     * and passed to the underlying file stream. The stream can still
+     * be written to afterwards.
+     */
+    void flush();
+
+    /**
+     * Flush all the output streams and stop their writer threads,
+     * which is needed before forking. The writer threads are started
+     * again by the next hand-over.
+     */
+    static void flushAll();
+
+    /**
+     * Get the number of times a write had to wait for the writer
+     * thread, which is a sign of the trace being produced faster than
+     * it can be compressed and stored.
+     */
+    uint64_t stalls() const { return numStalls; }
+
   private:
 
-    /// Underlying file output stream
-    std::ofstream fileStream;
+    /**
+     * Hand the buffer of serialized messages over to the writer
+     * thread, waiting for the writer if it is still busy.
+     */
+    void handOver();
+
+    /** Wait for the writer thread to finish and exit. */
+    void stopWriter();
+
+    /** Body of the writer thread. */
+    void writerLoop();
+
+    /// Size of the buffer after which it is handed over to the writer
+    static const size_t bufferSize = 1 << 20;
+
+    /// Descriptor of the output file
+    int fd;
 
-    /// Zero Copy stream wrapping the STL output stream
-    google::protobuf::io::OstreamOutputStream* wrappedFileStream;
+    /// Zero Copy stream wrapping the file descriptor
+    google::protobuf::io::FileOutputStream* wrappedFileStream;
 
     /// Optional Gzip stream to wrap the Zero Copy stream
     google::protobuf::io::GzipOutputStream* gzipStream;
@@ -128,6 +188,30 @@ class ProtoOutputStream : public ProtoStream
     /// Top-level zero-copy stream, either with compression or not
     google::protobuf::io::ZeroCopyOutputStream* zeroCopyStream;
 
+    /// Serialized messages that have not been handed over yet
+    std::string frontBuffer;
+
+    /// Serialized messages handed over to the writer thread
+    std::string backBuffer;
+
+    /// Whether the back buffer holds messages that are not written yet
+    bool backBufferFull;
+
+    /// Whether the writer thread should exit
+    bool stopping;
+
+    /// Number of writes that waited for the writer thread
+    uint64_t numStalls;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    /// Writer thread, only running once messages are handed over
+    std::thread* writer;
+
+    /// Process that created the stream
+    pid_t ownerPid;
+
 };
 
 /**
@@ -169,6 +253,18 @@ class ProtoInputStream : public ProtoStream
      */
     void reset();
 
+    /**
+     * Remember the position in the file, before forking.
+     */
+    void savePosition();
+
+    /**
+     * Open the file again at the saved position, after forking, so
+     * that the forked process does not share the file offset with
+     * its parent.
+     */
+    void reopen();
+
   private:
 
     /**
@@ -190,6 +286,9 @@ class ProtoInputStream : public ProtoStream
     /// Boolean flag to remember whether we use gzip or not
     bool useGzip;
 
+    /// Position in the file saved before forking
+    std::streampos savedPosition;
+
     /// Zero Copy stream wrapping the STL input stream
     google::protobuf::io::IstreamInputStream* wrappedFileStream;
 
@@ -201,4 +300,296 @@ class ProtoInputStream : public ProtoStream
 
 };
 
+/**
+ * Base of the read-ahead streams of all message types, keeping track
+ * of them so that their helper threads can be stopped before forking.
+ */
+class BaseProtoReadAheadStream
+{
+
+  public:
+
+    /**
+     * Stop the helper threads of all the read-ahead streams, which
+     * has to be done before forking. The threads are started again
+     * when the streams are read, in the parent or the child process.
+     */
+    static void stopAll();
+
+  protected:
+
+    BaseProtoReadAheadStream();
+
+    virtual ~BaseProtoReadAheadStream();
+
+    /**
+     * Stop the helper thread and remember the position in the file.
+     */
+    virtual void stopForFork() = 0;
+
+};
+
+/**
+ * A ProtoReadAheadStream reads messages of a single type from a
+ * ProtoInputStream, and does the decompression and the parsing ahead
+ * of time on a helper thread. The messages are parsed in batches,
+ * and a bounded number of batches is kept ready, so that the reader
+ * rarely has to wait for the file or for zlib.
+ *
+ * Messages of other types at the start of the file, such as headers,
+ * are read with readHeader() before reading the first message.
+ */
+template <class Msg>
+class ProtoReadAheadStream : public BaseProtoReadAheadStream
+{
+
+  public:
+
+    /**
+     * Create a read-ahead stream for a given file name. The helper
+     * thread is only started when the first message is read.
+     *
+     * @param filename Path to the file to read from
+     * @param batch_size Number of messages parsed at a time
+     * @param num_batches Maximum number of batches parsed ahead
+     */
+    ProtoReadAheadStream(const std::string& filename,
+                         size_t batch_size = 1024, size_t num_batches = 4)
+        : trace(filename), batches(num_batches + 1), current(nullptr),
+          currentIdx(0), started(false), endOfFile(false), stopping(false),
+          ownerPid(getpid())
+    {
+        assert(batch_size > 0 && num_batches > 0);
+        for (auto &batch : batches) {
+            batch.msgs.resize(batch_size);
+            freeBatches.push_back(&batch);
+        }
+    }
+
+    /**
+     * Destruct the stream, stopping the helper thread.
+     */
+    ~ProtoReadAheadStream()
+    {
+        if (ownerPid != getpid()) {
+            // the helper thread belongs to another process
+            if (reader.joinable())
+                reader.detach();
+            return;
+        }
+        stopReader();
+    }
+
+    /**
+     * Read a message that is not read ahead, such as a header. This
+     * can only be done before the first call to read() after creating
+     * or resetting the stream.
+     *
+     * @param msg Message read from the stream
+     * @param return True if a message was read, false if reading fails
+     */
+    bool
+    readHeader(google::protobuf::Message& msg)
+    {
+        assert(!started);
+        adoptAfterFork();
+        return trace.read(msg);
+    }
+
+    /**
+     * Read the next message from the stream.
+     *
+     * @param msg Message read from the stream
+     * @param return True if a message was read, false at the end
+     */
+    bool
+    read(Msg& msg)
+    {
+        // the helper thread is started by the first read, and again
+        // after being stopped for a fork
+        if (!reader.joinable() && !endOfFile) {
+            adoptAfterFork();
+            started = true;
+            reader = std::thread(&ProtoReadAheadStream::readerLoop, this);
+        }
+
+        if (!current || currentIdx == current->numMsgs) {
+            if (current && current->numMsgs < current->msgs.size()) {
+                // The last batch was not full, so there is nothing
+                // more to read
+                return false;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (current) {
+                freeBatches.push_back(current);
+                current = nullptr;
+                cond.notify_all();
+            }
+            cond.wait(lock, [this] {
+                return !readyBatches.empty() || endOfFile;
+            });
+            if (readyBatches.empty())
+                return false;
+            current = readyBatches.front();
+            readyBatches.pop_front();
+            currentIdx = 0;
+
+            if (current->numMsgs == 0)
+                return false;
+        }
+
+        msg.Swap(&current->msgs[currentIdx++]);
+        return true;
+    }
+
+    /**
+     * Reset the stream and seek to the beginning of the file.
+     */
+    void
+    reset()
+    {
+        adoptAfterFork();
+        stopReader();
+
+        freeBatches.clear();
+        readyBatches.clear();
+        for (auto &batch : batches)
+            freeBatches.push_back(&batch);
+        current = nullptr;
+        currentIdx = 0;
+        started = false;
+        endOfFile = false;
+        stopping = false;
+
+        trace.reset();
+    }
+
+  private:
+
+    /** A batch of messages, of which numMsgs are valid. */
+    struct Batch
+    {
+        std::vector<Msg> msgs;
+        size_t numMsgs = 0;
+    };
+
+    /**
+     * Stop the helper thread, if it is running.
+     */
+    void
+    stopReader()
+    {
+        if (!reader.joinable())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cond.notify_all();
+        reader.join();
+        stopping = false;
+    }
+
+    void
+    stopForFork() override
+    {
+        if (ownerPid != getpid())
+            return;
+        stopReader();
+        trace.savePosition();
+    }
+
+    /**
+     * Take over the stream in a forked process, which must have been
+     * stopped with stopAll() before forking.
+     */
+    void
+    adoptAfterFork()
+    {
+        if (ownerPid == getpid())
+            return;
+
+        panic_if(reader.joinable(), "Forked without stopping the "
+                 "read-ahead threads\n");
+        trace.reopen();
+        ownerPid = getpid();
+    }
+
+    /**
+     * Body of the helper thread, which fills the free batches until
+     * reaching the end of the file.
+     */
+    void
+    readerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cond.wait(lock, [this] {
+                return stopping || !freeBatches.empty();
+            });
+            if (stopping)
+                return;
+
+            Batch *batch = freeBatches.front();
+            freeBatches.pop_front();
+            lock.unlock();
+
+            // The stream is only used by this thread until it stops
+            batch->numMsgs = 0;
+            while (batch->numMsgs < batch->msgs.size() &&
+                   trace.read(batch->msgs[batch->numMsgs])) {
+                ++batch->numMsgs;
+            }
+            const bool at_end = batch->numMsgs < batch->msgs.size();
+
+            lock.lock();
+            readyBatches.push_back(batch);
+            if (at_end) {
+                endOfFile = true;
+                cond.notify_all();
+                return;
+            }
+            cond.notify_all();
+        }
+    }
+
+    /// Underlying input stream
+    ProtoInputStream trace;
+
+    /// All the batches
+    std::vector<Batch> batches;
+
+    /// Batches that can be filled by the helper thread
+    std::deque<Batch *> freeBatches;
+
+    /// Batches filled by the helper thread and not read yet
+    std::deque<Batch *> readyBatches;
+
+    /// Batch being read, owned by the reader of the stream
+    Batch *current;
+
+    /// Index of the next message to read in the current batch
+    size_t currentIdx;
+
+    /// Whether the helper thread has been started
+    bool started;
+
+    /// Whether the helper thread reached the end of the file
+    bool endOfFile;
+
+    /// Whether the helper thread should exit
+    bool stopping;
+
+    /// Process the helper thread and the file offset belong to
+    pid_t ownerPid;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    std::thread reader;
+
+};
+
 #endif //__PROTO_PROTOIO_HH
@@ -118,6 +118,15 @@ def parse_options():
     option("--stats-help",
            action="callback", callback=_stats_help,
            help="Display documentation for available stat visitors")
+    option("--stats-port", metavar="PORT", type='int', default=0,
+        help="Answer queries for the current values of stats on this " \
+             "port, or the next free one (requires listeners, see " \
+             "--listener-mode) [Default: disabled]")
+    option("--stats-level", metavar="{basic,detailed}",
+        choices=["basic", "detailed"], default="detailed",
+        help="Level of the stats to update and print (detailed stats " \
+             "can also be compiled out with DETAILED_STATS=False) " \
+             "[Default: %default]")
 
     # Configuration Options
     group("Configuration Options")
@@ -365,6 +374,8 @@ def main(*args):
 
     # set stats options
     stats.addStatVisitor(options.stats_file)
+    if options.stats_level != "detailed":
+        stats.setDetailedEnabled(False)
 
     # Disable listeners unless running interactively or explicitly
     # enabled
@@ -382,6 +393,9 @@ def main(*args):
     if options.listener_loopback_only:
         m5.listenersLoopbackOnly()
 
+    if options.stats_port:
+        stats.startServer(options.stats_port)
+
     # set debugging options
     debug.setRemoteGDBPort(options.remote_gdb_port)
     for when in options.debug_break:
@@ -113,6 +113,11 @@ def instantiate(ckpt_dir=None):
     # Initialize the global statistics
     stats.initSimStats()
 
+    # Sharded stats keep one shard per event queue, so that objects
+    # accessed from several event queues can update them in parallel
+    _m5.stats.setNumShards(
+        max(obj.eventq_index for obj in root.descendants()) + 1)
+
     # Create the C++ sim objects and connect ports
     for obj in root.descendants(): obj.createCCObject()
     for obj in root.descendants(): obj.connectPorts()
@@ -162,7 +167,9 @@ def simulate(*args, **kwargs):
         need_startup = False
 
         # Python exit handlers happen in reverse order.
-        # We want to dump stats last.
+        # We want to dump stats last, and then wait for them to be
+        # written.
+        atexit.register(stats.flush)
         atexit.register(stats.dump)
 
         # register our C++ exit callback function with Python
@@ -219,7 +226,7 @@ def memInvalidate(root):
     for obj in root.descendants():
         obj.memInvalidate()
 
-def checkpoint(dir):
+def checkpoint(dir, binary=False):
     root = objects.Root.getInstance()
     if not isinstance(root, objects.Root):
         raise TypeError("Checkpoint must be called on a root object.")
@@ -227,7 +234,7 @@ def checkpoint(dir):
     drain()
     memWriteback(root)
     print("Writing checkpoint")
-    _m5.core.serializeAll(dir)
+    _m5.core.serializeAll(dir, binary)
 
 def _changeMemoryMode(system, mode):
     if not isinstance(system, (objects.Root, objects.System)):
@@ -345,6 +352,8 @@ def fork(simout="%(parent)s.f%(fork_seq)i"):
         raise RuntimeError("Can not fork a simulator with listeners enabled")
 
     drain()
+    stats.flush()
+    _m5.core.flushTraces()
 
     try:
         pid = os.fork()
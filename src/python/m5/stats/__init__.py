@@ -50,6 +50,8 @@ from m5.util import attrdict, fatal
 # Stat exports
 from _m5.stats import schedStatEvent as schedEvent
 from _m5.stats import periodicStatDump
+from _m5.stats import startServer
+from _m5.stats import setDetailedEnabled
 
 outputList = []
 
@@ -116,12 +118,17 @@ def _url_factory(schemes, enable=True):
                               % (url.geturl(), values[0]))
 
             kwargs = dict([ parse_value(k, v) for k, v in qs.items() ])
+            background = kwargs.pop("background", False)
 
             try:
-                return func("%s%s" % (url.netloc, url.path), **kwargs)
+                output = func("%s%s" % (url.netloc, url.path), **kwargs)
             except TypeError:
                 fatal("Illegal stat visitor parameter specified")
 
+            if background:
+                output = _m5.stats.initAsync(output)
+            return output
+
         all_factories.append((wrapper, schemes, enable))
         for scheme in schemes:
             assert scheme not in factories
@@ -184,6 +191,33 @@ def _hdf5Factory(fn, chunking=10, desc=True, formulas=True):
 
     return _m5.stats.initHDF5(fn, chunking, desc, formulas)
 
+@_url_factory([ "columnar", ])
+def _columnarFactory(fn, desc=True, formulas=True, compress=True):
+    """Output stats in a binary, columnar format.
+
+    The names and shapes of the stats are only written once, and each
+    stat dump then writes the values of all stats as a single array,
+    which makes dumps much cheaper than in the text format. This is
+    useful to collect time series with frequent periodic dumps. Files
+    can be read with util/stats/columnar.py.
+
+    Known limitations:
+      * Sparse histograms are unsupported.
+      * Stats are dumped regardless of their prerequisites and of the
+        nozero and nonan flags.
+
+    Parameters:
+      * desc (bool): Output stat descriptions (default: True)
+      * formulas (bool): Output derived stats (default: True)
+      * compress (bool): Compress the stat dumps (default: True)
+
+    Example:
+      columnar://stats.bin?desc=False;compress=False
+
+    """
+
+    return _m5.stats.initColumnar(fn, desc, formulas, compress)
+
 def addStatVisitor(url):
     """Add a stat visitor specified using a URL string
 
@@ -195,6 +229,11 @@ def addStatVisitor(url):
     parameters are keyword arguments. Parameter values must be valid
     Python literals.
 
+    All formats accept a background parameter. When it is True, stat
+    dumps only copy the values of the stats, and the stats are
+    formatted and written by a separate thread while simulation
+    continues, e.g., text://stats.txt?background=True.
+
     """
 
     try:
@@ -380,6 +419,11 @@ def dump(root=None):
             _dump_to_visitor(output, root=root)
             output.end()
 
+def flush():
+    '''Wait for the stats dumped by background outputs to be written'''
+
+    _m5.stats.flushAsyncOutputs()
+
 def reset():
     '''Reset all statistics to the base state'''
 
@@ -404,4 +448,6 @@ flags = attrdict({
     'dist'    : 0x0080,
     'nozero'  : 0x0100,
     'nonan'   : 0x0200,
+    'oneline' : 0x0400,
+    'detailed': 0x0800,
 })
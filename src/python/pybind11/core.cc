@@ -53,11 +53,16 @@
 #include "base/random.hh"
 #include "base/socket.hh"
 #include "base/types.hh"
+#include "config/have_protobuf.hh"
 #include "sim/core.hh"
 #include "sim/drain.hh"
 #include "sim/serialize.hh"
 #include "sim/sim_object.hh"
 
+#if HAVE_PROTOBUF
+#include "proto/protoio.hh"
+#endif
+
 namespace py = pybind11;
 
 /** Resolve a SimObject name using the Pybind configuration */
@@ -207,6 +212,20 @@ init_loader(py::module &m_native)
     m.def("setInterpDir", &Loader::setInterpDir);
 }
 
+/**
+ * Write out the messages of all the trace output streams and stop
+ * their writer threads, as well as the read-ahead threads of the
+ * trace input streams, which is needed before forking.
+ */
+static void
+flushTraces()
+{
+#if HAVE_PROTOBUF
+    ProtoOutputStream::flushAll();
+    BaseProtoReadAheadStream::stopAll();
+#endif
+}
+
 void
 pybind_init_core(py::module &m_native)
 {
@@ -244,6 +263,7 @@ pybind_init_core(py::module &m_native)
         .def("setLogLevel", &Logger::setLevel)
         .def("setOutputDir", &setOutputDir)
         .def("doExitCleanup", &doExitCleanup)
+        .def("flushTraces", &flushTraces)
 
         .def("disableAllListeners", &ListenSocket::disableAll)
         .def("listenersDisabled", &ListenSocket::allDisabled)
@@ -274,7 +294,8 @@ pybind_init_core(py::module &m_native)
      * Serialization helpers
      */
     m_core
-        .def("serializeAll", &Serializable::serializeAll)
+        .def("serializeAll", &Serializable::serializeAll,
+             py::arg("cpt_dir"), py::arg("binary") = false)
         .def("unserializeGlobals", &Serializable::unserializeGlobals)
         .def("getCheckpoint", [](const std::string &cpt_dir) {
             return new CheckpointIn(cpt_dir, pybindSimObjectResolver);
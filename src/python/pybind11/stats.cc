@@ -44,12 +44,15 @@
 #include "pybind11/stl.h"
 
 #include "base/statistics.hh"
+#include "base/stats/async_output.hh"
+#include "base/stats/columnar.hh"
 #include "base/stats/text.hh"
 #if USE_HDF5
 #include "base/stats/hdf5.hh"
 #endif
 #include "sim/stat_control.hh"
 #include "sim/stat_register.hh"
+#include "sim/stat_server.hh"
 
 
 namespace py = pybind11;
@@ -83,13 +86,19 @@ pybind_init_stats(py::module &m_native)
 #if USE_HDF5
         .def("initHDF5", &Stats::initHDF5)
 #endif
+        .def("initColumnar", &Stats::initColumnar)
+        .def("initAsync", &Stats::initAsync, py::keep_alive<0, 1>())
+        .def("flushAsyncOutputs", &Stats::AsyncOutput::flushAll)
         .def("registerPythonStatsHandlers",
              &Stats::registerPythonStatsHandlers)
         .def("schedStatEvent", &Stats::schedStatEvent)
         .def("periodicStatDump", &Stats::periodicStatDump)
+        .def("startServer", &Stats::startServer)
         .def("updateEvents", &Stats::updateEvents)
         .def("processResetQueue", &Stats::processResetQueue)
         .def("processDumpQueue", &Stats::processDumpQueue)
+        .def("setNumShards", &Stats::setNumShards)
+        .def("setDetailedEnabled", &Stats::setDetailedEnabled)
         .def("enable", &Stats::enable)
         .def("enabled", &Stats::enabled)
         .def("statsList", &Stats::statsList)
@@ -118,6 +127,18 @@ pybind_init_stats(py::module &m_native)
         .def("reset", &Stats::Info::reset)
         .def("zero", &Stats::Info::zero)
         .def("visit", &Stats::Info::visit)
+        .def_property_readonly("value", [](const Stats::Info &info) {
+                // Scalars as a number, vectors and formulas as a list
+                if (auto scalar = dynamic_cast<const Stats::ScalarInfo *>(
+                        &info)) {
+                    return py::cast(scalar->result());
+                } else if (auto vector =
+                           dynamic_cast<const Stats::VectorInfo *>(&info)) {
+                    return py::cast(vector->result());
+                } else {
+                    return py::object(py::none());
+                }
+            })
         ;
 
     py::class_<Stats::Group, std::unique_ptr<Stats::Group, py::nodelete>>(
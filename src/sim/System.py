@@ -48,6 +48,10 @@ from m5.objects.SimpleMemory import *
 class MemoryMode(Enum): vals = ['invalid', 'atomic', 'timing',
                                 'atomic_noncaching']
 
+class HugePageMode(ScopedEnum): vals = ['none', 'transparent', 'hugetlb']
+
+class MemoryCheckpointFormat(ScopedEnum): vals = ['gzip', 'raw', 'chunked']
+
 class System(SimObject):
     type = 'System'
     cxx_header = "sim/system.hh"
@@ -73,6 +77,44 @@ class System(SimObject):
     mmap_using_noreserve = Param.Bool(False, "mmap the backing store " \
                                           "without reserving swap")
 
+    # Large simulated memories put a lot of pressure on the host TLB
+    # when the backing store is accessed. The backing store can either
+    # be advised to use transparent huge pages, or be mapped using
+    # explicit (hugetlb) huge pages, in which case we fall back to
+    # normal pages if the host has not reserved enough of them.
+    mmap_huge_pages = Param.HugePageMode('none', "Use host huge pages " \
+                                         "for the backing store")
+
+    # On multi-socket hosts the backing store of each memory can be
+    # bound to a host NUMA node. The list is indexed by the event
+    # queue of the memories covered by the backing store, so that the
+    # memory is local to the host thread simulating its controller. An
+    # empty list leaves the placement to the host OS.
+    eventq_numa_nodes = VectorParam.Int([], "Host NUMA node to bind the " \
+                                        "backing store to, per event queue")
+
+    # The memory contents of a checkpoint are either gzip compressed,
+    # or stored uncompressed (as sparse files without the zero
+    # pages). Uncompressed stores are mapped copy-on-write as the
+    # backing store when restoring, which makes restoring near
+    # instant and lets simulations restored from the same checkpoint
+    # share the host page cache. Chunked stores are split in fixed
+    # size chunks that are compressed independently, and without the
+    # chunks that only contain zeros, which lets both checkpointing
+    # and restoring use multiple host threads.
+    memory_checkpoint_format = Param.MemoryCheckpointFormat('gzip',
+        "Format used for the memory contents of checkpoints")
+    memory_checkpoint_threads = Param.Unsigned(0, "Host threads used to " \
+        "(de)compress chunked memory checkpoints, 0 to use all host cores")
+
+    # Periodic checkpoints of long runs can be made incremental, in
+    # which case a chunked store only contains the chunks that changed
+    # since the previous checkpoint taken or restored, and refers to
+    # the store of that checkpoint for the others. Restoring follows
+    # the chain of stores, which therefore all have to be kept.
+    memory_checkpoint_incremental = Param.Bool(False, "Only store the " \
+        "memory changed since the previous checkpoint (chunked format)")
+
     # The memory ranges are to be populated when creating the system
     # such that these can be passed from the I/O subsystem through an
     # I/O bridge or cache
@@ -196,6 +196,9 @@ Event *
 EventQueue::serviceOne()
 {
     std::lock_guard<EventQueue> lock(*this);
+    if (remotePending.load(std::memory_order_acquire))
+        handleRemoteInsertions();
+
     Event *event = head;
     Event *next = head->nextInBin;
     event->flags.clear(Event::Scheduled);
@@ -418,7 +421,7 @@ Event::dump() const
 }
 
 EventQueue::EventQueue(const string &n)
-    : objName(n), head(NULL), _curTick(0)
+    : objName(n), head(NULL), _curTick(0), remotePending(false)
 {
 }
 
@@ -443,3 +446,38 @@ EventQueue::handleAsyncInsertions()
 
     async_queue_mutex.unlock();
 }
+
+void
+EventQueue::scheduleRemote(Event *event, Tick when)
+{
+    assert(!event->scheduled());
+    assert(event->initialized());
+
+    // the event is only visible to this thread until it is queued
+    event->setWhen(when, this);
+    event->flags.set(Event::Scheduled);
+    event->acquire();
+
+    std::lock_guard<std::mutex> lock(remote_queue_mutex);
+    remote_queue.push_back(event);
+    remotePending.store(true, std::memory_order_release);
+}
+
+void
+EventQueue::handleRemoteInsertions()
+{
+    assert(this == curEventQueue());
+    std::lock_guard<std::mutex> lock(remote_queue_mutex);
+
+    while (!remote_queue.empty()) {
+        Event *event = remote_queue.front();
+        remote_queue.pop_front();
+        if (event->when() < getCurTick())
+            event->setWhen(getCurTick(), this);
+        if (DTRACE(Event))
+            event->trace("scheduled");
+        insert(event);
+    }
+
+    remotePending.store(false, std::memory_order_relaxed);
+}
@@ -36,6 +36,7 @@
 #define __SIM_EVENTQ_HH__
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <functional>
@@ -609,6 +610,12 @@ operator!=(const Event &l, const Event &r)
  * events must happen at least one simulation quantum into the future,
  * otherwise they risk being scheduled in the past by
  * handleAsyncInsertions().
+ *
+ * Events that cannot wait for the end of the quantum can instead be
+ * scheduled with scheduleRemote(). They are merged by the thread
+ * operating the queue before it services its next event, and serviced
+ * at their tick, or as soon as possible if the queue has already gone
+ * past it. This trades determinism and timing accuracy for latency.
  */
 class EventQueue
 {
@@ -623,6 +630,15 @@ class EventQueue
     //! List of events added by other threads to this event queue.
     std::list<Event*> async_queue;
 
+    //! Mutex to protect the remote queue.
+    std::mutex remote_queue_mutex;
+
+    //! List of events added by other threads with scheduleRemote().
+    std::list<Event*> remote_queue;
+
+    //! Whether remote_queue may hold events, checked without the lock.
+    std::atomic<bool> remotePending;
+
     /**
      * Lock protecting event handling.
      *
@@ -752,6 +768,14 @@ class EventQueue
      */
     void schedule(Event *event, Tick when, bool global = false);
 
+    /**
+     * Schedule the given event on this queue from a thread operating
+     * another queue, without waiting for the end of the simulation
+     * quantum. The event is serviced at the given tick, or at the
+     * current tick of this queue if it has already gone past it.
+     */
+    void scheduleRemote(Event *event, Tick when);
+
     /**
      * Deschedule the specified event. Should be called only from the owning
      * thread.
@@ -837,6 +861,12 @@ class EventQueue
      */
     void handleAsyncInsertions();
 
+    /**
+     * Function for moving events from the remote_queue to the main
+     * queue, done before servicing each event.
+     */
+    void handleRemoteInsertions();
+
     /**
      *  Function to signal that the event loop should be woken up because
      *  an event has been scheduled by an agent outside the gem5 event
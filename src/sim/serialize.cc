@@ -47,11 +47,13 @@
 #include <sys/types.h>
 
 #include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <list>
 #include <string>
 #include <vector>
 
+#include "base/binary_inifile.hh"
 #include "base/inifile.hh"
 #include "base/output.hh"
 #include "base/trace.hh"
@@ -181,23 +183,42 @@ Serializable::unserializeSection(CheckpointIn &cp, const char *name)
     unserialize(cp);
 }
 
+/**
+ * Write the globals and all the SimObjects to a checkpoint stream.
+ */
+static void
+serializeAllTo(CheckpointOut &cp)
+{
+    time_t t = time(NULL);
+    cp << "## checkpoint generated: " << ctime(&t);
+
+    globals.serializeSection(cp, "Globals");
+
+    SimObject::serializeAll(cp);
+}
+
 void
-Serializable::serializeAll(const string &cpt_dir)
+Serializable::serializeAll(const string &cpt_dir, bool binary)
 {
     string dir = CheckpointIn::setDir(cpt_dir);
     if (mkdir(dir.c_str(), 0775) == -1 && errno != EEXIST)
             fatal("couldn't mkdir %s\n", dir);
 
-    string cpt_file = dir + CheckpointIn::baseFilename;
-    ofstream outstream(cpt_file.c_str());
-    time_t t = time(NULL);
-    if (!outstream.is_open())
-        fatal("Unable to open file %s for writing\n", cpt_file.c_str());
-    outstream << "## checkpoint generated: " << ctime(&t);
-
-    globals.serializeSection(outstream, "Globals");
-
-    SimObject::serializeAll(outstream);
+    if (binary) {
+        string cpt_file = dir + CheckpointIn::binaryFilename;
+        BinaryIniWriter outstream(cpt_file);
+        if (!outstream.is_open())
+            fatal("Unable to open file %s for writing\n", cpt_file.c_str());
+        serializeAllTo(outstream);
+        if (!outstream.close())
+            fatal("Unable to write file %s\n", cpt_file.c_str());
+    } else {
+        string cpt_file = dir + CheckpointIn::baseFilename;
+        ofstream outstream(cpt_file.c_str());
+        if (!outstream.is_open())
+            fatal("Unable to open file %s for writing\n", cpt_file.c_str());
+        serializeAllTo(outstream);
+    }
 }
 
 void
@@ -244,6 +265,7 @@ Serializable::currentSection()
 }
 
 const char *CheckpointIn::baseFilename = "m5.cpt";
+const char *CheckpointIn::binaryFilename = "m5.cpt.bin";
 
 string CheckpointIn::currentDirectory;
 
@@ -266,9 +288,23 @@ CheckpointIn::dir()
 }
 
 CheckpointIn::CheckpointIn(const string &cpt_dir, SimObjectResolver &resolver)
-    : db(new IniFile), objNameResolver(resolver), _cptDir(setDir(cpt_dir))
+    : db(nullptr), binaryDb(nullptr), objNameResolver(resolver),
+      _cptDir(setDir(cpt_dir))
 {
+    // use the binary checkpoint if there is no text checkpoint, the
+    // sections of the binary checkpoint are loaded on demand
     string filename = getCptDir() + "/" + CheckpointIn::baseFilename;
+    string binary_filename = getCptDir() + "/" + CheckpointIn::binaryFilename;
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0 &&
+        stat(binary_filename.c_str(), &st) == 0) {
+        binaryDb = new BinaryIniFile;
+        if (!binaryDb->load(binary_filename))
+            fatal("Can't load checkpoint file '%s'\n", binary_filename);
+        return;
+    }
+
+    db = new IniFile;
     if (!db->load(filename)) {
         fatal("Can't load checkpoint file '%s'\n", filename);
     }
@@ -277,27 +313,39 @@ CheckpointIn::CheckpointIn(const string &cpt_dir, SimObjectResolver &resolver)
 CheckpointIn::~CheckpointIn()
 {
     delete db;
+    delete binaryDb;
 }
 
 bool
 CheckpointIn::entryExists(const string &section, const string &entry)
 {
+    if (binaryDb)
+        return binaryDb->entryExists(section, entry);
     return db->entryExists(section, entry);
 }
 
 bool
 CheckpointIn::find(const string &section, const string &entry, string &value)
 {
+    if (binaryDb)
+        return binaryDb->find(section, entry, value);
     return db->find(section, entry, value);
 }
 
+bool
+CheckpointIn::findRaw(const string &section, const string &entry,
+                      string &value)
+{
+    return binaryDb && binaryDb->findRaw(section, entry, value);
+}
+
 bool
 CheckpointIn::findObj(const string &section, const string &entry,
                     SimObject *&value)
 {
     string path;
 
-    if (!db->find(section, entry, path))
+    if (!find(section, entry, path))
         return false;
 
     value = objNameResolver.resolveSimObject(path);
@@ -307,9 +355,44 @@ CheckpointIn::findObj(const string &section, const string &entry,
 bool
 CheckpointIn::sectionExists(const string &section)
 {
+    if (binaryDb)
+        return binaryDb->sectionExists(section);
     return db->sectionExists(section);
 }
 
+bool
+rawArrayParamOut(CheckpointOut &os, const string &name, char kind,
+                 const void *data, unsigned elem_size, uint64_t count)
+{
+    BinaryIniWriter *writer = dynamic_cast<BinaryIniWriter *>(&os);
+    if (!writer)
+        return false;
+
+    writer->addRaw(name, (BinaryIni::RawKind)kind, data, elem_size, count);
+    return true;
+}
+
+bool
+rawArrayParamIn(CheckpointIn &cp, const string &name, char kind,
+                unsigned elem_size, string &data)
+{
+    const string &section(Serializable::currentSection());
+    string raw;
+    if (!cp.findRaw(section, name, raw))
+        return false;
+
+    // arrays stored with another type are converted through text
+    BinaryIni::RawHeader header;
+    if (raw.size() < sizeof(header))
+        return false;
+    memcpy(&header, raw.data(), sizeof(header));
+    if (header.kind != kind || header.elemSize != elem_size)
+        return false;
+
+    data.assign(raw, sizeof(header), string::npos);
+    return true;
+}
+
 void
 objParamIn(CheckpointIn &cp, const string &name, SimObject * &param)
 {
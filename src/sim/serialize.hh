@@ -52,12 +52,14 @@
 #include <map>
 #include <stack>
 #include <set>
+#include <type_traits>
 #include <vector>
 
 #include "base/bitunion.hh"
 #include "base/logging.hh"
 #include "base/str.hh"
 
+class BinaryIniFile;
 class IniFile;
 class SimObject;
 class SimObjectResolver;
@@ -70,6 +72,9 @@ class CheckpointIn
 
     IniFile *db;
 
+    /** Binary checkpoint, used instead of db if present. */
+    BinaryIniFile *binaryDb;
+
     SimObjectResolver &objNameResolver;
 
     const std::string _cptDir;
@@ -94,6 +99,16 @@ class CheckpointIn
     bool sectionExists(const std::string &section);
     /** @}*/ //end of api_checkout group
 
+    /**
+     * Find an array of numbers stored as a raw entry in a binary
+     * checkpoint. The value is the raw entry, starting with its
+     * BinaryIni::RawHeader.
+     *
+     * @return True if the entry exists and is a raw entry.
+     */
+    bool findRaw(const std::string &section, const std::string &entry,
+                 std::string &value);
+
     // The following static functions have to do with checkpoint
     // creation rather than restoration.  This class makes a handy
     // namespace for them though.  Currently no Checkpoint object is
@@ -131,6 +146,9 @@ class CheckpointIn
 
     // Filename for base checkpoint file within directory.
     static const char *baseFilename;
+
+    // Filename for binary base checkpoint file within directory.
+    static const char *binaryFilename;
 };
 
 /**
@@ -297,9 +315,15 @@ class Serializable
     static const std::string &currentSection();
 
     /**
+     * Serialize all the objects in the simulator into a checkpoint
+     *
+     * @param cpt_dir The directory of the checkpoint
+     * @param binary Write the binary rather than the text format
+     *
      * @ingroup api_serialize
      */
-    static void serializeAll(const std::string &cpt_dir);
+    static void serializeAll(const std::string &cpt_dir,
+                             bool binary = false);
 
     /**
      * @ingroup api_serialize
@@ -491,6 +515,127 @@ optParamIn(CheckpointIn &cp, const std::string &name,
     }
 }
 
+/**
+ * Arrays of plain numbers can be stored in binary checkpoints without
+ * being formatted as text.
+ */
+template <class T>
+struct RawArrayParam
+{
+    static const bool value = std::is_arithmetic<T>::value &&
+        !std::is_same<T, bool>::value;
+
+    /** The BinaryIni::RawKind of the elements. */
+    static char
+    kind()
+    {
+        return std::is_floating_point<T>::value ? 'f' :
+            std::is_signed<T>::value ? 'i' : 'u';
+    }
+};
+
+/**
+ * Store an array of numbers as a raw entry if the checkpoint is
+ * written in the binary format.
+ *
+ * @return True if the array was stored, false if it has to be
+ * written as text.
+ */
+bool rawArrayParamOut(CheckpointOut &os, const std::string &name, char kind,
+                      const void *data, unsigned elem_size, uint64_t count);
+
+/**
+ * Find an array of numbers stored as a raw entry, if its elements are
+ * of the given kind and size.
+ *
+ * @param data The elements of the array
+ * @return True if found, false if the array has to be read as text.
+ */
+bool rawArrayParamIn(CheckpointIn &cp, const std::string &name, char kind,
+                     unsigned elem_size, std::string &data);
+
+template <class T>
+typename std::enable_if<RawArrayParam<T>::value, bool>::type
+rawArrayOut(CheckpointOut &os, const std::string &name, const T *param,
+            uint64_t size)
+{
+    return rawArrayParamOut(os, name, RawArrayParam<T>::kind(), param,
+                            sizeof(T), size);
+}
+
+template <class T>
+typename std::enable_if<!RawArrayParam<T>::value, bool>::type
+rawArrayOut(CheckpointOut &os, const std::string &name, const T *param,
+            uint64_t size)
+{
+    return false;
+}
+
+template <class T>
+typename std::enable_if<RawArrayParam<T>::value, bool>::type
+rawArrayOut(CheckpointOut &os, const std::string &name,
+            const std::vector<T> &param)
+{
+    return rawArrayOut(os, name, param.data(), param.size());
+}
+
+template <class T>
+typename std::enable_if<!RawArrayParam<T>::value, bool>::type
+rawArrayOut(CheckpointOut &os, const std::string &name,
+            const std::vector<T> &param)
+{
+    return false;
+}
+
+template <class T>
+typename std::enable_if<RawArrayParam<T>::value, bool>::type
+rawArrayIn(CheckpointIn &cp, const std::string &name, T *param,
+           uint64_t size)
+{
+    std::string data;
+    if (!rawArrayParamIn(cp, name, RawArrayParam<T>::kind(), sizeof(T),
+                         data)) {
+        return false;
+    }
+
+    fatal_if(data.size() != size * sizeof(T),
+             "Array size mismatch on %s:%s (Got %u, expected %u)'\n",
+             Serializable::currentSection(), name, data.size() / sizeof(T),
+             size);
+    std::copy(data.begin(), data.end(), (char *)param);
+    return true;
+}
+
+template <class T>
+typename std::enable_if<!RawArrayParam<T>::value, bool>::type
+rawArrayIn(CheckpointIn &cp, const std::string &name, T *param,
+           uint64_t size)
+{
+    return false;
+}
+
+template <class T>
+typename std::enable_if<RawArrayParam<T>::value, bool>::type
+rawArrayIn(CheckpointIn &cp, const std::string &name, std::vector<T> &param)
+{
+    std::string data;
+    if (!rawArrayParamIn(cp, name, RawArrayParam<T>::kind(), sizeof(T),
+                         data)) {
+        return false;
+    }
+
+    param.resize(data.size() / sizeof(T));
+    std::copy(data.begin(), data.end(), (char *)param.data());
+    return true;
+}
+
+template <class T>
+typename std::enable_if<!RawArrayParam<T>::value, bool>::type
+rawArrayIn(CheckpointIn &cp, const std::string &name, std::vector<T> &param)
+{
+    return false;
+}
+
 /**
  * @ingroup api_serialize
  */
@@ -499,6 +644,9 @@ void
 arrayParamOut(CheckpointOut &os, const std::string &name,
               const std::vector<T> &param)
 {
+    if (rawArrayOut(os, name, param))
+        return;
+
     typename std::vector<T>::size_type size = param.size();
     os << name << "=";
     if (size > 0)
@@ -562,6 +710,9 @@ void
 arrayParamOut(CheckpointOut &os, const std::string &name,
               const T *param, unsigned size)
 {
+    if (rawArrayOut(os, name, param, size))
+        return;
+
     os << name << "=";
     if (size > 0)
         showParam(os, param[0]);
@@ -590,6 +741,9 @@ arrayParamIn(CheckpointIn &cp, const std::string &name,
 {
     const std::string &section(Serializable::currentSection());
     std::string str;
+    if (rawArrayIn(cp, name, param, size))
+        return;
+
     if (!cp.find(section, name, str)) {
         fatal("Can't unserialize '%s:%s'\n", section, name);
     }
@@ -637,6 +791,9 @@ arrayParamIn(CheckpointIn &cp, const std::string &name, std::vector<T> &param)
 {
     const std::string &section(Serializable::currentSection());
     std::string str;
+    if (rawArrayIn(cp, name, param))
+        return;
+
     if (!cp.find(section, name, str)) {
         fatal("Can't unserialize '%s:%s'\n", section, name);
     }
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sim/stat_server.hh"
+
+#include <fnmatch.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <sstream>
+
+#include "base/atomicio.hh"
+#include "base/cprintf.hh"
+#include "base/logging.hh"
+#include "base/statistics.hh"
+#include "base/stats/text.hh"
+#include "base/str.hh"
+#include "sim/core.hh"
+#include "sim/root.hh"
+
+namespace Stats {
+
+/** Longest request accepted from a client. */
+static const size_t maxRequestSize = 64 * 1024;
+
+StatServer::ListenEvent::ListenEvent(StatServer *s, int fd, int e)
+    : PollEvent(fd, e), server(s)
+{
+}
+
+void
+StatServer::ListenEvent::process(int revent)
+{
+    server->accept();
+}
+
+StatServer::DataEvent::DataEvent(StatServer *s, int fd, int e)
+    : PollEvent(fd, e), server(s)
+{
+}
+
+void
+StatServer::DataEvent::process(int revent)
+{
+    if (revent & POLLIN)
+        server->data(this);
+    else if (revent & (POLLHUP | POLLERR | POLLNVAL))
+        server->detach(this);
+}
+
+StatServer::StatServer(int port)
+{
+    while (!listener.listen(port, true))
+        port++;
+
+    inform("Stat server listening for connections on port %d\n", port);
+
+    listenEvent.reset(new ListenEvent(this, listener.getfd(), POLLIN));
+    pollQueue.schedule(listenEvent.get());
+}
+
+StatServer::~StatServer()
+{
+    while (!clients.empty())
+        detach(clients.back().get());
+}
+
+void
+StatServer::accept()
+{
+    int fd = listener.accept(true);
+    if (fd < 0)
+        return;
+
+    clients.emplace_back(new DataEvent(this, fd, POLLIN));
+    pollQueue.schedule(clients.back().get());
+}
+
+void
+StatServer::detach(DataEvent *client)
+{
+    for (auto it = clients.begin(); it != clients.end(); ++it) {
+        if (it->get() == client) {
+            int fd = client->getfd();
+            // the destructor removes the event from the poll queue
+            clients.erase(it);
+            ::close(fd);
+            return;
+        }
+    }
+}
+
+void
+StatServer::data(DataEvent *client)
+{
+    char buf[1024];
+    ssize_t len;
+    do {
+        len = ::read(client->getfd(), buf, sizeof(buf));
+    } while (len == -1 && errno == EINTR);
+
+    if (len <= 0) {
+        detach(client);
+        return;
+    }
+
+    std::string &input = client->input;
+    input.append(buf, len);
+
+    std::string::size_type eol;
+    while ((eol = input.find('\n')) != std::string::npos) {
+        std::string response = handle(input.substr(0, eol));
+        input.erase(0, eol + 1);
+        response += "\n";
+        if (atomic_write(client->getfd(), response.data(),
+                         response.size()) < 0) {
+            detach(client);
+            return;
+        }
+    }
+
+    if (input.size() > maxRequestSize) {
+        static const char error[] = "error: request too long\n\n";
+        atomic_write(client->getfd(), error, sizeof(error) - 1);
+        detach(client);
+    }
+}
+
+void
+StatServer::buildIndex()
+{
+    // old style stats have their full name
+    for (auto *info : statsList())
+        index[info->name] = Entry{info, ""};
+
+    // stats of groups are named relative to their group
+    std::vector<std::pair<std::string, const Group *>> groups;
+    groups.emplace_back("", Root::root());
+    while (!groups.empty()) {
+        std::string prefix = groups.back().first;
+        const Group *group = groups.back().second;
+        groups.pop_back();
+
+        for (auto *info : group->getStats()) {
+            index[prefix.empty() ? info->name : prefix + "." + info->name] =
+                Entry{info, prefix};
+        }
+        for (const auto &child : group->getStatGroups()) {
+            groups.emplace_back(prefix.empty() ? child.first :
+                                prefix + "." + child.first, child.second);
+        }
+    }
+}
+
+std::string
+StatServer::handle(const std::string &request)
+{
+    std::vector<std::string> args;
+    tokenize(args, request, ' ');
+    if (args.empty())
+        return "error: empty request\n";
+
+    const std::string &cmd = args[0];
+    std::vector<std::string> patterns(args.begin() + 1, args.end());
+
+    if (cmd == "tick")
+        return csprintf("%d\n", curTick());
+
+    if (cmd != "get" && cmd != "list")
+        return csprintf("error: unknown request '%s'\n", cmd);
+
+    if (!enabled())
+        return "error: stats are not enabled yet\n";
+
+    if (index.empty())
+        buildIndex();
+
+    if (cmd == "get" && patterns.empty())
+        return "error: no stats requested\n";
+
+    std::ostringstream os;
+    Text text(os);
+    for (const auto &stat : index) {
+        bool match = patterns.empty();
+        for (const auto &pattern : patterns) {
+            if (fnmatch(pattern.c_str(), stat.first.c_str(), 0) == 0) {
+                match = true;
+                break;
+            }
+        }
+        if (!match)
+            continue;
+
+        if (cmd == "list") {
+            os << stat.first << "\n";
+            continue;
+        }
+
+        // Only the requested stats are brought up to date. Preparing
+        // a stat does not change the values it will have in the next
+        // dump.
+        Info *info = stat.second.info;
+        info->prepare();
+        if (!stat.second.group.empty())
+            text.beginGroup(stat.second.group.c_str());
+        info->visit(text);
+        if (!stat.second.group.empty())
+            text.endGroup();
+    }
+
+    return os.str();
+}
+
+void
+startServer(int port)
+{
+    static std::unique_ptr<StatServer> server;
+
+    if (ListenSocket::allDisabled()) {
+        warn("Sockets disabled, not starting the stat server.\n");
+        return;
+    }
+
+    if (server) {
+        warn("The stat server is already running.\n");
+        return;
+    }
+
+    server.reset(new StatServer(port));
+}
+
+} // namespace Stats
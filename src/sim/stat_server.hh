@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SIM_STAT_SERVER_HH__
+#define __SIM_STAT_SERVER_HH__
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/pollevent.hh"
+#include "base/socket.hh"
+
+namespace Stats {
+
+class Info;
+
+/**
+ * Server answering queries for the current values of stats over a
+ * socket, without dumping or resetting them.
+ *
+ * Clients send requests as lines of text, and each response ends
+ * with an empty line. The requests are:
+ *
+ *   get PATTERN...   The values of the stats matching the patterns,
+ *                    in the format of stats.txt.
+ *   list [PATTERN...] The names of the stats matching the patterns,
+ *                    or of all stats.
+ *   tick             The current tick.
+ *
+ * Patterns are full stat names, which can contain shell wildcards
+ * (e.g., "system.cpu*.numCycles"). Errors are reported as a line
+ * starting with "error:".
+ *
+ * Requests are served from the poll queue, between events, and only
+ * the requested stats are computed.
+ */
+class StatServer
+{
+  protected:
+    class ListenEvent : public PollEvent
+    {
+      protected:
+        StatServer *server;
+
+      public:
+        ListenEvent(StatServer *s, int fd, int e);
+        void process(int revent) override;
+    };
+
+    class DataEvent : public PollEvent
+    {
+      protected:
+        StatServer *server;
+
+      public:
+        /** Data received from the client but not processed yet. */
+        std::string input;
+
+        DataEvent(StatServer *s, int fd, int e);
+        void process(int revent) override;
+        int getfd() const { return pfd.fd; }
+    };
+
+    ListenSocket listener;
+    std::unique_ptr<ListenEvent> listenEvent;
+    std::vector<std::unique_ptr<DataEvent>> clients;
+
+    /** A stat, and the name of the group containing it. */
+    struct Entry
+    {
+        Info *info;
+        std::string group;
+    };
+
+    /** All the stats, indexed by their full name. */
+    std::map<std::string, Entry> index;
+
+    /** Build the index of the stats, once they are enabled. */
+    void buildIndex();
+
+    void accept();
+    void data(DataEvent *client);
+    void detach(DataEvent *client);
+
+    /** Handle a request, and return the response. */
+    std::string handle(const std::string &request);
+
+  public:
+    /** Listen on the given port, or the next free one. */
+    StatServer(int port);
+    ~StatServer();
+};
+
+/**
+ * Start the stat server.
+ *
+ * @param port The port to listen on, or the first one to try.
+ */
+void startServer(int port);
+
+} // namespace Stats
+
+#endif // __SIM_STAT_SERVER_HH__
@@ -94,7 +94,10 @@ System::System(Params *p)
 #else
       kvmVM(nullptr),
 #endif
-      physmem(name() + ".physmem", p->memories, p->mmap_using_noreserve),
+      physmem(name() + ".physmem", p->memories, p->mmap_using_noreserve,
+              p->mmap_huge_pages, p->eventq_numa_nodes,
+              p->memory_checkpoint_format, p->memory_checkpoint_threads,
+              p->memory_checkpoint_incremental),
       memoryMode(p->mem_mode),
       _cacheLineSize(p->cache_line_size),
       workItemsBegin(0),
@@ -101,6 +101,7 @@ struct StatTest
     Histogram h11;
     Histogram h12;
     SparseHistogram sh1;
+    HdrHistogram hd1;
 
     Vector s19;
     Vector s20;
@@ -332,6 +333,12 @@ StatTest::init()
         .desc("this is sparse histogram 1")
         ;
 
+    hd1
+        .init(1000000, 4)
+        .name("HdrHistogram1")
+        .desc("this is HDR histogram 1")
+        ;
+
     f1
         .name("Formula1")
         .desc("this is formula 1")
@@ -663,6 +670,10 @@ StatTest::run()
         sh1.sample(random() % 10000);
     }
 
+    for (int i = -10; i < 1000; i++) {
+        hd1.sample(i < 0 ? i : i * i);
+    }
+
     s19[0] = 1;
     s19[1] = 100000;
     s20[0] = 100000;
@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This script measures the effect of --bp-warming on the branch
+# predictor of the detailed CPU right after it is switched in. It runs
+# a configuration using configs/common/Simulation.py twice per window
+# of N instructions, with and without --bp-warming, and reports the
+# conditional branch mispredictions of the switched-in CPUs in their
+# first N instructions. As the stats are reset when switching after
+# --fast-forward, these are the mispredictions a cold predictor adds
+# to the detailed simulation. For example:
+#
+#   bp_warming_compare.py -w 10000,100000,1000000 \
+#       build/X86/gem5.opt configs/example/se.py -- \
+#       --cpu-type=DerivO3CPU --caches --fast-forward=100000000 -c bench
+#
+# The options after '--' are passed to the configuration for every run.
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+pred_stat_re = re.compile(r'switch_cpus\d*\.branchPred\.(\w+)$')
+
+def read_pred_stats(path):
+    """Sum the branch predictor stats of all the switched-in CPUs over
+    the first stats dump of a run."""
+    stats = {}
+    stat_re = re.compile(r'^(\S+)\s+([-+0-9.eE]+|nan|inf)\s')
+    with open(path) as f:
+        for line in f:
+            if line.startswith('---------- End Simulation Statistics'):
+                break
+            m = stat_re.match(line)
+            if not m:
+                continue
+            pred = pred_stat_re.search(m.group(1))
+            if pred:
+                name = pred.group(1)
+                stats[name] = stats.get(name, 0.0) + float(m.group(2))
+    return stats
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare the branch mispredictions after switching "
+        "CPUs with and without --bp-warming.")
+    parser.add_argument("gem5", help="gem5 binary")
+    parser.add_argument("config", help="Configuration script")
+    parser.add_argument("config_options", nargs="*",
+                        help="Options passed to the configuration script")
+    parser.add_argument("-w", "--windows", default="100000",
+                        help="Comma separated numbers of instructions to "
+                        "simulate after switching [default: %(default)s]")
+    parser.add_argument("-o", "--outdir", default="bp_warming",
+                        help="Directory of the output directories of the "
+                        "runs [default: %(default)s]")
+    args = parser.parse_args()
+
+    if not any(o.startswith('--fast-forward') for o in args.config_options):
+        sys.exit("Error: --fast-forward is needed for the stats to only "
+                 "cover the detailed CPU")
+
+    results = []
+    for window in [ int(w) for w in args.windows.split(',') ]:
+        misses = []
+        for warming in (False, True):
+            outdir = os.path.join(args.outdir, '%s%d' %
+                                  ('warm' if warming else 'cold', window))
+            cmd = [ args.gem5, '--outdir=%s' % outdir, args.config ] + \
+                args.config_options + [ '--maxinsts=%d' % window ]
+            if warming:
+                cmd.append('--bp-warming')
+            print("Running", " ".join(cmd))
+            with open(os.devnull, 'w') as devnull:
+                status = subprocess.call(cmd, stdout=devnull)
+            if status != 0:
+                sys.exit("Error: the run in %s failed" % outdir)
+
+            stats = read_pred_stats(os.path.join(outdir, 'stats.txt'))
+            if 'condIncorrect' not in stats:
+                sys.exit("Error: no branch predictor stats of switched-in "
+                         "CPUs in %s" % outdir)
+            misses.append((stats['condPredicted'], stats['condIncorrect']))
+        results.append((window, misses[0], misses[1]))
+
+    print()
+    print("%12s %14s %14s %14s %14s %10s" % ("window", "cold branches",
+                                             "cold misses", "warm branches",
+                                             "warm misses", "saved"))
+    for window, (cold_br, cold_miss), (warm_br, warm_miss) in results:
+        print("%12d %14d %14d %14d %14d %10d" %
+              (window, cold_br, cold_miss, warm_br, warm_miss,
+               cold_miss - warm_miss))
+
+if __name__ == "__main__":
+    main()
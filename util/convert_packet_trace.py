@@ -0,0 +1,244 @@
+#!/usr/bin/env python2.7
+#
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This script converts memory packet traces between the protobuf
+# format and the binary packet trace format described in
+# src/mem/packet_trace.hh. The direction is chosen based on the
+# format of the input, for example:
+#
+#   convert_packet_trace.py system.monitor.trc.gz system.monitor.bpt
+#   convert_packet_trace.py --compress system.monitor.trc.gz out.bpt
+#   convert_packet_trace.py system.monitor.bpt system.monitor.trc.gz
+#
+# Protobuf output is compressed if its name ends with .gz, and binary
+# output is compressed one block at a time with --compress.
+
+from __future__ import print_function
+
+import argparse
+import gzip
+import os
+import struct
+import subprocess
+import sys
+import zlib
+
+import protolib
+
+util_dir = os.path.dirname(os.path.realpath(__file__))
+# Make sure the proto definitions are up to date.
+subprocess.check_call(['make', '--quiet', '-C', util_dir, 'packet_pb2.py'])
+import packet_pb2
+
+# Layout of the binary format, see src/mem/packet_trace.hh
+MAGIC = b'gem5pktb'
+VERSION = 1
+COMPRESSED_FLAG = 0x1
+FILE_HEADER = struct.Struct('=8sIIQII')
+RECORD = struct.Struct('=QQIIIHH')
+BLOCK_INFO = struct.Struct('=QQII')
+FOOTER = struct.Struct('=QQ8s')
+MAX_TICK_DELTA = 2**32 - 1
+
+def read_string(f):
+    size, = struct.unpack('=I', f.read(4))
+    return f.read(size).decode('utf-8')
+
+def write_string(f, s):
+    data = s.encode('utf-8')
+    f.write(struct.pack('=I', len(data)))
+    f.write(data)
+
+def read_binary(path):
+    """Read a binary trace, returning its header and a packet iterator.
+
+    The header is a (tick frequency, object id, {master id: name})
+    tuple, and every packet is a (tick, cmd, addr, size, flags, pc,
+    master) tuple.
+    """
+    f = open(path, 'rb')
+    magic, version, flags, tick_freq, records_per_block, num_masters = \
+        FILE_HEADER.unpack(f.read(FILE_HEADER.size))
+    if magic != MAGIC or version != VERSION:
+        sys.exit("%s is not a supported binary packet trace" % path)
+
+    obj_id = read_string(f)
+    masters = {}
+    for i in range(num_masters):
+        key, = struct.unpack('=I', f.read(4))
+        masters[key] = read_string(f)
+
+    f.seek(-FOOTER.size, os.SEEK_END)
+    index_offset, num_blocks, magic = FOOTER.unpack(f.read(FOOTER.size))
+    if magic != MAGIC:
+        sys.exit("Binary packet trace %s is truncated" % path)
+    f.seek(index_offset)
+    index = [ BLOCK_INFO.unpack(f.read(BLOCK_INFO.size))
+              for i in range(num_blocks) ]
+
+    def packets():
+        for offset, first_tick, num_records, stored_size in index:
+            f.seek(offset)
+            data = f.read(stored_size)
+            if flags & COMPRESSED_FLAG:
+                data = zlib.decompress(data)
+            for i in range(num_records):
+                addr, pc, tick_delta, pkt_flags, size, cmd, master = \
+                    RECORD.unpack_from(data, i * RECORD.size)
+                yield (first_tick + tick_delta, cmd, addr, size, pkt_flags,
+                       pc, master)
+
+    return (tick_freq, obj_id, masters), packets()
+
+def write_binary(path, header, packets, compress, records_per_block=4096):
+    """Write a binary trace from a header and packets as returned by
+    read_binary()."""
+    tick_freq, obj_id, masters = header
+    f = open(path, 'wb')
+    f.write(FILE_HEADER.pack(MAGIC, VERSION,
+                             COMPRESSED_FLAG if compress else 0,
+                             tick_freq, records_per_block, len(masters)))
+    write_string(f, obj_id)
+    for key in sorted(masters):
+        f.write(struct.pack('=I', key))
+        write_string(f, masters[key])
+
+    index = []
+    records = []
+    first_tick = [0]
+
+    def write_block():
+        data = b''.join(records)
+        if compress:
+            data = zlib.compress(data)
+        index.append((f.tell(), first_tick[0], len(records), len(data)))
+        f.write(data)
+        del records[:]
+
+    for tick, cmd, addr, size, flags, pc, master in packets:
+        # A block ends early if the tick does not fit in the record
+        if records and (len(records) == records_per_block or
+                        tick < first_tick[0] or
+                        tick - first_tick[0] > MAX_TICK_DELTA):
+            write_block()
+        if not records:
+            first_tick[0] = tick
+        records.append(RECORD.pack(addr, pc, tick - first_tick[0], flags,
+                                   size, cmd, master))
+    if records:
+        write_block()
+
+    index_offset = f.tell()
+    for info in index:
+        f.write(BLOCK_INFO.pack(*info))
+    f.write(FOOTER.pack(index_offset, len(index), MAGIC))
+    f.close()
+
+def read_proto(path):
+    """Read a protobuf trace, returning the same as read_binary()."""
+    proto_in = protolib.openFileRd(path)
+    if proto_in.read(4) != b'gem5':
+        sys.exit("%s is not a protobuf packet trace" % path)
+
+    header = packet_pb2.PacketHeader()
+    protolib.decodeMessage(proto_in, header)
+    masters = dict((id_string.key, id_string.value)
+                   for id_string in header.id_strings)
+
+    def packets():
+        packet = packet_pb2.Packet()
+        while protolib.decodeMessage(proto_in, packet):
+            yield (packet.tick, packet.cmd, packet.addr, packet.size,
+                   packet.flags if packet.HasField('flags') else 0,
+                   packet.pc if packet.HasField('pc') else 0,
+                   packet.pkt_id if packet.HasField('pkt_id') else 0)
+
+    return (header.tick_freq, header.obj_id, masters), packets()
+
+def write_proto(path, header, packets):
+    """Write a protobuf trace from a header and packets as returned by
+    read_binary()."""
+    tick_freq, obj_id, masters = header
+    if path.endswith('.gz'):
+        proto_out = gzip.open(path, 'wb')
+    else:
+        proto_out = open(path, 'wb')
+
+    # Write the magic number in 4-byte Little Endian, similar to what
+    # is done in src/proto/protoio.cc
+    proto_out.write(b'gem5')
+
+    header_msg = packet_pb2.PacketHeader()
+    header_msg.obj_id = obj_id
+    header_msg.tick_freq = tick_freq
+    for key in sorted(masters):
+        id_string = header_msg.id_strings.add()
+        id_string.key = key
+        id_string.value = masters[key]
+    protolib.encodeMessage(proto_out, header_msg)
+
+    for tick, cmd, addr, size, flags, pc, master in packets:
+        packet = packet_pb2.Packet()
+        packet.tick = tick
+        packet.cmd = cmd
+        packet.addr = addr
+        packet.size = size
+        packet.flags = flags
+        if pc != 0:
+            packet.pc = pc
+        packet.pkt_id = master
+        protolib.encodeMessage(proto_out, packet)
+    proto_out.close()
+
+def is_binary(path):
+    with open(path, 'rb') as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Convert memory packet traces between the protobuf "
+        "and the binary packet trace formats.")
+    parser.add_argument("input", help="Trace to convert")
+    parser.add_argument("output", help="Converted trace")
+    parser.add_argument("--compress", action="store_true",
+                        help="Compress the blocks of a binary output")
+    parser.add_argument("--records-per-block", type=int, default=4096,
+                        help="Maximum number of packets of a block of a "
+                        "binary output [default: %(default)s]")
+    args = parser.parse_args()
+
+    if is_binary(args.input):
+        header, packets = read_binary(args.input)
+        write_proto(args.output, header, packets)
+    else:
+        header, packets = read_proto(args.input)
+        write_binary(args.output, header, packets, args.compress,
+                     args.records_per_block)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,195 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This script converts the description of a checkpoint between the
+# text format (m5.cpt) and the binary, indexed format (m5.cpt.bin)
+# written by m5.checkpoint(dir, binary=True). The other files of the
+# checkpoint, such as the memory stores, are shared by both formats
+# and are left untouched.
+#
+# As gem5 prefers the text file when both are present, the file that
+# was converted is renamed with a ".orig" suffix unless --keep is
+# given.
+
+from __future__ import print_function
+
+import argparse
+import os
+import struct
+import sys
+
+text_name = 'm5.cpt'
+binary_name = 'm5.cpt.bin'
+
+magic = b'gem5cptb'
+version = 1
+
+# Entry types, see src/base/binary_inifile.hh
+TEXT, RAW, TEXT_APPEND = 0, 1, 2
+
+# Header of the file: magic, version, index offset, number of sections
+file_header = struct.Struct('=8sQQQ')
+
+raw_formats = {
+    (b'i', 1): 'b', (b'i', 2): 'h', (b'i', 4): 'i', (b'i', 8): 'q',
+    (b'u', 1): 'B', (b'u', 2): 'H', (b'u', 4): 'I', (b'u', 8): 'Q',
+    (b'f', 4): 'f', (b'f', 8): 'd',
+}
+
+def pack_string(s):
+    s = s.encode('utf-8')
+    return struct.pack('=I', len(s)) + s
+
+def raw_to_text(value):
+    kind, elem_size = value[0:1], struct.unpack('=B', value[1:2])[0]
+    fmt = raw_formats.get((kind, elem_size))
+    data = value[2:]
+    if fmt is None or len(data) % elem_size:
+        raise ValueError('malformed raw entry')
+    elems = struct.unpack('=%d%s' % (len(data) // elem_size, fmt), data)
+    if kind == b'f':
+        return ' '.join(repr(float(e)) for e in elems)
+    return ' '.join(str(e) for e in elems)
+
+def read_text(path):
+    """Read a text checkpoint as a list of (section, entries) pairs,
+    where entries is a list of (name, type, value) tuples."""
+    sections = []
+    entries = None
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith('[') and line.endswith(']'):
+                entries = []
+                sections.append((line[1:-1].strip(), entries))
+                continue
+            offset = line.find('=')
+            if entries is None or offset <= 0:
+                continue
+            if line[offset - 1] == '+':
+                name, type = line[:offset - 1], TEXT_APPEND
+            else:
+                name, type = line[:offset], TEXT
+            entries.append((name.strip(), type, line[offset + 1:].strip()))
+    return sections
+
+def write_binary(path, sections):
+    with open(path, 'wb') as f:
+        f.write(file_header.pack(magic, 0, 0, 0))
+        index = []
+        for name, entries in sections:
+            data = b''.join(pack_string(entry) + struct.pack('=BQ',
+                type, len(value.encode('utf-8'))) + value.encode('utf-8')
+                for entry, type, value in entries)
+            index.append((name, f.tell(), len(data)))
+            f.write(data)
+        index_offset = f.tell()
+        for name, offset, size in index:
+            f.write(pack_string(name) + struct.pack('=QQ', offset, size))
+        f.seek(0)
+        f.write(file_header.pack(magic, version, index_offset, len(index)))
+
+def read_binary(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) < file_header.size:
+        raise ValueError('%s is too short' % path)
+    cpt_magic, cpt_version, index_offset, num_sections = \
+        file_header.unpack_from(data)
+    if cpt_magic != magic or cpt_version != version:
+        raise ValueError('%s is not a binary checkpoint' % path)
+
+    def read_string(pos):
+        size, = struct.unpack_from('=I', data, pos)
+        pos += 4
+        return data[pos:pos + size].decode('utf-8'), pos + size
+
+    sections = []
+    pos = index_offset
+    for i in range(num_sections):
+        name, pos = read_string(pos)
+        offset, size = struct.unpack_from('=QQ', data, pos)
+        pos += 16
+        entries = []
+        entry_pos = offset
+        while entry_pos < offset + size:
+            entry, entry_pos = read_string(entry_pos)
+            type, value_size = struct.unpack_from('=BQ', data, entry_pos)
+            entry_pos += 9
+            value = data[entry_pos:entry_pos + value_size]
+            entry_pos += value_size
+            if type == RAW:
+                entries.append((entry, TEXT, raw_to_text(value)))
+            else:
+                entries.append((entry, type, value.decode('utf-8')))
+        sections.append((name, entries))
+    return sections
+
+def write_text(path, sections):
+    with open(path, 'w') as f:
+        f.write('## checkpoint converted from %s\n' % binary_name)
+        for name, entries in sections:
+            f.write('\n[%s]\n' % name)
+            for entry, type, value in entries:
+                op = '+=' if type == TEXT_APPEND else '='
+                f.write('%s%s%s\n' % (entry, op, value))
+
+def convert(cpt_dir, to_binary, keep):
+    if to_binary:
+        src = os.path.join(cpt_dir, text_name)
+        dst = os.path.join(cpt_dir, binary_name)
+        write_binary(dst, read_text(src))
+    else:
+        src = os.path.join(cpt_dir, binary_name)
+        dst = os.path.join(cpt_dir, text_name)
+        write_text(dst, read_binary(src))
+    if not keep:
+        os.rename(src, src + '.orig')
+    print('Converted %s to %s' % (src, dst))
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description='Convert a checkpoint between the text and binary '
+                    'formats')
+    parser.add_argument('checkpoint', help='checkpoint directory')
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument('--to-binary', action='store_true',
+                       help='convert %s to %s' % (text_name, binary_name))
+    group.add_argument('--to-text', action='store_true',
+                       help='convert %s to %s' % (binary_name, text_name))
+    parser.add_argument('--keep', action='store_true',
+                        help='keep the original file as is')
+    args = parser.parse_args()
+
+    try:
+        convert(args.checkpoint, args.to_binary, args.keep)
+    except (IOError, OSError, ValueError, struct.error) as e:
+        print('Error: %s' % e, file=sys.stderr)
+        sys.exit(1)
@@ -72,6 +72,7 @@ from __future__ import print_function
 
 from six.moves import configparser
 import glob, types, sys, os
+import gzip, struct, zlib
 import os.path as osp
 
 verbose_print = False
@@ -183,6 +184,147 @@ class Upgrader:
                           "nonexistent tag '{}'".format(tag, dep))
                     sys.exit(1)
 
+# Layout of the chunked memory store files written by PhysicalMemory,
+# see src/mem/physical.cc
+chunked_store_magic = b'gem5pmem'
+chunked_store_version = 2
+chunked_store_chunk_size = 1 << 20
+chunked_store_in_base = (1 << 64) - 1
+chunked_store_header_v1 = struct.Struct('<8sQQQQ')
+chunked_store_header = struct.Struct('<8sQQQQQ')
+chunked_store_entry = struct.Struct('<QQ')
+
+def read_chunked_store(path, size):
+    """Generate the chunks of a chunked memory store file, following
+    the chain of base stores of incremental checkpoints"""
+    with open(path, 'rb') as f:
+        magic, version, range_size, chunk_size, num_chunks = \
+            chunked_store_header_v1.unpack(
+                f.read(chunked_store_header_v1.size))
+        if magic != chunked_store_magic or \
+           version > chunked_store_version or range_size != size:
+            raise IOError("%s is not a valid chunked store" % path)
+
+        base = None
+        if version > 1:
+            base_name_size, = struct.unpack('<Q', f.read(8))
+            if base_name_size:
+                base_name = f.read(base_name_size).decode()
+                base = read_chunked_store(
+                    osp.join(osp.dirname(path), base_name), size)
+
+        index = [ chunked_store_entry.unpack(
+            f.read(chunked_store_entry.size))
+                  for i in range(num_chunks) ]
+        for i, (offset, comp_size) in enumerate(index):
+            length = min(chunk_size, size - i * chunk_size)
+            base_chunk = next(base) if base else None
+            if offset == chunked_store_in_base:
+                yield base_chunk
+            elif comp_size == 0:
+                yield bytes(bytearray(length))
+            else:
+                f.seek(offset)
+                yield zlib.decompress(f.read(comp_size))
+
+def read_memory_store(path, fmt, size):
+    """Generate the contents of a memory store file in blocks"""
+    if fmt == 'chunked':
+        for chunk in read_chunked_store(path, size):
+            yield chunk
+    else:
+        opener = gzip.open if fmt == 'gzip' else open
+        with opener(path, 'rb') as f:
+            remaining = size
+            while remaining > 0:
+                block = f.read(min(chunked_store_chunk_size, remaining))
+                if not block:
+                    raise IOError("%s is truncated" % path)
+                remaining -= len(block)
+                yield block
+
+def write_memory_store(path, fmt, size, blocks):
+    """Write the contents of a memory store file from blocks"""
+    if fmt == 'gzip':
+        with gzip.open(path, 'wb') as f:
+            for block in blocks:
+                f.write(block)
+    elif fmt == 'raw':
+        # leave the zero blocks as holes to keep the file sparse
+        with open(path, 'wb') as f:
+            for block in blocks:
+                if block.count(b'\0') == len(block):
+                    f.seek(len(block), os.SEEK_CUR)
+                else:
+                    f.write(block)
+            f.truncate(size)
+    elif fmt == 'chunked':
+        num_chunks = (size + chunked_store_chunk_size - 1) // \
+                     chunked_store_chunk_size
+        data_start = chunked_store_header.size + \
+                     num_chunks * chunked_store_entry.size
+        with open(path, 'wb') as f:
+            index = []
+            f.seek(data_start)
+            for chunk in rechunk(blocks, chunked_store_chunk_size):
+                if chunk.count(b'\0') == len(chunk):
+                    index.append((0, 0))
+                else:
+                    data = zlib.compress(chunk, 1)
+                    index.append((f.tell(), len(data)))
+                    f.write(data)
+            f.seek(0)
+            f.write(chunked_store_header.pack(
+                chunked_store_magic, chunked_store_version, size,
+                chunked_store_chunk_size, num_chunks, 0))
+            for entry in index:
+                f.write(chunked_store_entry.pack(*entry))
+    else:
+        raise ValueError("Unknown memory store format %s" % fmt)
+
+def rechunk(blocks, chunk_size):
+    """Regroup blocks of arbitrary sizes in chunks of a fixed size"""
+    pending = b''
+    for block in blocks:
+        pending += block
+        while len(pending) >= chunk_size:
+            yield pending[:chunk_size]
+            pending = pending[chunk_size:]
+    if pending:
+        yield pending
+
+def convert_memory(cpt, cpt_dir, fmt, backup):
+    """Convert all the memory stores of a checkpoint to a new format.
+    The stores of incremental checkpoints are converted to complete
+    stores, note that converting the base of an incremental checkpoint
+    breaks the checkpoints that refer to it."""
+    change = False
+    for sec in cpt.sections():
+        if not cpt.has_option(sec, 'range_size') or \
+           not cpt.get(sec, 'filename').endswith('.pmem'):
+            continue
+
+        old_fmt = cpt.get(sec, 'format') \
+                  if cpt.has_option(sec, 'format') else 'gzip'
+        if old_fmt == fmt:
+            continue
+
+        path = osp.join(cpt_dir, cpt.get(sec, 'filename'))
+        size = cpt.getint(sec, 'range_size')
+        verboseprint("converting", path, "from", old_fmt, "to", fmt)
+
+        tmp_path = path + '.tmp'
+        write_memory_store(tmp_path, fmt, size,
+                           read_memory_store(path, old_fmt, size))
+        if backup:
+            os.rename(path, path + '.bak')
+        os.rename(tmp_path, path)
+
+        cpt.set(sec, 'format', fmt)
+        change = True
+
+    return change
+
 def process_file(path, **kwargs):
     if not osp.isfile(path):
         import errno
@@ -250,6 +392,13 @@ def process_file(path, **kwargs):
 
         to_apply -= ready
 
+    # Convert the memory contents if asked to, this is independent of
+    # the version tags as all the formats can be restored
+    memory_format = kwargs.get('memory_format', None)
+    if memory_format:
+        change |= convert_memory(cpt, osp.dirname(osp.abspath(path)),
+                                 memory_format, kwargs.get('backup', True))
+
     if not change:
         verboseprint("...nothing to do")
         return
@@ -260,6 +409,38 @@ def process_file(path, **kwargs):
     verboseprint("...completed")
     cpt.write(file(path, 'w'))
 
+def process_binary_file(path, **kwargs):
+    """Upgrade a binary checkpoint (m5.cpt.bin) by converting it to
+    text with cpt_binary.py, upgrading the text and converting it back.
+    The entries are all stored as text in the upgraded file."""
+    sys.path.insert(0, osp.dirname(osp.abspath(__file__)))
+    import cpt_binary
+
+    cpt_dir = osp.dirname(osp.abspath(path))
+    text_path = osp.join(cpt_dir, cpt_binary.text_name)
+    if osp.exists(text_path):
+        print("Error: both {} and {} exist in {}, gem5 restores from the "
+              "former".format(cpt_binary.text_name, cpt_binary.binary_name,
+                              cpt_dir))
+        sys.exit(1)
+
+    verboseprint("Converting binary checkpoint %s to text...." % path)
+
+    if kwargs.get('backup', True):
+        import shutil
+        shutil.copyfile(path, path + '.bak')
+
+    try:
+        cpt_binary.convert(cpt_dir, False, True)
+        process_file(text_path, **dict(kwargs, backup=False))
+        cpt_binary.convert(cpt_dir, True, True)
+    except (IOError, OSError, ValueError, struct.error) as e:
+        print("Error: could not convert {}: {}".format(path, e))
+        sys.exit(1)
+    finally:
+        if osp.exists(text_path):
+            os.remove(text_path)
+
 if __name__ == '__main__':
     from optparse import OptionParser, SUPPRESS_HELP
     parser = OptionParser("usage: %prog [options] <filename or directory>")
@@ -271,6 +452,9 @@ if __name__ == '__main__':
                       help="Do no backup each checkpoint before modifying it")
     parser.add_option("-v", "--verbose", action="store_true",
                       help="Print out debugging information as")
+    parser.add_option("--memory-format", choices=["gzip", "raw", "chunked"],
+                      help="Convert the memory contents of each "\
+                           "checkpoint to the given format")
     parser.add_option("--get-cc-file", action="store_true",
                       # used during build; generate src/sim/tags.cc and exit
                       help=SUPPRESS_HELP)
@@ -298,22 +482,30 @@ if __name__ == '__main__':
     path = osp.expandvars(osp.expanduser(args[0]))
 
     # Process a single file if we have it
-    if osp.isfile(path):
+    if osp.isfile(path) and path.endswith('m5.cpt.bin'):
+        process_binary_file(path, **vars(options))
+    elif osp.isfile(path):
         process_file(path, **vars(options))
     # Process an entire directory
     elif osp.isdir(path):
         cpt_file = osp.join(path, 'm5.cpt')
+        cpt_bin_file = osp.join(path, 'm5.cpt.bin')
         if options.recurse:
             # Visit very file and see if it matches
             for root,dirs,files in os.walk(path):
                 for name in files:
                     if name == 'm5.cpt':
                         process_file(osp.join(root,name), **vars(options))
+                    elif name == 'm5.cpt.bin' and 'm5.cpt' not in files:
+                        process_binary_file(osp.join(root,name),
+                                            **vars(options))
                 for dir in dirs:
                     pass
         # Maybe someone passed a cpt.XXXXXXX directory and not m5.cpt
         elif osp.isfile(cpt_file):
             process_file(cpt_file, **vars(options))
+        elif osp.isfile(cpt_bin_file):
+            process_binary_file(cpt_bin_file, **vars(options))
         else:
             print("Error: checkpoint file not found in {} ".format(path))
             print("and recurse not specified")
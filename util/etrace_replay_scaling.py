@@ -0,0 +1,133 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This script measures how the replay of elastic traces by many Trace
+# CPUs scales with the number of host threads. It runs
+# configs/example/etrace_replay.py once per number of replay event
+# queues, each in its own output directory, and reports the host time
+# and the replay throughput in committed micro-ops per host second of
+# every run. The speedup and the accuracy of each run are given
+# relative to a run simulating the whole system on a single event
+# queue, which is always done first. The accuracy is the difference
+# between the simulated ticks of the two runs, and the share of the
+# packets that crossed the event queue bridges after their tick, see
+# EventQueueBridge. For example, to replay the per-core traces of a
+# 64-core system:
+#
+#   etrace_replay_scaling.py -n 64 -t 1,2,4,8,16 \
+#       build/ARM/gem5.opt -- --caches --l2cache \
+#       --inst-trace-file=core%d.inst.proto.gz \
+#       --data-trace-file=core%d.data.proto.gz
+#
+# The options after '--' are passed to etrace_replay.py for every run.
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+def read_stats(path):
+    """Read the first stats dump of a run."""
+    stats = {}
+    stat_re = re.compile(r'^(\S+)\s+([-+0-9.eE]+|nan|inf)\s')
+    with open(path) as f:
+        for line in f:
+            if line.startswith('---------- End Simulation Statistics'):
+                break
+            m = stat_re.match(line)
+            if m:
+                stats[m.group(1)] = float(m.group(2))
+    return stats
+
+def sum_stats(stats, suffix):
+    """Sum the stats whose name ends with a suffix."""
+    return sum(v for k, v in stats.items() if k.endswith(suffix))
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Measure the scaling of parallel elastic trace replay "
+        "with the number of host threads.")
+    parser.add_argument("gem5", help="gem5 binary")
+    parser.add_argument("replay_options", nargs="*",
+                        help="Options passed to etrace_replay.py")
+    parser.add_argument("-n", "--num-cpus", type=int, default=4,
+                        help="Number of Trace CPUs [default: %(default)s]")
+    parser.add_argument("-t", "--threads", default="1,2,4",
+                        help="Comma separated numbers of replay threads "
+                        "[default: %(default)s]")
+    parser.add_argument("-q", "--sim-quantum", default="1us",
+                        help="Simulation quantum [default: %(default)s]")
+    parser.add_argument("-o", "--outdir", default="etrace_scaling",
+                        help="Directory of the output directories of the "
+                        "runs [default: %(default)s]")
+    args = parser.parse_args()
+
+    config = os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                          os.pardir, 'configs', 'example', 'etrace_replay.py')
+
+    # the single event queue run comes first, as the reference
+    threads_list = [ int(t) for t in args.threads.split(',') ]
+    threads_list = [ 0 ] + [ t for t in threads_list if t != 0 ]
+
+    results = []
+    for threads in threads_list:
+        outdir = os.path.join(args.outdir, 'eventqs%d' % threads)
+        cmd = [ args.gem5, '--outdir=%s' % outdir, config,
+                '--cpu-type=TraceCPU', '--num-cpus=%d' % args.num_cpus,
+                '--replay-eventqs=%d' % threads,
+                '--sim-quantum=%s' % args.sim_quantum ] + args.replay_options
+        print("Running", " ".join(cmd))
+        with open(os.devnull, 'w') as devnull:
+            status = subprocess.call(cmd, stdout=devnull)
+        if status != 0:
+            sys.exit("Error: the run with %d replay threads failed" % threads)
+
+        stats = read_stats(os.path.join(outdir, 'stats.txt'))
+        packets = sum_stats(stats, '_bridge.packets')
+        late = sum_stats(stats, '_bridge.latePackets')
+        results.append((threads, stats['host_seconds'], stats['sim_ops'],
+                        stats['sim_ticks'],
+                        late / packets if packets else 0.0))
+
+    base_seconds = results[0][1]
+    base_ticks = results[0][3]
+    print()
+    print("%8s %14s %16s %10s %14s %12s %12s" %
+          ("threads", "host seconds", "ops/host second", "speedup",
+           "sim ticks", "tick error", "late pkts"))
+    for threads, seconds, ops, ticks, late in results:
+        print("%8d %14.2f %16.0f %10.2f %14d %11.2f%% %11.2f%%" %
+              (threads, seconds, ops / seconds, base_seconds / seconds,
+               ticks, 100.0 * (ticks - base_ticks) / base_ticks,
+               100.0 * late))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,306 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# This script runs a sampled simulation of a workload from its
+# SimPoints in a single invocation:
+#
+#  1. A first run of the configuration fast-forwards through the
+#     workload, optionally after restoring a checkpoint, and takes a
+#     checkpoint at the start of the warmup of every SimPoint (see
+#     --take-simpoint-checkpoints in configs/common/Options.py).
+#
+#  2. Every SimPoint is then restored in its own gem5 process, with
+#     up to --jobs processes running at a time, to warm up and measure
+#     its interval with the detailed configuration (see
+#     --restore-simpoint-checkpoint).
+#
+#  3. The stats of the measured intervals are combined into a single
+#     report, weighting every interval by the weight of its SimPoint.
+#
+# For example:
+#
+#   simpoint_sampler.py --simpoints=bench.simpts --weights=bench.weights \
+#       --interval=10000000 --warmup=1000000 -j 8 \
+#       --detailed-args="--cpu-type=DerivO3CPU --caches --l2cache" \
+#       build/X86/gem5.opt configs/example/se.py -c bench
+#
+# The output directory holds the checkpoints and the output of the
+# first run in "checkpoints", along with links to the checkpoints of
+# --restore, the output of every SimPoint in "simpoint_<n>" and the
+# combined stats in "stats.txt".
+
+from __future__ import print_function
+
+import argparse
+import multiprocessing
+import os
+import re
+import shlex
+import subprocess
+import sys
+from multiprocessing.pool import ThreadPool
+
+# Name of the checkpoints taken by takeSimpointCheckpoints() in
+# configs/common/Simulation.py
+cpt_expr = re.compile(r'cpt\.simpoint_(\d+)_inst_(\d+)'
+                      r'_weight_([\d\.e\-]+)_interval_(\d+)_warmup_(\d+)')
+
+begin_marker = '---------- Begin Simulation Statistics ----------'
+end_marker = '---------- End Simulation Statistics   ----------'
+
+class SimPoint(object):
+    def __init__(self, num, cpt):
+        self.num = num
+        self.cpt = cpt
+        match = cpt_expr.match(cpt)
+        self.index = int(match.group(1))
+        self.start_inst = int(match.group(2))
+        self.weight = float(match.group(3))
+        self.outdir = None
+        self.status = None
+        self.stats = None
+
+def gem5_command(args, outdir, extra_args):
+    return [ args.gem5 ] + shlex.split(args.gem5_args) + \
+        [ '--outdir=%s' % outdir, args.config ] + args.config_args + \
+        extra_args
+
+def run(cmd, outdir):
+    """Run gem5 with its output redirected to files in its output
+    directory, and return its exit status."""
+
+    if not os.path.isdir(outdir):
+        os.makedirs(outdir)
+    with open(os.path.join(outdir, 'command'), 'w') as f:
+        f.write(' '.join(cmd) + '\n')
+    with open(os.path.join(outdir, 'simout'), 'w') as out, \
+         open(os.path.join(outdir, 'simerr'), 'w') as err:
+        return subprocess.call(cmd, stdout=out, stderr=err)
+
+def link_restore_checkpoints(restore_dir, cpt_dir):
+    """Link the checkpoints of restore_dir into cpt_dir, as the
+    configuration restores from and takes the SimPoint checkpoints in
+    the same --checkpoint-dir."""
+
+    if not os.path.isdir(cpt_dir):
+        os.makedirs(cpt_dir)
+    for name in os.listdir(restore_dir):
+        if not name.startswith('cpt.') or cpt_expr.match(name):
+            continue
+        link = os.path.join(cpt_dir, name)
+        if not os.path.lexists(link):
+            os.symlink(os.path.abspath(os.path.join(restore_dir, name)),
+                       link)
+
+def take_checkpoints(args, cpt_dir):
+    extra_args = [ '--take-simpoint-checkpoints=%s,%s,%d,%d' %
+                   (os.path.abspath(args.simpoints),
+                    os.path.abspath(args.weights),
+                    args.interval, args.warmup),
+                   '--checkpoint-dir=%s' % cpt_dir ]
+    if args.restore:
+        link_restore_checkpoints(args.restore, cpt_dir)
+        extra_args += [ '--checkpoint-restore=%d' % args.restore_num ]
+    extra_args += shlex.split(args.checkpoint_args)
+
+    print("Taking SimPoint checkpoints in %s" % cpt_dir)
+    status = run(gem5_command(args, cpt_dir, extra_args), cpt_dir)
+    if status != 0:
+        print("Taking checkpoints failed with status %d, see %s" %
+              (status, cpt_dir), file=sys.stderr)
+    return status
+
+def find_simpoints(cpt_dir):
+    # The checkpoints are numbered in the same order as by
+    # findCptDir() in configs/common/Simulation.py
+    cpts = sorted(d for d in os.listdir(cpt_dir) if cpt_expr.match(d))
+    return [ SimPoint(num + 1, cpt) for num, cpt in enumerate(cpts) ]
+
+def read_stats(path):
+    """Read the last dump of a text stats file, which holds the stats
+    of the measured interval, as a list of (name, value, desc)."""
+
+    dumps = []
+    stats = None
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line == begin_marker:
+                stats = []
+            elif line == end_marker:
+                if stats is not None:
+                    dumps.append(stats)
+                stats = None
+            elif stats is not None and line:
+                stat, _, desc = line.partition('#')
+                fields = stat.split()
+                if len(fields) < 2:
+                    continue
+                try:
+                    value = float(fields[1])
+                except ValueError:
+                    continue
+                stats.append((fields[0], value, desc.strip()))
+    return dumps[-1] if dumps else None
+
+def run_simpoint(args, cpt_dir, simpoint):
+    extra_args = [ '--restore-simpoint-checkpoint',
+                   '--checkpoint-dir=%s' % cpt_dir,
+                   '--checkpoint-restore=%d' % simpoint.num ]
+    extra_args += shlex.split(args.detailed_args)
+
+    simpoint.outdir = os.path.join(args.outdir,
+                                   'simpoint_%02d' % simpoint.index)
+    simpoint.status = run(gem5_command(args, simpoint.outdir, extra_args),
+                          simpoint.outdir)
+    stats_file = os.path.join(simpoint.outdir, 'stats.txt')
+    if simpoint.status == 0 and os.path.isfile(stats_file):
+        simpoint.stats = read_stats(stats_file)
+
+    print("SimPoint %d (weight %f) %s" %
+          (simpoint.index, simpoint.weight,
+           "done" if simpoint.stats else
+           "failed with status %d" % simpoint.status))
+    return simpoint
+
+def combine(simpoints):
+    """Compute the weighted average of every stat over the SimPoints
+    that completed, normalizing their weights."""
+
+    total_weight = sum(s.weight for s in simpoints)
+    names = []
+    values = {}
+    descs = {}
+    for s in simpoints:
+        for name, value, desc in s.stats:
+            if name not in values:
+                names.append(name)
+                values[name] = 0.0
+                descs[name] = desc
+            values[name] += value * s.weight / total_weight
+    return [ (name, values[name], descs[name]) for name in names ]
+
+def write_report(path, simpoints, failed, stats):
+    with open(path, 'w') as f:
+        print("# Weighted stats of %d SimPoints" % len(simpoints), file=f)
+        print("# %8s %12s %16s" % ("simpoint", "weight", "start_inst"),
+              file=f)
+        for s in simpoints:
+            print("# %8d %12f %16d" % (s.index, s.weight, s.start_inst),
+                  file=f)
+        for s in failed:
+            print("# SimPoint %d (weight %f) failed, see %s" %
+                  (s.index, s.weight, s.outdir), file=f)
+        print(file=f)
+        print(begin_marker, file=f)
+        for name, value, desc in stats:
+            print("%-40s %20.6f # %s" % (name, value, desc), file=f)
+        print(file=f)
+        print(end_marker, file=f)
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Run a sampled simulation from SimPoints.")
+    parser.add_argument('--simpoints', required=True,
+                        help="SimPoint file generated by SimPoint 3.2")
+    parser.add_argument('--weights', required=True,
+                        help="SimPoint weight file")
+    parser.add_argument('--interval', type=int, required=True,
+                        help="Length of the SimPoint intervals in "
+                        "instructions")
+    parser.add_argument('--warmup', type=int, default=0,
+                        help="Detailed warmup before every interval in "
+                        "instructions [Default: %(default)s]")
+    parser.add_argument('--outdir', default='m5out',
+                        help="Output directory [Default: %(default)s]")
+    parser.add_argument('-j', '--jobs', type=int,
+                        default=multiprocessing.cpu_count(),
+                        help="Number of SimPoints to run in parallel "
+                        "[Default: %(default)s]")
+    parser.add_argument('--restore', metavar='CPT_DIR',
+                        help="Restore a checkpoint from this directory "
+                        "before taking the SimPoint checkpoints")
+    parser.add_argument('--restore-num', type=int, default=1,
+                        help="Checkpoint number to restore, see "
+                        "--checkpoint-restore [Default: %(default)s]")
+    parser.add_argument('--skip-checkpoints', action='store_true',
+                        help="Use the SimPoint checkpoints of a previous "
+                        "invocation")
+    parser.add_argument('--gem5-args', default='',
+                        help="Options of gem5 itself, for all runs")
+    parser.add_argument('--checkpoint-args', default='',
+                        help="Configuration options for taking the "
+                        "checkpoints")
+    parser.add_argument('--detailed-args', default='',
+                        help="Configuration options for running the "
+                        "SimPoints")
+    parser.add_argument('gem5', help="gem5 binary")
+    parser.add_argument('config', help="Configuration script")
+    parser.add_argument('config_args', nargs=argparse.REMAINDER,
+                        help="Configuration options for all runs")
+    args = parser.parse_args()
+
+    args.outdir = os.path.abspath(args.outdir)
+    cpt_dir = os.path.join(args.outdir, 'checkpoints')
+    if not args.skip_checkpoints:
+        status = take_checkpoints(args, cpt_dir)
+        if status != 0:
+            sys.exit(status)
+
+    simpoints = find_simpoints(cpt_dir)
+    if not simpoints:
+        print("No SimPoint checkpoints found in %s" % cpt_dir,
+              file=sys.stderr)
+        sys.exit(1)
+    print("Running %d SimPoints, %d at a time" %
+          (len(simpoints), args.jobs))
+
+    # The work is done by the gem5 processes, so threads are enough to
+    # wait for them.
+    pool = ThreadPool(max(args.jobs, 1))
+    simpoints = pool.map(lambda s: run_simpoint(args, cpt_dir, s),
+                         simpoints, chunksize=1)
+    pool.close()
+    pool.join()
+
+    done = [ s for s in simpoints if s.stats ]
+    failed = [ s for s in simpoints if not s.stats ]
+    if not done:
+        print("No SimPoint completed", file=sys.stderr)
+        sys.exit(1)
+
+    report = os.path.join(args.outdir, 'stats.txt')
+    write_report(report, done, failed, combine(done))
+    print("Weighted stats of %d SimPoints written to %s" %
+          (len(done), report))
+    if failed:
+        print("%d SimPoints failed" % len(failed), file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
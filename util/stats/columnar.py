@@ -0,0 +1,289 @@
+#!/usr/bin/env python
+#
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Reader for the binary, columnar stats files written by the
+# columnar:// stat output (src/base/stats/columnar.hh).
+#
+# As a module:
+#   reader = ColumnarStats('m5out/stats.bin')
+#   for dump in reader:
+#       print(dump.index, dump['system.cpu.numCycles'])
+#   ticks = reader.series('sim_ticks')
+#
+# From the command line, it lists the stats in a file, or prints the
+# time series of some of them as CSV.
+
+from __future__ import print_function
+
+import argparse
+import array
+import struct
+import sys
+import zlib
+
+magic = b'gem5stcl'
+version = 1
+compressed_flag = 0x1
+
+SCHEMA_RECORD = b'S'
+DATA_RECORD = b'D'
+COMPRESSED_DATA_RECORD = b'Z'
+
+KINDS = ('scalar', 'vector', 'dist', 'vector_dist', 'vector2d', 'formula')
+DIST_TYPES = ('deviation', 'dist', 'hist', 'hdr')
+
+# Number of values stored for a distribution before its buckets
+DIST_FIELDS = ('samples', 'sum', 'squares', 'logs', 'min_val', 'max_val',
+               'underflow', 'overflow')
+
+file_header = struct.Struct('=8sII')
+record_header = struct.Struct('=cQ')
+
+try:
+    _uint64 = array.array('Q').typecode
+except ValueError:
+    # Python 2 on LP64 hosts
+    _uint64 = 'L'
+
+def _array(typecode, data):
+    values = array.array(typecode)
+    if hasattr(values, 'frombytes'):
+        values.frombytes(data)
+    else:
+        # Python 2
+        values.fromstring(data)
+    return values
+
+def _bytes(values):
+    if hasattr(values, 'tobytes'):
+        return values.tobytes()
+    else:
+        # Python 2
+        return values.tostring()
+
+class Stat(object):
+    """Description of a stat in a schema"""
+
+    def __init__(self, name, kind, num_values, desc, subnames, y_subnames,
+                 x, y, dist_type, dist_min, dist_max, bucket_size, offset):
+        self.name = name
+        self.kind = kind
+        self.num_values = num_values
+        self.desc = desc
+        self.subnames = subnames
+        self.y_subnames = y_subnames
+        self.x = x
+        self.y = y
+        self.dist_type = dist_type
+        self.min = dist_min
+        self.max = dist_max
+        self.bucket_size = bucket_size
+        # Position of the first value of the stat in a dump
+        self.offset = offset
+
+    def values(self, dump_values):
+        """Extract the values of this stat from the values of a dump
+
+        Scalars are returned as a number, vectors and formulas as a
+        list, 2d vectors as a list of rows, distributions as a dict of
+        their fields and a 'buckets' list, and vector distributions as
+        a list of such dicts.
+
+        """
+        values = dump_values[self.offset:self.offset + self.num_values]
+        if self.kind == 'scalar':
+            return values[0]
+        elif self.kind == 'vector2d':
+            return [ values[i * self.y:(i + 1) * self.y]
+                     for i in range(self.x) ]
+        elif self.kind == 'dist':
+            return self._dist(values)
+        elif self.kind == 'vector_dist':
+            size = len(values) // self.x if self.x else 0
+            return [ self._dist(values[i * size:(i + 1) * size])
+                     for i in range(self.x) ]
+        else:
+            return list(values)
+
+    @staticmethod
+    def _dist(values):
+        dist = dict(zip(DIST_FIELDS, values))
+        dist['buckets'] = list(values[len(DIST_FIELDS):])
+        return dist
+
+class Dump(object):
+    """Values of all the stats in a stat dump"""
+
+    def __init__(self, index, schema, values):
+        self.index = index
+        self.schema = schema
+        self.raw_values = values
+
+    def __contains__(self, name):
+        return name in self.schema
+
+    def __getitem__(self, name):
+        return self.schema[name].values(self.raw_values)
+
+    def stats(self):
+        return self.schema.keys()
+
+class ColumnarStats(object):
+    """Reader of a columnar stats file"""
+
+    def __init__(self, filename):
+        self.filename = filename
+        with open(filename, 'rb') as f:
+            header = f.read(file_header.size)
+        if len(header) < file_header.size:
+            raise ValueError('%s is too short' % filename)
+        file_magic, file_version, self.flags = file_header.unpack(header)
+        if file_magic != magic:
+            raise ValueError('%s is not a columnar stats file' % filename)
+        if file_version != version:
+            raise ValueError('%s has unsupported version %d' % \
+                             (filename, file_version))
+
+    def __iter__(self):
+        """Iterate over the dumps in the file"""
+
+        schema = {}
+        prev = None
+        with open(self.filename, 'rb') as f:
+            f.seek(file_header.size)
+            while True:
+                header = f.read(record_header.size)
+                if len(header) < record_header.size:
+                    # the end of the file, or a dump being written
+                    break
+                type, size = record_header.unpack(header)
+                payload = f.read(size)
+                if len(payload) < size:
+                    break
+
+                if type == SCHEMA_RECORD:
+                    schema = self._parse_schema(payload)
+                    prev = None
+                elif type == DATA_RECORD:
+                    index, = struct.unpack_from('=Q', payload)
+                    yield Dump(index, schema, _array('d', payload[8:]))
+                elif type == COMPRESSED_DATA_RECORD:
+                    index, raw_size = struct.unpack_from('=QQ', payload)
+                    raw = zlib.decompress(payload[16:])
+                    if len(raw) != raw_size:
+                        raise ValueError('corrupted dump %d' % index)
+                    # undo the XOR with the previous dump
+                    delta = _array(_uint64, raw)
+                    if prev is not None:
+                        for i in range(len(delta)):
+                            delta[i] ^= prev[i]
+                    prev = delta
+                    yield Dump(index, schema, _array('d', _bytes(delta)))
+                else:
+                    raise ValueError('unknown record type %r' % type)
+
+    def series(self, name):
+        """Return the values of a stat in every dump as a list of
+        (dump index, values) tuples. Dumps without the stat are
+        skipped."""
+
+        return [ (dump.index, dump[name]) for dump in self if name in dump ]
+
+    @staticmethod
+    def _parse_schema(payload):
+        pos = [0]
+
+        def unpack(fmt):
+            values = struct.unpack_from(fmt, payload, pos[0])
+            pos[0] += struct.calcsize(fmt)
+            return values if len(values) > 1 else values[0]
+
+        def string():
+            size = unpack('=I')
+            value = payload[pos[0]:pos[0] + size].decode('utf-8')
+            pos[0] += size
+            return value
+
+        def strings():
+            return [ string() for i in range(unpack('=I')) ]
+
+        schema = {}
+        offset = 0
+        for i in range(unpack('=I')):
+            name = string()
+            kind = KINDS[unpack('=B')]
+            num_values = unpack('=I')
+            desc = string()
+            subnames = strings()
+            y_subnames = strings()
+            x, y, dist_type, dist_min, dist_max, bucket_size = \
+                unpack('=IIBddd')
+            schema[name] = Stat(name, kind, num_values, desc, subnames,
+                                y_subnames, x, y, DIST_TYPES[dist_type],
+                                dist_min, dist_max, bucket_size, offset)
+            offset += num_values
+        return schema
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Read a columnar stats file. Without stat names, '
+                    'list the stats in the last schema of the file.')
+    parser.add_argument('file', help='columnar stats file')
+    parser.add_argument('stats', nargs='*',
+                        help='names of the stats to print as CSV, one '
+                             'row per dump')
+    args = parser.parse_args()
+
+    try:
+        reader = ColumnarStats(args.file)
+        if not args.stats:
+            schema = {}
+            for dump in reader:
+                schema = dump.schema
+            for stat in sorted(schema.values(), key=lambda s: s.offset):
+                print('%-60s %-12s %d' % \
+                      (stat.name, stat.kind, stat.num_values))
+            return
+
+        print(','.join([ 'dump' ] + args.stats))
+        for dump in reader:
+            row = [ str(dump.index) ]
+            for name in args.stats:
+                if name not in dump:
+                    row.append('')
+                    continue
+                values = dump.raw_values[dump.schema[name].offset:
+                    dump.schema[name].offset + dump.schema[name].num_values]
+                row.append(' '.join(repr(v) for v in values))
+            print(','.join(row))
+    except (IOError, ValueError, struct.error, zlib.error) as e:
+        print('Error: %s' % e, file=sys.stderr)
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()